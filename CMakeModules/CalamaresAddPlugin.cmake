@@ -28,6 +28,9 @@
 #   [COMPILE_DEFINITIONS def...]
 #   [RESOURCES resource-file]
 #   [REQUIRES module-name...]
+#   [AFTER module-name...]
+#   [INPUTS resource...]
+#   [OUTPUTS resource...]
 #   [NO_INSTALL]
 #   [NO_CONFIG]
 #   [SHARED_LIB]
@@ -46,6 +49,10 @@
 #       One or more names of modules which are added to the *requiredModules*
 #       key in the descriptor. See *Module Requirements* in the module
 #       documentation.
+#  - AFTER, INPUTS, OUTPUTS
+#       Scheduling information, added to the *after*, *inputs* and *outputs*
+#       keys in the descriptor. See *Job Scheduling* in the module
+#       documentation.
 #  - NO_INSTALL
 #       If this is set, the module is not installed by default; use this to
 #       build testing modules or unit-testing modules.
@@ -59,6 +66,11 @@
 #       If this is set, writes an explicit weight into the module.desc;
 #       module weights are used in progress reporting.
 #
+# With BUILD_STATIC_MODULES, the plugin is built as a static library
+# (regardless of SHARED_LIB) to be linked into the calamares executable,
+# unless STATIC_MODULES is set and does not list the module. The static
+# modules are collected in global properties, see src/calamares.
+#
 
 include( CMakeParseArguments )
 include( CalamaresAddLibrary  )
@@ -69,7 +81,7 @@ function( calamares_add_plugin )
     set( NAME ${ARGV0} )
     set( options NO_CONFIG NO_INSTALL SHARED_LIB EMERGENCY )
     set( oneValueArgs NAME TYPE EXPORT_MACRO RESOURCES WEIGHT )
-    set( multiValueArgs SOURCES UI LINK_LIBRARIES LINK_PRIVATE_LIBRARIES COMPILE_DEFINITIONS REQUIRES )
+    set( multiValueArgs SOURCES UI LINK_LIBRARIES LINK_PRIVATE_LIBRARIES COMPILE_DEFINITIONS REQUIRES AFTER INPUTS OUTPUTS )
     cmake_parse_arguments( PLUGIN "${options}" "${oneValueArgs}" "${multiValueArgs}" ${ARGN} )
     set( PLUGIN_NAME ${NAME} )
     set( PLUGIN_DESTINATION ${CMAKE_INSTALL_LIBDIR}/calamares/modules/${PLUGIN_NAME} )
@@ -80,6 +92,14 @@ function( calamares_add_plugin )
     set( CMAKE_LIBRARY_OUTPUT_DIRECTORY "${CMAKE_CURRENT_BINARY_DIR}" )
     set( CMAKE_ARCHIVE_OUTPUT_DIRECTORY "${CMAKE_CURRENT_BINARY_DIR}" )
 
+    set( _static OFF )
+    if( BUILD_STATIC_MODULES )
+        string( REPLACE " " ";" _static_list "${STATIC_MODULES}" )
+        if( NOT _static_list OR PLUGIN_NAME IN_LIST _static_list )
+            set( _static ON )
+        endif()
+    endif()
+
     message( "-- ${BoldYellow}Found ${CALAMARES_APPLICATION_NAME} module: ${BoldRed}${PLUGIN_NAME}${ColorReset}" )
     message( "   ${Green}TYPE:${ColorReset} ${PLUGIN_TYPE}" )
     message( "   ${Green}LINK_LIBRARIES:${ColorReset} ${PLUGIN_LINK_LIBRARIES}" )
@@ -107,13 +127,30 @@ function( calamares_add_plugin )
     if( PLUGIN_RESOURCES )
         message( "   ${Green}RESOURCES:${ColorReset} ${PLUGIN_RESOURCES}" )
     endif()
+    if( _static )
+        message( "   ${Green}STATIC:${ColorReset} linked into ${CALAMARES_APPLICATION_NAME}" )
+    endif()
     message( "" )
 
     # create target name once for convenience
     set( target "calamares_${PLUGIN_TYPE}_${PLUGIN_NAME}" )
 
     # determine target type
-    if( NOT ${PLUGIN_SHARED_LIB} )
+    if( _static )
+        set( target_type "STATIC" )
+        string( MAKE_C_IDENTIFIER "${PLUGIN_NAME}" _static_id )
+        list( APPEND PLUGIN_COMPILE_DEFINITIONS
+            QT_STATICPLUGIN
+            CALAMARES_STATIC_MODULE=${_static_id}
+            "CALAMARES_STATIC_MODULE_NAME=\"${PLUGIN_NAME}\""
+        )
+        set_property( GLOBAL APPEND PROPERTY CALAMARES_STATIC_MODULE_TARGETS ${target} )
+        set_property( GLOBAL APPEND PROPERTY CALAMARES_STATIC_MODULE_IDS ${_static_id} )
+        if( PLUGIN_RESOURCES )
+            get_filename_component( _resource ${PLUGIN_RESOURCES} NAME_WE )
+            set_property( GLOBAL APPEND PROPERTY CALAMARES_STATIC_MODULE_RESOURCES ${_resource} )
+        endif()
+    elseif( NOT ${PLUGIN_SHARED_LIB} )
         set( target_type "MODULE" )
     else()
         set( target_type "SHARED" )
@@ -142,7 +179,7 @@ function( calamares_add_plugin )
         list( APPEND calamares_add_library_args "COMPILE_DEFINITIONS" ${PLUGIN_COMPILE_DEFINITIONS} )
     endif()
 
-    if ( PLUGIN_NO_INSTALL )
+    if ( PLUGIN_NO_INSTALL OR _static )
         list( APPEND calamares_add_library_args "NO_INSTALL" )
     endif()
 
@@ -163,13 +200,25 @@ function( calamares_add_plugin )
         set( _file ${CMAKE_CURRENT_BINARY_DIR}/${PLUGIN_DESC_FILE} )
         set( _type ${PLUGIN_TYPE} )
         file( WRITE  ${_file} "# AUTO-GENERATED metadata file\n# Syntax is YAML 1.2\n---\n" )
-        file( APPEND ${_file} "type: \"${_type}\"\nname: \"${PLUGIN_NAME}\"\ninterface: \"qtplugin\"\nload: \"lib${target}.so\"\n" )
+        file( APPEND ${_file} "type: \"${_type}\"\nname: \"${PLUGIN_NAME}\"\ninterface: \"qtplugin\"\n" )
+        if ( NOT _static )
+            file( APPEND ${_file} "load: \"lib${target}.so\"\n" )
+        endif()
         if ( PLUGIN_REQUIRES )
             file( APPEND ${_file} "requiredModules:\n" )
             foreach( _r ${PLUGIN_REQUIRES} )
                 file( APPEND ${_file} " - ${_r}\n" )
             endforeach()
         endif()
+        foreach( _key AFTER INPUTS OUTPUTS )
+            if ( PLUGIN_${_key} )
+                string( TOLOWER ${_key} _desc_key )
+                file( APPEND ${_file} "${_desc_key}:\n" )
+                foreach( _r ${PLUGIN_${_key}} )
+                    file( APPEND ${_file} " - \"${_r}\"\n" )
+                endforeach()
+            endif()
+        endforeach()
         if ( PLUGIN_EMERGENCY )
             file( APPEND ${_file} "emergency: true\n" )
         endif()
@@ -0,0 +1,101 @@
+#! /bin/sh
+
+### LICENSE
+# === This file is part of Calamares - <https://calamares.io> ===
+#
+#   SPDX-FileCopyrightText: 2026 agent <agent@local>
+#   SPDX-License-Identifier: BSD-2-Clause
+#
+#   This file is Free Software: you can redistribute it and/or modify
+#   it under the terms of the 2-clause BSD License.
+#
+### END LICENSE
+
+### USAGE
+#
+# Measures how long Calamares takes to start. The calamares executable
+# from a build directory is run a number of times, on the offscreen
+# Qt platform, with a fixed settings.conf and an empty cache directory
+# (so there is no YAML cache from an earlier run). Calamares quits as
+# soon as the first page is shown (--exit-after-startup).
+#
+# Normal use, from a build directory:
+#   $ make benchmark-startup
+# or directly:
+#   $ sh ci/startup-benchmark.sh [-n <runs>] [-s <settings.conf>] <build-dir>
+#
+# The default is 10 runs, with the settings.conf from the source
+# directory. Add --drop-caches (as root) to drop the kernel's page
+# cache before each run, too. The wall-clock time of each run is
+# reported, as well as the startup time that Calamares measured itself;
+# -o <file> keeps the startup timing (phase by phase) of the last run.
+#
+### END USAGE
+
+D=`dirname "$0"`
+N=10
+SETTINGS="$D/../settings.conf"
+OUTPUT=""
+DROP_CACHES=false
+
+while test $# -gt 0 ; do
+	case "$1" in
+		-n) N="$2" ; shift 2 ;;
+		-s) SETTINGS="$2" ; shift 2 ;;
+		-o) OUTPUT="$2" ; shift 2 ;;
+		--drop-caches) DROP_CACHES=true ; shift ;;
+		-*) echo "! Unknown option $1" ; exit 1 ;;
+		*) break ;;
+	esac
+done
+
+BUILD="$1"
+test -n "$BUILD" || { echo "! Usage: $0 [-n <runs>] [-s <settings.conf>] [-o <file>] <build-dir>" ; exit 1 ; }
+test -x "$BUILD/calamares" || { echo "! No calamares executable in $BUILD" ; exit 1 ; }
+test -d "$BUILD/src" || { echo "! No src/ (modules, branding) in $BUILD" ; exit 1 ; }
+test -f "$SETTINGS" || { echo "! No settings file $SETTINGS" ; exit 1 ; }
+test "$N" -gt 0 2>/dev/null || { echo "! Bad number of runs $N" ; exit 1 ; }
+
+BUILD=`cd "$BUILD" && pwd`
+SETTINGS=`cd \`dirname "$SETTINGS"\` && pwd`/`basename "$SETTINGS"`
+
+# With -d, Calamares reads settings.conf from the current directory,
+# and branding, QML and modules from src/ in the current directory.
+WORK=`mktemp -d -t calamares-startup.XXXXXX` || exit 1
+trap 'rm -rf "$WORK"' EXIT
+ln -s "$SETTINGS" "$WORK/settings.conf"
+ln -s "$BUILD/src" "$WORK/src"
+
+TIMES=""
+i=0
+while test $i -lt "$N" ; do
+	i=$(( i + 1 ))
+	rm -rf "$WORK/cache"
+	mkdir "$WORK/cache"
+	if $DROP_CACHES ; then
+		sync
+		echo 3 > /proc/sys/vm/drop_caches || { echo "! Can not drop caches (not root?)" ; exit 1 ; }
+	fi
+
+	START=`date +%s%N`
+	( cd "$WORK" && XDG_CACHE_HOME="$WORK/cache" QT_QPA_PLATFORM=offscreen \
+		"$BUILD/calamares" -d --exit-after-startup > "$WORK/output" 2>&1 ) || {
+		echo "! Run $i failed:"
+		tail -n 20 "$WORK/output"
+		exit 1
+	}
+	END=`date +%s%N`
+
+	STARTUP_FILE="$WORK/cache/calamares/session-startup.json"
+	TOTAL=`grep -o '"total":[0-9]*' "$STARTUP_FILE" 2>/dev/null | cut -d: -f2`
+	test -n "$TOTAL" || { echo "! Run $i did not write $STARTUP_FILE" ; exit 1 ; }
+
+	WALL=$(( ( END - START ) / 1000000 ))
+	echo "Run $i: ${WALL}ms (Calamares measured $(( TOTAL / 1000 ))ms)"
+	TIMES="$TIMES $WALL"
+	test -n "$OUTPUT" && cp "$STARTUP_FILE" "$OUTPUT"
+done
+
+echo $TIMES | tr ' ' '\n' | sort -n | awk '
+	{ t[NR] = $1 ; sum += $1 }
+	END { printf "Cold start over %d runs: min %dms, median %dms, mean %.0fms, max %dms\n", NR, t[1], t[int((NR + 1) / 2)], sum / NR, t[NR] }'
@@ -5,6 +5,7 @@
 #
 # Travis CI script for use on every-commit:
 #  - build and install Calamares
+#  - build Calamares again with the C++ modules linked in
 #
 test -n "$BUILDDIR" || { echo "! \$BUILDDIR not set" ; exit 1 ; }
 test -n "$SRCDIR" || { echo "! \$SRCDIR not set" ; exit 1 ; }
@@ -56,3 +57,14 @@ section "Install results"
 install_debugging "$DESTDIR"
 
 $result || { echo "! Install failed" ; exit 1 ; } # Result of make install, above
+
+# Linking the modules into the executable is a separate build, in
+# a directory of its own. All the C++ modules are linked in.
+STATIC_BUILDDIR="$BUILDDIR/static-modules"
+mkdir -p "$STATIC_BUILDDIR" && cd "$STATIC_BUILDDIR" || exit 1
+
+section "cmake (static modules)"
+cmake $CMAKE_ARGS -DBUILD_STATIC_MODULES=ON $SRCDIR || { echo "! CMake (static modules) failed" ; exit 1 ; }
+
+section "make (static modules)"
+make -j2 || { echo "! Make (static modules) failed" ; exit 1 ; }
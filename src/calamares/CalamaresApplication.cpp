@@ -27,10 +27,14 @@
 #include "utils/Qml.h"
 #endif
 #include "utils/Retranslator.h"
+#include "utils/TargetHelper.h"
+#include "utils/Trace.h"
+#include "utils/YamlCache.h"
 #include "viewpages/ViewStep.h"
 
 #include <QDesktopWidget>
 #include <QDir>
+#include <QEvent>
 #include <QFileInfo>
 #include <QScreen>
 #include <QTimer>
@@ -69,22 +73,29 @@ CalamaresApplication::init()
     cDebug() << "Calamares version:" << CALAMARES_VERSION;
     cDebug() << Logger::SubEntry
              << "        languages:" << QString( CALAMARES_TRANSLATION_LANGUAGES ).replace( ";", ", " );
-
     if ( !Calamares::Settings::instance() )
     {
         cError() << "Must create Calamares::Settings before the application.";
         ::exit( 1 );
     }
+    // Module descriptors and configuration, from the image or from the last run
+    CalamaresUtils::YamlCache::setCacheFile( CalamaresUtils::appLogDir().filePath( "config.cache" ),
+                                             Calamares::Settings::instance()->configCache() );
+    qint64 start = CalamaresUtils::Trace::now();
     initQmlPath();
+    CalamaresUtils::Trace::startupPhase( QStringLiteral( "qml path" ), start );
+    start = CalamaresUtils::Trace::now();
     initBranding();
+    CalamaresUtils::Trace::startupPhase( QStringLiteral( "branding" ), start );
 
+    start = CalamaresUtils::Trace::now();
     CalamaresUtils::installTranslator( QLocale::system(), QString() );
+    CalamaresUtils::Trace::startupPhase( QStringLiteral( "translations" ), start );
 
     setQuitOnLastWindowClosed( false );
     setWindowIcon( QIcon( Calamares::Branding::instance()->imagePath( Calamares::Branding::ProductIcon ) ) );
 
-    cDebug() << Logger::SubEntry << "STARTUP: initSettings, initQmlPath, initBranding done";
-
+    m_moduleInitStart = CalamaresUtils::Trace::now();
     initModuleManager();  //also shows main window
 
     cDebug() << Logger::SubEntry << "STARTUP: initModuleManager: module init started";
@@ -245,15 +256,19 @@ centerWindowOnScreen( QWidget* w )
 void
 CalamaresApplication::initView()
 {
-    cDebug() << "STARTUP: initModuleManager: all modules init done";
+    CalamaresUtils::Trace::startupPhase( QStringLiteral( "module discovery" ), m_moduleInitStart );
+    qint64 start = CalamaresUtils::Trace::now();
     initJobQueue();
-    cDebug() << "STARTUP: initJobQueue done";
+    CalamaresUtils::Trace::startupPhase( QStringLiteral( "job queue" ), start );
 
+    start = CalamaresUtils::Trace::now();
     m_mainwindow = new CalamaresWindow();  //also creates ViewManager
+    CalamaresUtils::Trace::startupPhase( QStringLiteral( "main window" ), start );
 
     connect( m_moduleManager, &Calamares::ModuleManager::modulesLoaded, this, &CalamaresApplication::initViewSteps );
     connect( m_moduleManager, &Calamares::ModuleManager::modulesFailed, this, &CalamaresApplication::initFailed );
 
+    m_moduleLoadStart = CalamaresUtils::Trace::now();
     QTimer::singleShot( 0, m_moduleManager, &Calamares::ModuleManager::loadModules );
 
     if ( Calamares::Branding::instance() && Calamares::Branding::instance()->windowPlacementCentered() )
@@ -267,8 +282,15 @@ CalamaresApplication::initView()
 void
 CalamaresApplication::initViewSteps()
 {
-    cDebug() << "STARTUP: loadModules for all modules done";
+    CalamaresUtils::Trace::startupPhase( QStringLiteral( "module loading" ), m_moduleLoadStart );
+    m_requirementsStart = CalamaresUtils::Trace::now();
+    connect( m_moduleManager,
+             &Calamares::ModuleManager::requirementsComplete,
+             this,
+             &CalamaresApplication::requirementsChecked );
     m_moduleManager->checkRequirements();
+
+    watchFirstPaint();
     if ( Calamares::Branding::instance()->windowMaximize() )
     {
         m_mainwindow->setWindowFlag( Qt::FramelessWindowHint );
@@ -282,19 +304,90 @@ CalamaresApplication::initViewSteps()
     cDebug() << "STARTUP: Window now visible and ProgressTreeView populated";
     cDebug() << Logger::SubEntry << Calamares::ViewManager::instance()->viewSteps().count() << "view steps loaded.";
     Calamares::ViewManager::instance()->onInitComplete();
+    CalamaresUtils::YamlCache::save();
 }
 
 void
 CalamaresApplication::initFailed( const QStringList& l )
 {
     cError() << "STARTUP: failed modules are" << l;
+    watchFirstPaint();
     m_mainwindow->show();
 }
 
+void
+CalamaresApplication::requirementsChecked()
+{
+    if ( m_requirementsStart < 0 )
+    {
+        // Checked again, later on
+        return;
+    }
+    CalamaresUtils::Trace::startupPhase( QStringLiteral( "requirements" ), m_requirementsStart );
+    m_requirementsStart = -1;
+    if ( m_showStart < 0 )
+    {
+        startupDone();
+    }
+}
+
+void
+CalamaresApplication::watchFirstPaint()
+{
+    m_showStart = CalamaresUtils::Trace::now();
+    m_mainwindow->installEventFilter( this );
+}
+
+bool
+CalamaresApplication::eventFilter( QObject* watched, QEvent* event )
+{
+    if ( watched == m_mainwindow && event->type() == QEvent::Paint && m_showStart >= 0 )
+    {
+        m_mainwindow->removeEventFilter( this );
+        // The paint event comes before the painting; once the event
+        // loop gets around to the timer, the page is on screen.
+        QTimer::singleShot( 0, this, [this]() {
+            CalamaresUtils::Trace::startupPhase( QStringLiteral( "first paint" ), m_showStart );
+            m_showStart = -1;
+            if ( m_requirementsStart < 0 )
+            {
+                startupDone();
+            }
+        } );
+    }
+    return QApplication::eventFilter( watched, event );
+}
+
+void
+CalamaresApplication::startupDone()
+{
+    QStringList phases;
+    for ( const auto& p : CalamaresUtils::Trace::startupPhases() )
+    {
+        phases << QStringLiteral( "%1: %2 ms" ).arg( p.name ).arg( p.duration / 1000.0, 0, 'f', 1 );
+    }
+    cDebug() << "STARTUP: done after" << CalamaresUtils::Trace::now() / 1000 << "ms"
+             << Logger::DebugList( phases );
+    CalamaresUtils::Trace::saveStartup();
+    CalamaresUtils::Trace::save();
+
+    if ( m_exitAfterStartup )
+    {
+        cDebug() << Logger::SubEntry << "Quitting after startup, as requested.";
+        QTimer::singleShot( 0, this, &QCoreApplication::quit );
+    }
+}
+
 void
 CalamaresApplication::initJobQueue()
 {
     Calamares::JobQueue* jobQueue = new Calamares::JobQueue( this );
+    jobQueue->setMaximumParallelJobs( Calamares::Settings::instance()->parallelJobs() );
+    jobQueue->setResumeFromCheckpoint( m_resume );
     new CalamaresUtils::System( Calamares::Settings::instance()->doChroot(), this );
+    if ( Calamares::Settings::instance()->targetHelper() )
+    {
+        CalamaresUtils::TargetHelper::setPath( CalamaresUtils::TargetHelper::defaultPath() );
+    }
     Calamares::Branding::instance()->setGlobals( jobQueue->globalStorage() );
 }
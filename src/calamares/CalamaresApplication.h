@@ -45,10 +45,28 @@ public:
      */
     CalamaresWindow* mainWindow();
 
+    /** @brief Continue a failed installation when the jobs run
+     *
+     * Call this before init(); see JobQueue::setResumeFromCheckpoint().
+     */
+    void setResumeFromCheckpoint( bool resume ) { m_resume = resume; }
+
+    /** @brief Quit once startup is done
+     *
+     * Startup is done when the first page has been painted and the
+     * requirements have been checked. The startup timing is written
+     * either way, see CalamaresUtils::Trace::saveStartup().
+     */
+    void setExitAfterStartup( bool exit ) { m_exitAfterStartup = exit; }
+
+protected:
+    bool eventFilter( QObject* watched, QEvent* event ) override;
+
 private slots:
     void initView();
     void initViewSteps();
     void initFailed( const QStringList& l );
+    void requirementsChecked();
 
 private:
     // Initialization steps happen in this order
@@ -56,9 +74,20 @@ private:
     void initBranding();
     void initModuleManager();
     void initJobQueue();
+    /// @brief Call before showing the main window, to time the first paint
+    void watchFirstPaint();
+    void startupDone();
 
     CalamaresWindow* m_mainwindow;
     Calamares::ModuleManager* m_moduleManager;
+    bool m_resume = false;
+    bool m_exitAfterStartup = false;
+
+    // Start times (from Trace::now()) of startup phases in progress, or -1
+    qint64 m_moduleInitStart = -1;
+    qint64 m_moduleLoadStart = -1;
+    qint64 m_requirementsStart = -1;
+    qint64 m_showStart = -1;
 };
 
 #endif  // CALAMARESAPPLICATION_H
@@ -15,6 +15,7 @@
 #include "utils/Dirs.h"
 #include "utils/Logger.h"
 #include "utils/Retranslator.h"
+#include "utils/Trace.h"
 
 #ifndef WITH_KF5DBus
 #warning "KDSingleApplicationGuard is deprecated"
@@ -79,6 +80,10 @@ handle_args( CalamaresApplication& a )
     QCommandLineOption configOption(
         QStringList { "c", "config" }, "Configuration directory to use, for testing purposes.", "config" );
     QCommandLineOption xdgOption( QStringList { "X", "xdg-config" }, "Use XDG_{CONFIG,DATA}_DIRS as well." );
+    QCommandLineOption resumeOption( QStringList { "r", "resume" },
+                                     "Continue a failed installation from the last job that succeeded." );
+    QCommandLineOption exitOption( QStringLiteral( "exit-after-startup" ),
+                                   "Quit once the first page is shown, for measuring startup time." );
 
     QCommandLineParser parser;
     parser.setApplicationDescription( "Distribution-independent installer framework" );
@@ -90,6 +95,8 @@ handle_args( CalamaresApplication& a )
     parser.addOption( configOption );
     parser.addOption( xdgOption );
     parser.addOption( debugTxOption );
+    parser.addOption( resumeOption );
+    parser.addOption( exitOption );
 
     parser.process( a );
 
@@ -103,6 +110,8 @@ handle_args( CalamaresApplication& a )
         CalamaresUtils::setXdgDirs();
     }
     CalamaresUtils::setAllowLocalTranslation( parser.isSet( debugOption ) || parser.isSet( debugTxOption ) );
+    a.setResumeFromCheckpoint( parser.isSet( resumeOption ) );
+    a.setExitAfterStartup( parser.isSet( exitOption ) );
 
     return parser.isSet( debugOption );
 }
@@ -110,7 +119,10 @@ handle_args( CalamaresApplication& a )
 int
 main( int argc, char* argv[] )
 {
+    // Startup timing is relative to this
+    const qint64 applicationStart = CalamaresUtils::Trace::now();
     CalamaresApplication a( argc, argv );
+    CalamaresUtils::Trace::startupPhase( QStringLiteral( "application" ), applicationStart );
 
     KAboutData aboutData( "calamares",
                           "Calamares",
@@ -156,7 +168,9 @@ main( int argc, char* argv[] )
     }
 #endif
 
+    const qint64 settingsStart = CalamaresUtils::Trace::now();
     Calamares::Settings::init( is_debug );
+    CalamaresUtils::Trace::startupPhase( QStringLiteral( "settings" ), settingsStart );
     if ( !Calamares::Settings::instance() || !Calamares::Settings::instance()->isValid() )
     {
         qCritical() << "Calamares has invalid settings, shutting down.";
@@ -24,47 +24,169 @@ using CalamaresUtils::operator""_MiB;
 namespace Calamares
 {
 
-class GlobalStorage::ReadLock : public QMutexLocker
-{
-public:
-    ReadLock( const GlobalStorage* gs )
-        : QMutexLocker( &gs->m_mutex )
-    {
-    }
-};
-
+/** @brief Serializes writers, and publishes the changes
+ *
+ * Writers modify the copy of the data in the lock, which is
+ * published as a new snapshot when the lock is released. The
+ * signals are emitted after the mutex is unlocked, so that
+ * slots may modify the store again.
+ */
 class GlobalStorage::WriteLock : public QMutexLocker
 {
 public:
     WriteLock( GlobalStorage* gs )
         : QMutexLocker( &gs->m_mutex )
         , m_gs( gs )
+        , m_previous( gs->snapshot() )
+        , m( m_previous->data )
+        , m_versions( m_previous->keyVersions )
     {
     }
-    ~WriteLock() { m_gs->changed(); }
+    ~WriteLock()
+    {
+        std::atomic_store(
+            &m_gs->m_snapshot,
+            std::make_shared< const Snapshot >( Snapshot { version(), std::move( m ), std::move( m_versions ) } ) );
+        unlock();
+
+        for ( const auto& key : qAsConst( m_keys ) )
+        {
+            m_gs->keyChanged( key );
+        }
+        if ( !m_keys.isEmpty() )
+        {
+            m_gs->keysChanged( m_keys );
+        }
+        m_gs->changed();
+    }
+
+    void insert( const QString& key, const QVariant& value )
+    {
+        auto it = m.find( key );
+        if ( it == m.end() )
+        {
+            m.insert( key, value );
+            changedKey( key );
+        }
+        else if ( it.value() != value )
+        {
+            it.value() = value;
+            changedKey( key );
+        }
+    }
+
+    int remove( const QString& key )
+    {
+        const int nItems = m.remove( key );
+        if ( nItems )
+        {
+            changedKey( key );
+        }
+        return nItems;
+    }
 
     GlobalStorage* m_gs;
+    SnapshotPointer m_previous;
+    QVariantMap m;  ///< The new data
+
+private:
+    /// @brief The version of the snapshot that is published
+    quint64 version() const { return m_previous->version + 1; }
+    void changedKey( const QString& key )
+    {
+        if ( !m_keys.contains( key ) )
+        {
+            m_keys.append( key );
+            m_versions.insert( key, version() );
+        }
+    }
+
+    QHash< QString, quint64 > m_versions;
+    QStringList m_keys;  ///< Keys whose value has changed
 };
 
 GlobalStorage::GlobalStorage( QObject* parent )
     : QObject( parent )
+    , m_snapshot( std::make_shared< const Snapshot >() )
+{
+}
+
+
+GlobalStorage::SnapshotPointer
+GlobalStorage::snapshot() const
+{
+    return std::atomic_load( &m_snapshot );
+}
+
+
+GlobalStorage::Batch::Batch( GlobalStorage* gs )
+    : m_gs( gs )
+{
+}
+
+GlobalStorage::Batch::~Batch()
+{
+    commit();
+}
+
+void
+GlobalStorage::Batch::insert( const QString& key, const QVariant& value )
+{
+    m_inserted.insert( key, value );
+    m_removed.remove( key );
+}
+
+void
+GlobalStorage::Batch::remove( const QString& key )
 {
+    m_inserted.remove( key );
+    m_removed.insert( key );
+}
+
+QVariant
+GlobalStorage::Batch::value( const QString& key ) const
+{
+    if ( m_removed.contains( key ) )
+    {
+        return QVariant();
+    }
+    auto it = m_inserted.constFind( key );
+    return it != m_inserted.constEnd() ? it.value() : m_gs->value( key );
+}
+
+void
+GlobalStorage::Batch::commit()
+{
+    if ( m_inserted.isEmpty() && m_removed.isEmpty() )
+    {
+        return;
+    }
+
+    WriteLock l( m_gs );
+    for ( const auto& key : qAsConst( m_removed ) )
+    {
+        l.remove( key );
+    }
+    for ( auto it = m_inserted.constBegin(); it != m_inserted.constEnd(); ++it )
+    {
+        l.insert( it.key(), it.value() );
+    }
+    m_inserted.clear();
+    m_removed.clear();
 }
 
 
 bool
 GlobalStorage::contains( const QString& key ) const
 {
-    ReadLock l( this );
-    return m.contains( key );
+    return snapshot()->data.contains( key );
 }
 
 
 int
 GlobalStorage::count() const
 {
-    ReadLock l( this );
-    return m.count();
+    return snapshot()->data.count();
 }
 
 
@@ -72,15 +194,14 @@ void
 GlobalStorage::insert( const QString& key, const QVariant& value )
 {
     WriteLock l( this );
-    m.insert( key, value );
+    l.insert( key, value );
 }
 
 
 QStringList
 GlobalStorage::keys() const
 {
-    ReadLock l( this );
-    return m.keys();
+    return snapshot()->data.keys();
 }
 
 
@@ -88,23 +209,22 @@ int
 GlobalStorage::remove( const QString& key )
 {
     WriteLock l( this );
-    int nItems = m.remove( key );
-    return nItems;
+    return l.remove( key );
 }
 
 
 QVariant
 GlobalStorage::value( const QString& key ) const
 {
-    ReadLock l( this );
-    return m.value( key );
+    return snapshot()->data.value( key );
 }
 
 void
 GlobalStorage::debugDump() const
 {
-    ReadLock l( this );
-    cDebug() << "GlobalStorage" << Logger::Pointer( this ) << m.count() << "items";
+    const auto s = snapshot();
+    const auto& m = s->data;
+    cDebug() << "GlobalStorage" << Logger::Pointer( this ) << m.count() << "items, version" << s->version;
     for ( auto it = m.cbegin(); it != m.cend(); ++it )
     {
         cDebug() << Logger::SubEntry << it.key() << '\t' << it.value();
@@ -114,14 +234,14 @@ GlobalStorage::debugDump() const
 bool
 GlobalStorage::saveJson( const QString& filename ) const
 {
-    ReadLock l( this );
+    const auto s = snapshot();
     QFile f( filename );
     if ( !f.open( QFile::WriteOnly ) )
     {
         return false;
     }
 
-    f.write( QJsonDocument::fromVariant( m ).toJson() );
+    f.write( QJsonDocument::fromVariant( s->data ).toJson() );
     f.close();
     return true;
 }
@@ -150,11 +270,11 @@ GlobalStorage::loadJson( const QString& filename )
         WriteLock l( this );
         // Do **not** use method insert() here, because it would
         //   recursively lock the mutex, leading to deadlock. Also,
-        //   that would emit changed() for each key.
+        //   that would emit the change signals for each key.
         auto map = d.toVariant().toMap();
         for ( auto i = map.constBegin(); i != map.constEnd(); ++i )
         {
-            m.insert( i.key(), *i );
+            l.insert( i.key(), *i );
         }
         return true;
     }
@@ -164,8 +284,7 @@ GlobalStorage::loadJson( const QString& filename )
 bool
 GlobalStorage::saveYaml( const QString& filename ) const
 {
-    ReadLock l( this );
-    return CalamaresUtils::saveYaml( filename, m );
+    return CalamaresUtils::saveYaml( filename, snapshot()->data );
 }
 
 bool
@@ -178,10 +297,10 @@ GlobalStorage::loadYaml( const QString& filename )
         WriteLock l( this );
         // Do **not** use method insert() here, because it would
         //   recursively lock the mutex, leading to deadlock. Also,
-        //   that would emit changed() for each key.
+        //   that would emit the change signals for each key.
         for ( auto i = map.constBegin(); i != map.constEnd(); ++i )
         {
-            m.insert( i.key(), *i );
+            l.insert( i.key(), *i );
         }
         return true;
     }
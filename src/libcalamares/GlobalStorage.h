@@ -12,11 +12,16 @@
 #ifndef CALAMARES_GLOBALSTORAGE_H
 #define CALAMARES_GLOBALSTORAGE_H
 
+#include <QHash>
 #include <QMutex>
 #include <QObject>
+#include <QSet>
 #include <QString>
+#include <QStringList>
 #include <QVariantMap>
 
+#include <memory>
+
 namespace Calamares
 {
 
@@ -39,13 +44,72 @@ namespace Calamares
  * This class is thread-safe -- most accesses go through JobQueue, which
  * handles threading itself, but because modules load in parallel and can
  * have asynchronous tasks like GeoIP lookups, the storage itself also
- * has locking. All methods are thread-safe, use data() to make a snapshot
- * copy for use outside of the thread-safe API.
+ * has locking. All methods are thread-safe. Writers are serialized, and
+ * each write publishes a new, immutable, snapshot of the data; readers
+ * do not lock, but read the most recent snapshot. Use snapshot() to read
+ * several values that are consistent with each other.
+ *
+ * Each change is announced with keyChanged() for each key whose value
+ * changed, keysChanged() with all of those keys, and then changed().
+ * Use a Batch to make many changes with a single announcement.
  */
 class GlobalStorage : public QObject
 {
     Q_OBJECT
 public:
+    /** @brief The contents of the store at some moment
+     *
+     * A snapshot does not change; changes to the store create
+     * a new snapshot, with a higher version number.
+     */
+    struct Snapshot
+    {
+        quint64 version = 0;  ///< Increases with each change to the store
+        QVariantMap data;
+        /// The version in which each key last changed; keys that never changed are missing
+        QHash< QString, quint64 > keyVersions;
+
+        /** @brief The version in which the value of @p key last changed
+         *
+         * This can be used to cache something computed from the value
+         * of a single key. Returns 0 if the key has never been changed.
+         */
+        quint64 keyVersion( const QString& key ) const { return keyVersions.value( key ); }
+    };
+    using SnapshotPointer = std::shared_ptr< const Snapshot >;
+
+    /** @brief A group of changes that is applied all at once
+     *
+     * Inserts and removals on the batch are collected, and applied
+     * to the store when commit() is called or the batch is destroyed.
+     * Other threads never see part of the changes, and the change
+     * signals are emitted once for the whole batch.
+     *
+     * Reading from the store during the batch gives the values from
+     * before the batch; use value() on the batch to see pending changes.
+     */
+    class Batch
+    {
+    public:
+        explicit Batch( GlobalStorage* gs );
+        Batch( const Batch& ) = delete;
+        Batch& operator=( const Batch& ) = delete;
+        ~Batch();
+
+        void insert( const QString& key, const QVariant& value );
+        void remove( const QString& key );
+        /// @brief The value of @p key, including the pending changes
+        QVariant value( const QString& key ) const;
+
+        /// @brief Applies the pending changes; the batch can be used again afterwards
+        void commit();
+
+    private:
+        GlobalStorage* m_gs;
+        QVariantMap m_inserted;
+        QSet< QString > m_removed;
+    };
+
     /** @brief Create a GS object
      *
      * **Generally** there is only one GS object (hence, "global") which
@@ -115,7 +179,15 @@ public:
      *
      * Provides a snapshot of the data at a given time.
      */
-    QVariantMap data() const { return m; }
+    QVariantMap data() const { return snapshot()->data; }
+
+    /** @brief The current contents of the store
+     *
+     * This is cheap (no data is copied) and does not block writers.
+     * Compare the version of two snapshots to see if the store has
+     * changed in between.
+     */
+    SnapshotPointer snapshot() const;
 
 public Q_SLOTS:
     /** @brief Does the store contain the given key?
@@ -154,12 +226,19 @@ signals:
      * is already present.
      */
     void changed();
+    /** @brief Emitted when the value of @p key has changed
+     *
+     * Unlike changed(), this is only emitted if the value really
+     * is different (or the key was inserted or removed).
+     */
+    void keyChanged( const QString& key );
+    /// @brief Emitted once per change, with all the keys that have changed
+    void keysChanged( const QStringList& keys );
 
 private:
-    class ReadLock;
     class WriteLock;
-    QVariantMap m;
-    mutable QMutex m_mutex;
+    SnapshotPointer m_snapshot;  ///< Only use through std::atomic_load() and atomic_store()
+    QMutex m_mutex;  ///< Serializes writers
 };
 
 }  // namespace Calamares
@@ -12,6 +12,20 @@
 namespace Calamares
 {
 
+static thread_local const CancellationToken* s_currentToken = nullptr;
+
+const CancellationToken*
+CancellationToken::current()
+{
+    return s_currentToken;
+}
+
+void
+CancellationToken::setCurrent( const CancellationToken* token )
+{
+    s_currentToken = token;
+}
+
 JobResult::JobResult( JobResult&& rhs )
     : m_message( std::move( rhs.m_message ) )
     , m_details( std::move( rhs.m_details ) )
@@ -95,6 +109,21 @@ Job::getJobWeight() const
 }
 
 
+qint64
+Job::workSize() const
+{
+    return 0;
+}
+
+
+bool
+Job::isCancelled() const
+{
+    const auto* token = CancellationToken::current();
+    return token && token->isCancelled();
+}
+
+
 QString
 Job::prettyDescription() const
 {
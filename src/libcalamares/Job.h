@@ -17,6 +17,8 @@
 #include <QObject>
 #include <QSharedPointer>
 
+#include <atomic>
+
 namespace Calamares
 {
 
@@ -81,6 +83,33 @@ private:
     int m_number;
 };
 
+/** @brief Asks running jobs to stop
+ *
+ * The job queue has one of these; when it is cancelled (e.g. because
+ * Calamares is shutting down) jobs should stop as soon as they can,
+ * and return an error. Commands run with System::runCommand() are
+ * killed, with their child processes.
+ */
+class DLLEXPORT CancellationToken
+{
+public:
+    bool isCancelled() const { return m_cancelled.load(); }
+    void cancel() { m_cancelled = true; }
+    void reset() { m_cancelled = false; }
+
+    /** @brief The token for the job running in the calling thread
+     *
+     * This is @c nullptr outside of jobs run by the job queue,
+     * and for emergency jobs, which are never cancelled.
+     */
+    static const CancellationToken* current();
+    /// @brief Sets the token for the calling thread, used by the job queue
+    static void setCurrent( const CancellationToken* token );
+
+private:
+    std::atomic< bool > m_cancelled { false };
+};
+
 class DLLEXPORT Job : public QObject
 {
     Q_OBJECT
@@ -103,6 +132,15 @@ public:
      * which of the jobs is "heavy" and which is not.
      */
     virtual int getJobWeight() const;
+    /** @brief The amount of work this job will do.
+     *
+     * This is used only to scale the durations of the job measured
+     * in earlier runs (see JobProfile), so the unit does not matter
+     * as long as it is consistent: a job that copies files might
+     * return the number of bytes to copy, a job that runs commands
+     * the number of commands. The default returns 0, for "unknown".
+     */
+    virtual qint64 workSize() const;
     /** @brief The human-readable name of this job
      *
      * This should be a very short statement of what the job does.
@@ -127,6 +165,15 @@ public:
     virtual QString prettyStatusMessage() const;
     virtual JobResult exec() = 0;
 
+    /** @brief Should the job stop?
+     *
+     * Long-running jobs should check this regularly from exec(),
+     * and return an error if it is @c true. This checks the
+     * CancellationToken for the calling thread, so it is only
+     * meaningful from within exec().
+     */
+    bool isCancelled() const;
+
     bool isEmergency() const { return m_emergency; }
     void setEmergency( bool e ) { m_emergency = e; }
 
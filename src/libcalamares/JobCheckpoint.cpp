@@ -0,0 +1,331 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2026 agent <agent@local>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#include "JobCheckpoint.h"
+
+#include "GlobalStorage.h"
+#include "partition/Mount.h"
+#include "utils/Dirs.h"
+#include "utils/Logger.h"
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSaveFile>
+
+#include <algorithm>
+
+static const char SEQUENCE[] = "sequence";
+static const char DONE[] = "done";
+static const char LAST_INSTANCE[] = "lastInstance";
+static const char MOUNTS[] = "mounts";
+
+/** @brief Writes @p data to @p path, readable only by the owner
+ *
+ * The file is replaced only once it is completely written,
+ * so there is always a complete checkpoint.
+ */
+static bool
+writePrivateFile( const QString& path, const QByteArray& data )
+{
+    QSaveFile f( path );
+    if ( !f.open( QIODevice::WriteOnly ) )
+    {
+        return false;
+    }
+    f.setPermissions( QFileDevice::ReadOwner | QFileDevice::WriteOwner );
+    f.write( data );
+    return f.commit();
+}
+
+/// @brief Removes the @p secrets from @p v, also from nested maps and lists
+static QVariant
+withoutSecrets( const QVariant& v, const QStringList& secrets )
+{
+    if ( v.type() == QVariant::Map )
+    {
+        QVariantMap m = v.toMap();
+        for ( const auto& key : secrets )
+        {
+            m.remove( key );
+        }
+        for ( auto it = m.begin(); it != m.end(); ++it )
+        {
+            *it = withoutSecrets( *it, secrets );
+        }
+        return m;
+    }
+    if ( v.type() == QVariant::List )
+    {
+        QVariantList l = v.toList();
+        for ( auto& item : l )
+        {
+            item = withoutSecrets( item, secrets );
+        }
+        return l;
+    }
+    return v;
+}
+
+/** @brief Puts the @p secrets from @p current into @p restored
+ *
+ * Where @p restored (from a checkpoint) has no value for a secret,
+ * the value from @p current is used; maps are matched by key,
+ * and lists of the same length item by item.
+ */
+static QVariant
+withSecrets( const QVariant& restored, const QVariant& current, const QStringList& secrets )
+{
+    if ( restored.type() == QVariant::Map && current.type() == QVariant::Map )
+    {
+        QVariantMap m = restored.toMap();
+        const QVariantMap c = current.toMap();
+        for ( auto it = m.begin(); it != m.end(); ++it )
+        {
+            if ( c.contains( it.key() ) )
+            {
+                *it = withSecrets( *it, c.value( it.key() ), secrets );
+            }
+        }
+        for ( const auto& key : secrets )
+        {
+            if ( c.contains( key ) && !m.contains( key ) )
+            {
+                m.insert( key, c.value( key ) );
+            }
+        }
+        return m;
+    }
+    if ( restored.type() == QVariant::List && current.type() == QVariant::List )
+    {
+        QVariantList l = restored.toList();
+        const QVariantList c = current.toList();
+        if ( l.count() == c.count() )
+        {
+            for ( int i = 0; i < l.count(); ++i )
+            {
+                l[ i ] = withSecrets( l[ i ], c[ i ], secrets );
+            }
+        }
+        return l;
+    }
+    return restored;
+}
+
+/// @brief Undoes the octal escapes (e.g. \040 for space) in /proc/mounts
+static QString
+unescapeMountField( const QByteArray& field )
+{
+    QByteArray result;
+    result.reserve( field.length() );
+    for ( int i = 0; i < field.length(); ++i )
+    {
+        if ( field[ i ] == '\\' && i + 3 < field.length() )
+        {
+            bool ok = false;
+            const int c = field.mid( i + 1, 3 ).toInt( &ok, 8 );
+            if ( ok )
+            {
+                result.append( char( c ) );
+                i += 3;
+                continue;
+            }
+        }
+        result.append( field[ i ] );
+    }
+    return QString::fromLocal8Bit( result );
+}
+
+namespace Calamares
+{
+
+QString
+JobCheckpoint::checkpointFile()
+{
+    return CalamaresUtils::appLogDir().filePath( "checkpoint.json" );
+}
+
+QString
+JobCheckpoint::storageFile()
+{
+    return CalamaresUtils::appLogDir().filePath( "checkpoint-storage.json" );
+}
+
+void
+JobCheckpoint::remove()
+{
+    QFile::remove( checkpointFile() );
+    QFile::remove( storageFile() );
+}
+
+QStringList
+JobCheckpoint::secretKeys()
+{
+    return { QStringLiteral( "password" ), QStringLiteral( "luksPassphrase" ) };
+}
+
+QString
+JobCheckpoint::jobKey( const QString& instanceKey, const QString& prettyName )
+{
+    return instanceKey.isEmpty() ? prettyName : instanceKey + '/' + prettyName;
+}
+
+QString
+JobCheckpoint::sequenceHash( const QStringList& jobKeys )
+{
+    return QString::fromLatin1(
+        QCryptographicHash::hash( jobKeys.join( '\n' ).toUtf8(), QCryptographicHash::Sha1 ).toHex() );
+}
+
+QList< JobCheckpoint::Mount >
+JobCheckpoint::targetMounts( const QString& rootMountPoint )
+{
+    QList< Mount > mounts;
+    if ( rootMountPoint.isEmpty() )
+    {
+        return mounts;
+    }
+
+    QFile f( QStringLiteral( "/proc/mounts" ) );
+    if ( !f.open( QIODevice::ReadOnly ) )
+    {
+        return mounts;
+    }
+
+    const QString prefix = QDir::cleanPath( rootMountPoint );
+    for ( const auto& line : f.readAll().split( '\n' ) )
+    {
+        const auto fields = line.split( ' ' );
+        if ( fields.count() < 3 )
+        {
+            continue;
+        }
+        Mount m { unescapeMountField( fields[ 0 ] ), unescapeMountField( fields[ 1 ] ), fields[ 2 ] };
+        if ( m.mountPoint == prefix || m.mountPoint.startsWith( prefix + '/' ) )
+        {
+            mounts.append( m );
+        }
+    }
+    return mounts;
+}
+
+bool
+JobCheckpoint::save( const GlobalStorage* gs ) const
+{
+    const QVariant storage = withoutSecrets( gs->data(), secretKeys() );
+    if ( !writePrivateFile( storageFile(), QJsonDocument::fromVariant( storage ).toJson() ) )
+    {
+        cWarning() << "Could not write checkpoint of global storage" << storageFile();
+        return false;
+    }
+
+    QJsonArray mountList;
+    for ( const auto& m : targetMounts( gs->value( "rootMountPoint" ).toString() ) )
+    {
+        mountList.append( QJsonArray { m.device, m.mountPoint, m.fileSystem } );
+    }
+    QJsonObject o { { SEQUENCE, sequence },
+                    { DONE, QJsonArray::fromStringList( doneJobs ) },
+                    { LAST_INSTANCE, lastInstanceKey },
+                    { MOUNTS, mountList } };
+
+    if ( !writePrivateFile( checkpointFile(), QJsonDocument( o ).toJson() ) )
+    {
+        cWarning() << "Could not write checkpoint" << checkpointFile();
+        return false;
+    }
+    return true;
+}
+
+bool
+JobCheckpoint::load()
+{
+    QFile f( checkpointFile() );
+    if ( !f.exists() || !f.open( QIODevice::ReadOnly ) )
+    {
+        return false;
+    }
+
+    QJsonParseError error;
+    const auto doc = QJsonDocument::fromJson( f.readAll(), &error );
+    if ( error.error != QJsonParseError::NoError || !doc.isObject() )
+    {
+        cWarning() << "Checkpoint" << checkpointFile() << "is not valid:" << error.errorString();
+        return false;
+    }
+
+    const auto o = doc.object();
+    sequence = o.value( SEQUENCE ).toString();
+    doneJobs.clear();
+    for ( const auto& v : o.value( DONE ).toArray() )
+    {
+        doneJobs.append( v.toString() );
+    }
+    lastInstanceKey = o.value( LAST_INSTANCE ).toString();
+    mounts.clear();
+    for ( const auto& v : o.value( MOUNTS ).toArray() )
+    {
+        const auto a = v.toArray();
+        if ( a.count() == 3 )
+        {
+            mounts.append( Mount { a[ 0 ].toString(), a[ 1 ].toString(), a[ 2 ].toString() } );
+        }
+    }
+    return true;
+}
+
+bool
+JobCheckpoint::restore( GlobalStorage* gs ) const
+{
+    QFile f( storageFile() );
+    QJsonParseError error;
+    const auto doc = f.open( QIODevice::ReadOnly ) ? QJsonDocument::fromJson( f.readAll(), &error ) : QJsonDocument();
+    if ( !doc.isObject() )
+    {
+        cWarning() << "Could not restore global storage from" << storageFile();
+        return false;
+    }
+
+    {
+        const QVariantMap current = gs->data();
+        const QVariantMap restored = doc.object().toVariantMap();
+        GlobalStorage::Batch batch( gs );
+        for ( auto it = restored.constBegin(); it != restored.constEnd(); ++it )
+        {
+            batch.insert( it.key(), withSecrets( *it, current.value( it.key() ), secretKeys() ) );
+        }
+    }
+
+    const QString rootMountPoint = gs->value( "rootMountPoint" ).toString();
+    const auto mounted = targetMounts( rootMountPoint );
+    for ( const auto& m : mounts )
+    {
+        if ( std::any_of( mounted.cbegin(), mounted.cend(), [ &m ]( const Mount& other ) {
+                 return other.mountPoint == m.mountPoint;
+             } ) )
+        {
+            continue;
+        }
+        // The root mount point is usually a temporary directory, which may be gone
+        QDir().mkpath( m.mountPoint );
+        cDebug() << "Mounting" << m.device << "on" << m.mountPoint << "again";
+        const int r = CalamaresUtils::Partition::mount( m.device, m.mountPoint, m.fileSystem );
+        if ( r )
+        {
+            cWarning() << "Could not mount" << m.device << "on" << m.mountPoint << "code" << r;
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace Calamares
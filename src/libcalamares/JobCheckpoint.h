@@ -0,0 +1,109 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2026 agent <agent@local>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#ifndef CALAMARES_JOBCHECKPOINT_H
+#define CALAMARES_JOBCHECKPOINT_H
+
+#include "DllMacro.h"
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+namespace Calamares
+{
+class GlobalStorage;
+
+/** @brief State of the job queue after a job has succeeded
+ *
+ * The job queue writes a checkpoint after each job that succeeds,
+ * so that an installation that fails late (e.g. in the bootloader
+ * or package jobs) can be resumed without repeating the partitioning
+ * and unpacking of the filesystem. A checkpoint consists of
+ *  - a hash of the keys of all the jobs in the queue (see jobKey()),
+ *    so that a resumed queue can check that it is running the same jobs,
+ *  - the keys of the jobs that are done (jobs may finish out of
+ *    order, see JobConstraints) and the module instance of the last
+ *    one to finish,
+ *  - a snapshot of GlobalStorage, without secrets (see secretKeys()),
+ *  - the filesystems mounted in the target system.
+ *
+ * The files are readable only by the user running Calamares.
+ */
+class DLLEXPORT JobCheckpoint
+{
+public:
+    struct Mount
+    {
+        QString device;
+        QString mountPoint;
+        QString fileSystem;
+    };
+
+    JobCheckpoint() = default;
+
+    /** @brief The file the checkpoint is saved to
+     *
+     * This is usually ~/.cache/calamares/checkpoint.json
+     */
+    static QString checkpointFile();
+    /// @brief The file the GlobalStorage snapshot is saved to
+    static QString storageFile();
+    /// @brief Removes the checkpoint files, e.g. after a successful installation
+    static void remove();
+
+    /** @brief Keys in GlobalStorage that are not written to the checkpoint
+     *
+     * These hold passwords and passphrases, also when nested in maps
+     * (e.g. *luksPassphrase* in the *partitions* list). A resumed
+     * installation keeps the values that were entered again
+     * in this run.
+     */
+    static QStringList secretKeys();
+    /** @brief Identifies a job in the queue
+     *
+     * The key combines the module instance (if any) with the name
+     * of the job, which for partitioning jobs describes the changes made.
+     */
+    static QString jobKey( const QString& instanceKey, const QString& prettyName );
+    /// @brief Hash of the keys of all the jobs in a queue
+    static QString sequenceHash( const QStringList& jobKeys );
+
+    /** @brief Reads the filesystems mounted under @p rootMountPoint
+     *
+     * Mounts are listed in the order they were mounted in, from
+     * /proc/mounts, so that they can be mounted again in the same order.
+     */
+    static QList< Mount > targetMounts( const QString& rootMountPoint );
+
+    /** @brief Writes the checkpoint and a snapshot of @p gs
+     *
+     * The mounts in the target system are read from the
+     * rootMountPoint in @p gs.
+     */
+    bool save( const GlobalStorage* gs ) const;
+    bool load();
+
+    /** @brief Restores the snapshot of GlobalStorage and the mounts
+     *
+     * Secrets that are in @p gs now are kept. Filesystems that are
+     * not mounted any more are mounted again. Returns @c false if
+     * either fails.
+     */
+    bool restore( GlobalStorage* gs ) const;
+
+    QString sequence;  ///< Hash of the keys of the jobs in the queue
+    QStringList doneJobs;  ///< Keys of the jobs that succeeded
+    QString lastInstanceKey;  ///< Module instance of the last job that succeeded
+    QList< Mount > mounts;  ///< Filled in by load()
+};
+
+}  // namespace Calamares
+
+#endif  // CALAMARES_JOBCHECKPOINT_H
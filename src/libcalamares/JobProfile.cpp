@@ -0,0 +1,122 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2026 agent <agent@local>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#include "JobProfile.h"
+
+#include "utils/Dirs.h"
+#include "utils/Logger.h"
+
+#include <QFile>
+#include <QJsonDocument>
+#include <QJsonObject>
+
+static const char SECONDS[] = "seconds";
+static const char SIZE[] = "size";
+
+namespace Calamares
+{
+
+QString
+JobProfile::profileFile()
+{
+    return CalamaresUtils::appLogDir().filePath( "job-profile.json" );
+}
+
+JobProfile
+JobProfile::loadDefault()
+{
+    JobProfile p;
+    for ( const auto& path : { profileFile(), QStringLiteral( "/etc/calamares/job-profile.json" ) } )
+    {
+        if ( p.load( path ) )
+        {
+            cDebug() << "Loaded" << p.count() << "job durations from" << path;
+            break;
+        }
+    }
+    return p;
+}
+
+bool
+JobProfile::load( const QString& path )
+{
+    QFile f( path );
+    if ( !f.exists() || !f.open( QIODevice::ReadOnly ) )
+    {
+        return false;
+    }
+
+    QJsonParseError error;
+    const auto doc = QJsonDocument::fromJson( f.readAll(), &error );
+    if ( error.error != QJsonParseError::NoError || !doc.isObject() )
+    {
+        cWarning() << "Job profile" << path << "is not valid:" << error.errorString();
+        return false;
+    }
+
+    m_entries.clear();
+    const auto o = doc.object();
+    for ( auto it = o.constBegin(); it != o.constEnd(); ++it )
+    {
+        const auto v = it.value().toObject();
+        Entry e { v.value( SECONDS ).toDouble(), static_cast< qint64 >( v.value( SIZE ).toDouble() ) };
+        if ( e.seconds > 0 )
+        {
+            m_entries.insert( it.key(), e );
+        }
+    }
+    return true;
+}
+
+bool
+JobProfile::save( const QString& path ) const
+{
+    QJsonObject o;
+    for ( auto it = m_entries.constBegin(); it != m_entries.constEnd(); ++it )
+    {
+        o.insert( it.key(), QJsonObject { { SECONDS, it->seconds }, { SIZE, it->size } } );
+    }
+
+    QFile f( path );
+    if ( !f.open( QIODevice::WriteOnly | QIODevice::Truncate ) )
+    {
+        cWarning() << "Could not write job profile" << path;
+        return false;
+    }
+    f.write( QJsonDocument( o ).toJson() );
+    return true;
+}
+
+qreal
+JobProfile::estimate( const QString& key, qint64 size ) const
+{
+    auto it = m_entries.constFind( key );
+    if ( it == m_entries.constEnd() )
+    {
+        return 0.0;
+    }
+    if ( size > 0 && it->size > 0 )
+    {
+        return it->seconds * qreal( size ) / qreal( it->size );
+    }
+    return it->seconds;
+}
+
+void
+JobProfile::record( const QString& key, qreal seconds, qint64 size )
+{
+    if ( seconds <= 0 )
+    {
+        return;
+    }
+    const qreal previous = estimate( key, size );
+    m_entries.insert( key, Entry { previous > 0 ? ( previous + seconds ) / 2 : seconds, size } );
+}
+
+}  // namespace Calamares
@@ -0,0 +1,79 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2026 agent <agent@local>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#ifndef CALAMARES_JOBPROFILE_H
+#define CALAMARES_JOBPROFILE_H
+
+#include "DllMacro.h"
+
+#include <QHash>
+#include <QString>
+
+namespace Calamares
+{
+
+/** @brief Measured durations of jobs from earlier runs
+ *
+ * The job queue records how long each job took, keyed by the
+ * module instance the job comes from (and the index of the job
+ * within that module's jobs). On the next run, the measured durations
+ * replace the configured weights, so that progress is proportional
+ * to time.
+ *
+ * Jobs may report a work size (see Job::workSize()); if a job did
+ * so in both runs, the estimate is scaled by the ratio of sizes.
+ */
+class DLLEXPORT JobProfile
+{
+public:
+    struct Entry
+    {
+        qreal seconds = 0.0;
+        qint64 size = 0;  ///< Work size when measured, 0 if unknown
+    };
+
+    JobProfile() = default;
+
+    /** @brief The file the profile is saved to
+     *
+     * This is usually ~/.cache/calamares/job-profile.json
+     */
+    static QString profileFile();
+    /** @brief Loads the profile from the usual places
+     *
+     * Tries profileFile() first, then a profile shipped
+     * with the configuration in /etc/calamares/job-profile.json
+     */
+    static JobProfile loadDefault();
+
+    bool load( const QString& path );
+    bool save( const QString& path = profileFile() ) const;
+
+    bool isEmpty() const { return m_entries.isEmpty(); }
+    int count() const { return m_entries.count(); }
+
+    /** @brief Estimated duration, in seconds, of job @p key
+     *
+     * Returns 0 if there is no measurement for the job.
+     */
+    qreal estimate( const QString& key, qint64 size = 0 ) const;
+    /** @brief Adds a measurement
+     *
+     * Measurements are smoothed: the new estimate is the mean of
+     * the old estimate and the new measurement.
+     */
+    void record( const QString& key, qreal seconds, qint64 size = 0 );
+
+private:
+    QHash< QString, Entry > m_entries;
+};
+
+}  // namespace Calamares
+
+#endif  // CALAMARES_JOBPROFILE_H
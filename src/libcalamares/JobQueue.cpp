@@ -13,11 +13,38 @@
 #include "CalamaresConfig.h"
 #include "GlobalStorage.h"
 #include "Job.h"
+#include "JobCheckpoint.h"
+#include "JobProfile.h"
 #include "utils/Logger.h"
+#include "utils/Trace.h"
 
+#include <QElapsedTimer>
 #include <QMutex>
 #include <QMutexLocker>
+#include <QRunnable>
 #include <QThread>
+#include <QThreadPool>
+#include <QTimer>
+#include <QVector>
+#include <QWaitCondition>
+
+#include <algorithm>
+#include <atomic>
+
+/** @brief Interval (ms) at which progress is delivered to the UI
+ *
+ * Jobs may report progress thousands of times per second (e.g. while
+ * unpacking the filesystem); those reports are coalesced and only the
+ * most recent one is delivered, at about display refresh rate.
+ */
+static constexpr int PROGRESS_INTERVAL = 16;
+
+/** @brief Time (ms) the job thread gets to stop when the queue is destroyed
+ *
+ * Cancelled jobs should stop quickly, but emergency jobs (e.g. unmounting
+ * the target system) still run, and should get a chance to finish.
+ */
+static constexpr unsigned long SHUTDOWN_TIMEOUT = 30000;
 
 namespace Calamares
 {
@@ -40,27 +67,113 @@ struct WeightedJob
     qreal weight = 0.0;
 
     job_ptr job;
+
+    /// @brief The enqueue() call that added this job (jobs in a batch run in order)
+    int batch = 0;
+    /// @brief Key in the job profile, empty if the job is not profiled
+    QString profileKey;
+    JobConstraints constraints;
+    /** @brief Indexes of the jobs that must be done before this one starts
+     *
+     * This is calculated by finalize(), from the constraints.
+     */
+    QVector< int > predecessors;
 };
 using WeightedJobList = QList< WeightedJob >;
 
+static bool
+intersects( const QStringList& a, const QStringList& b )
+{
+    return std::any_of( a.cbegin(), a.cend(), [&b]( const QString& s ) { return b.contains( s ); } );
+}
+
+/** @brief Does job @p later need to wait for job @p earlier?
+ *
+ * Jobs without constraints are barriers, so anything involving
+ * them is ordered; otherwise, look at the constraints.
+ */
+static bool
+mustFollow( const WeightedJob& later, const WeightedJob& earlier )
+{
+    const auto& l = later.constraints;
+    const auto& e = earlier.constraints;
+    if ( !l.isSchedulable() || !e.isSchedulable() || later.batch == earlier.batch )
+    {
+        return true;
+    }
+    if ( !e.moduleName.isEmpty() && l.after.contains( e.moduleName ) )
+    {
+        return true;
+    }
+    return intersects( l.inputs, e.outputs ) || intersects( l.outputs, e.outputs ) || intersects( l.outputs, e.inputs );
+}
+
 class JobThread : public QThread
 {
 public:
     JobThread( JobQueue* queue )
         : QThread( queue )
         , m_queue( queue )
-        , m_jobIndex( 0 )
+        , m_maxParallelJobs( QThread::idealThreadCount() )
     {
     }
 
     ~JobThread() override;
 
+    void setMaximumParallelJobs( int n ) { m_maxParallelJobs = n < 1 ? QThread::idealThreadCount() : n; }
+    void setResumeFromCheckpoint( bool resume ) { m_resume = resume; }
+    void setCoalesceProgress( bool coalesce ) { m_coalesceProgress = coalesce; }
+
+    void prepare( const JobList& jobs )
+    {
+        for ( const auto& job : jobs )
+        {
+            cDebug() << "Preparing" << job->prettyName() << "in the background.";
+            m_preparePool.start( new PrepareRunner( this, job ) );
+        }
+    }
+    bool waitForPrepareJobs( int msecs ) { return m_preparePool.waitForDone( msecs ); }
+
+    /** @brief Asks the running jobs to stop, and skips the others
+     *
+     * Emergency jobs still run.
+     */
+    void cancel()
+    {
+        m_cancellation.cancel();
+        QMutexLocker slock( &m_stateMutex );
+        m_stateChanged.wakeAll();
+    }
+
     void finalize()
     {
         Q_ASSERT( m_runningJobs->isEmpty() );
         QMutexLocker qlock( &m_enqueMutex );
         QMutexLocker rlock( &m_runMutex );
         std::swap( m_runningJobs, m_queuedJobs );
+        m_cancellation.reset();
+
+        for ( int i = 0; i < m_runningJobs->count(); ++i )
+        {
+            auto& jobitem = ( *m_runningJobs )[ i ];
+            jobitem.predecessors.clear();
+            for ( int j = 0; j < i; ++j )
+            {
+                if ( mustFollow( jobitem, m_runningJobs->at( j ) ) )
+                {
+                    jobitem.predecessors.append( j );
+                }
+            }
+        }
+    }
+
+    /* Called from run(), once the preparations are done, since those
+     * may tell how much work the jobs have to do (see Job::workSize()).
+     */
+    void applyWeights()
+    {
+        m_profile = JobProfile::loadDefault();
+        applyProfile();
         m_overallQueueWeight
             = m_runningJobs->isEmpty() ? 0.0 : ( m_runningJobs->last().cumulative + m_runningJobs->last().weight );
         if ( m_overallQueueWeight < 1 )
@@ -68,17 +181,27 @@ public:
             m_overallQueueWeight = 1.0;
         }
 
-        cDebug() << "There are" << m_runningJobs->count() << "jobs, total weight" << m_overallQueueWeight;
+        cDebug() << "There are" << m_runningJobs->count() << "jobs, total weight" << m_overallQueueWeight
+                 << "at most" << m_maxParallelJobs << "in parallel";
         int c = 0;
         for ( const auto& j : *m_runningJobs )
         {
             cDebug() << Logger::SubEntry << "Job" << ( c + 1 ) << j.job->prettyName() << "+wt" << j.weight << "tot.wt"
                      << ( j.cumulative + j.weight );
+            if ( j.predecessors.count() < c )
+            {
+                QStringList names;
+                for ( int p : j.predecessors )
+                {
+                    names << QString::number( p + 1 );
+                }
+                cDebug() << Logger::SubEntry << "Job" << ( c + 1 ) << "waits only for" << names.join( ',' );
+            }
             c++;
         }
     }
 
-    void enqueue( int moduleWeight, const JobList& jobs )
+    void enqueue( int moduleWeight, const JobList& jobs, const JobConstraints& constraints )
     {
         QMutexLocker qlock( &m_enqueMutex );
 
@@ -94,60 +217,159 @@ public:
             totalJobWeight = 1.0;
         }
 
+        const int batch = m_queuedJobs->isEmpty() ? 0 : m_queuedJobs->last().batch + 1;
+        int indexInBatch = 0;
         for ( const auto& j : jobs )
         {
             qreal jobContribution = ( j->getJobWeight() / totalJobWeight ) * moduleWeight;
-            m_queuedJobs->append( WeightedJob { cumulative, jobContribution, j } );
+            QString profileKey = constraints.instanceKey.isEmpty()
+                ? QString()
+                : QStringLiteral( "%1#%2" ).arg( constraints.instanceKey ).arg( indexInBatch );
+            m_queuedJobs->append( WeightedJob { cumulative, jobContribution, j, batch, profileKey, constraints, {} } );
             cumulative += jobContribution;
+            indexInBatch++;
         }
     }
 
     void run() override
     {
         QMutexLocker rlock( &m_runMutex );
-        bool failureEncountered = false;
-        QString message;  ///< Filled in with errors
-        QString details;
+        const int jobCount = m_runningJobs->count();
+        const qint64 queueStart = CalamaresUtils::Trace::now();
+
+        // Jobs may depend on the results of preparations
+        if ( !m_preparePool.waitForDone( 0 ) )
+        {
+            cDebug() << "Waiting for preparations to finish.";
+            setProgress( 0.0, tr( "Waiting for preparations to finish." ) );
+            m_preparePool.waitForDone();
+        }
+        applyWeights();
 
-        m_jobIndex = 0;
+        {
+            QMutexLocker plock( &m_progressMutex );
+            m_jobProgress.fill( 0.0, jobCount );
+            m_progressSum = 0.0;
+        }
+        m_statusMessages.fill( QString(), jobCount );
+        m_statusTimes.fill( 0, jobCount );
+        m_clock.start();
+
+        QThreadPool pool;
+        pool.setMaxThreadCount( m_maxParallelJobs );
+
+        QMutexLocker slock( &m_stateMutex );
+        m_states.fill( JobState::Waiting, jobCount );
+        m_durations.fill( 0.0, jobCount );
+        m_failureEncountered = false;
+        m_message.clear();
+        m_details.clear();
+        m_remainingJobs = jobCount;
+        m_activeJobs = 0;
+        m_checkpoint = JobCheckpoint();
+        m_jobKeys.clear();
         for ( const auto& jobitem : *m_runningJobs )
         {
-            if ( failureEncountered && !jobitem.job->isEmergency() )
+            m_jobKeys.append( JobCheckpoint::jobKey( jobitem.constraints.instanceKey, jobitem.job->prettyName() ) );
+        }
+        m_checkpoint.sequence = JobCheckpoint::sequenceHash( m_jobKeys );
+        if ( m_resume )
+        {
+            resumeFromCheckpoint();
+        }
+
+        while ( m_remainingJobs > 0 )
+        {
+            if ( m_cancellation.isCancelled() && !m_failureEncountered )
             {
-                cDebug() << "Skipping non-emergency job" << jobitem.job->prettyName();
+                cDebug() << "Job queue cancelled.";
+                m_failureEncountered = true;
+                m_message = tr( "The installation was cancelled." );
+                m_details.clear();
             }
-            else
+            bool progressMade = false;
+            for ( int i = 0; i < jobCount && m_activeJobs < m_maxParallelJobs; ++i )
             {
-                cDebug() << "Starting" << ( failureEncountered ? "EMERGENCY JOB" : "job" ) << jobitem.job->prettyName()
-                         << '(' << ( m_jobIndex + 1 ) << '/' << m_runningJobs->count() << ')';
-                emitProgress( 0.0 );  // 0% for *this job*
-                connect( jobitem.job.data(), &Job::progress, this, &JobThread::emitProgress );
-                auto result = jobitem.job->exec();
-                if ( !failureEncountered && !result )
+                if ( m_states[ i ] != JobState::Waiting || !isReady( i ) )
+                {
+                    continue;
+                }
+
+                const auto& jobitem = m_runningJobs->at( i );
+                progressMade = true;
+                if ( m_failureEncountered && !jobitem.job->isEmergency() )
                 {
-                    // so this is the first failure
-                    failureEncountered = true;
-                    message = result.message();
-                    details = result.details();
+                    cDebug() << "Skipping non-emergency job" << jobitem.job->prettyName();
+                    m_states[ i ] = JobState::Skipped;
+                    m_remainingJobs--;
                 }
-                QThread::msleep( 16 );  // Very brief rest before reporting the job as complete
-                emitProgress( 1.0 );  // 100% for *this job*
+                else
+                {
+                    cDebug() << "Starting" << ( m_failureEncountered ? "EMERGENCY JOB" : "job" )
+                             << jobitem.job->prettyName() << '(' << ( i + 1 ) << '/' << jobCount << ')';
+                    m_states[ i ] = JobState::Running;
+                    m_activeJobs++;
+                    pool.start( new JobRunner( this, i ) );
+                }
+            }
+            // Skipping a job may make others ready, so only wait
+            // if nothing changed in this pass over the jobs.
+            if ( !progressMade && m_remainingJobs > 0 )
+            {
+                m_stateChanged.wait( &m_stateMutex );
             }
-            m_jobIndex++;
         }
-        if ( failureEncountered )
+        slock.unlock();
+        pool.waitForDone();
+
+        CalamaresUtils::Trace::complete( "queue",
+                                         QStringLiteral( "JobQueue" ),
+                                         queueStart,
+                                         { { QStringLiteral( "jobs" ), jobCount },
+                                           { QStringLiteral( "ok" ), !m_failureEncountered } } );
+        CalamaresUtils::Trace::save();
+        saveProfile();
+        if ( !m_failureEncountered )
         {
+            JobCheckpoint::remove();
+        }
+
+        if ( m_failureEncountered )
+        {
+            // Deliver the last progress before reporting the failure
+            QMetaObject::invokeMethod( m_queue, "deliverProgress", Qt::QueuedConnection );
             QMetaObject::invokeMethod(
-                m_queue, "failed", Qt::QueuedConnection, Q_ARG( QString, message ), Q_ARG( QString, details ) );
+                m_queue, "failed", Qt::QueuedConnection, Q_ARG( QString, m_message ), Q_ARG( QString, m_details ) );
         }
         else
         {
-            emitProgress( 1.0 );
+            emitDone();
         }
         m_runningJobs->clear();
         QMetaObject::invokeMethod( m_queue, "finish", Qt::QueuedConnection );
     }
 
+    bool hasMeasuredWeights() const { return m_hasMeasuredWeights; }
+
+    /** @brief Takes the most recent progress report, if there is one
+     *
+     * Called from the UI thread. The @p message is empty if the status
+     * message has not changed since the previous report was taken.
+     */
+    bool takeProgress( qreal& progress, QString& message )
+    {
+        if ( !m_reportPending.load() )
+        {
+            return false;
+        }
+        QMutexLocker lock( &m_reportMutex );
+        m_reportPending = false;
+        progress = m_reportProgress;
+        message = m_reportMessage;
+        m_reportMessage.clear();
+        return true;
+    }
+
     /** @brief The names of the queued (not running!) jobs.
      */
     QStringList queuedJobs() const
@@ -163,19 +385,283 @@ public:
     }
 
 private:
-    /* This is called **only** from run(), while m_runMutex is
-     * already locked, so we can use the m_runningJobs member safely.
+    enum class JobState
+    {
+        Waiting,
+        Running,
+        Done,
+        Skipped
+    };
+
+    /// @brief Runs a single job from the running list on the worker pool
+    class JobRunner : public QRunnable
+    {
+    public:
+        JobRunner( JobThread* thread, int index )
+            : m_thread( thread )
+            , m_index( index )
+        {
+        }
+
+        void run() override { m_thread->runJob( m_index ); }
+
+    private:
+        JobThread* m_thread;
+        int m_index;
+    };
+
+    /* Runs one job given to prepare(), on the prepare pool */
+    class PrepareRunner : public QRunnable
+    {
+    public:
+        PrepareRunner( JobThread* thread, const job_ptr& job )
+            : m_thread( thread )
+            , m_job( job )
+        {
+        }
+        void run() override { m_thread->runPrepareJob( m_job ); }
+
+    private:
+        JobThread* m_thread;
+        job_ptr m_job;
+    };
+
+    /* Called from a thread in the prepare pool. Failures are only
+     * logged: the jobs that use the results of a preparation need
+     * to do the work themselves if it is not there.
+     */
+    void runPrepareJob( const job_ptr& job )
+    {
+        CalamaresUtils::Trace::Span span( "prepare", job->prettyName() );
+        CancellationToken::setCurrent( &m_cancellation );
+        auto result = job->exec();
+        CancellationToken::setCurrent( nullptr );
+        span.setArgument( QStringLiteral( "ok" ), bool( result ) );
+        if ( result )
+        {
+            cDebug() << "Preparation" << job->prettyName() << "is done.";
+        }
+        else
+        {
+            cWarning() << "Preparation" << job->prettyName() << "failed:" << result.message();
+            cDebug() << Logger::SubEntry << result.details();
+        }
+    }
+
+    /* Called from applyWeights(), replaces the configured weights by
+     * measured durations where those are known. Jobs without a
+     * measurement get their configured weight, scaled so that it
+     * is comparable to the measured ones.
+     */
+    void applyProfile()
+    {
+        m_hasMeasuredWeights = false;
+        qreal measured = 0.0;
+        qreal configured = 0.0;
+        for ( const auto& jobitem : *m_runningJobs )
+        {
+            const qreal seconds = m_profile.estimate( jobitem.profileKey, jobitem.job->workSize() );
+            if ( seconds > 0 )
+            {
+                measured += seconds;
+                configured += jobitem.weight;
+            }
+        }
+        if ( measured <= 0 || configured <= 0 )
+        {
+            return;
+        }
+
+        m_hasMeasuredWeights = true;
+        const qreal scale = measured / configured;
+        qreal cumulative = 0.0;
+        for ( auto& jobitem : *m_runningJobs )
+        {
+            const qreal seconds = m_profile.estimate( jobitem.profileKey, jobitem.job->workSize() );
+            jobitem.cumulative = cumulative;
+            jobitem.weight = seconds > 0 ? seconds : jobitem.weight * scale;
+            cumulative += jobitem.weight;
+        }
+        cDebug() << "Using measured durations for job weights, estimated" << cumulative << "seconds";
+    }
+
+    /* Called from run() with m_stateMutex locked, before any job
+     * is started. Marks the jobs that succeeded in the earlier run
+     * as done, and restores global storage and the mounts from then.
      */
-    void emitProgress( qreal percentage ) const
+    void resumeFromCheckpoint()
+    {
+        JobCheckpoint previous;
+        if ( !previous.load() )
+        {
+            cWarning() << "There is no checkpoint to resume from, running all jobs.";
+            return;
+        }
+        if ( previous.sequence != m_checkpoint.sequence )
+        {
+            cWarning() << "The checkpoint is for different jobs, running all jobs.";
+            cDebug() << Logger::SubEntry << "Queue:" << m_jobKeys;
+            return;
+        }
+
+        cDebug() << "Resuming after" << previous.lastInstanceKey;
+        if ( !previous.restore( m_queue->globalStorage() ) )
+        {
+            m_failureEncountered = true;
+            m_message = tr( "The installation could not be resumed." );
+            m_details = tr( "The target system could not be mounted again." );
+            return;
+        }
+
+        for ( const auto& key : previous.doneJobs )
+        {
+            // Keys are not unique if a module has jobs with the same name
+            int index = m_jobKeys.indexOf( key );
+            while ( index >= 0 && m_states[ index ] != JobState::Waiting )
+            {
+                index = m_jobKeys.indexOf( key, index + 1 );
+            }
+            if ( index < 0 )
+            {
+                continue;
+            }
+            const auto& jobitem = m_runningJobs->at( index );
+            m_states[ index ] = JobState::Done;
+            m_remainingJobs--;
+            {
+                QMutexLocker plock( &m_progressMutex );
+                m_jobProgress[ index ] = 1.0;
+                m_progressSum += jobitem.weight;
+            }
+            m_checkpoint.doneJobs.append( key );
+        }
+        m_checkpoint.lastInstanceKey = previous.lastInstanceKey;
+        cDebug() << Logger::SubEntry << "Skipping" << m_checkpoint.doneJobs.count() << "jobs that are done.";
+    }
+
+    /* Called from runJob() with m_stateMutex locked. Emergency jobs
+     * are not recorded, since they need to run again after a
+     * resumed installation (e.g. to unmount the target system).
+     */
+    void saveCheckpoint( int index )
+    {
+        const auto& jobitem = m_runningJobs->at( index );
+        if ( jobitem.job->isEmergency() || m_failureEncountered )
+        {
+            return;
+        }
+        m_checkpoint.doneJobs.append( m_jobKeys.at( index ) );
+        m_checkpoint.lastInstanceKey = jobitem.constraints.instanceKey;
+        m_checkpoint.save( m_queue->globalStorage() );
+    }
+
+    /* Called at the end of run(), stores the durations of the jobs that succeeded */
+    void saveProfile()
+    {
+        bool changed = false;
+        for ( int i = 0; i < m_runningJobs->count(); ++i )
+        {
+            const auto& jobitem = m_runningJobs->at( i );
+            if ( !jobitem.profileKey.isEmpty() && m_durations[ i ] > 0 )
+            {
+                m_profile.record( jobitem.profileKey, m_durations[ i ], jobitem.job->workSize() );
+                changed = true;
+            }
+        }
+        if ( changed )
+        {
+            m_profile.save();
+        }
+    }
+
+    /* Called with m_stateMutex locked */
+    bool isReady( int index ) const
+    {
+        const auto& predecessors = m_runningJobs->at( index ).predecessors;
+        return std::all_of( predecessors.cbegin(), predecessors.cend(), [this]( int p ) {
+            return m_states[ p ] == JobState::Done || m_states[ p ] == JobState::Skipped;
+        } );
+    }
+
+    /* This is called from a worker thread, while run() holds m_runMutex,
+     * so m_runningJobs does not change underneath it.
+     */
+    void runJob( int index )
+    {
+        const auto& jobitem = m_runningJobs->at( index );
+        CalamaresUtils::Trace::Span span( "job", jobitem.job->prettyName() );
+        span.setArgument( QStringLiteral( "index" ), index + 1 );
+        span.setArgument( QStringLiteral( "weight" ), jobitem.weight );
+        span.setArgument( QStringLiteral( "emergency" ), jobitem.job->isEmergency() );
+        emitProgress( index, 0.0 );  // 0% for *this job*
+        auto connection = connect(
+            jobitem.job.data(),
+            &Job::progress,
+            jobitem.job.data(),
+            [ this, index ]( qreal percentage ) { emitProgress( index, percentage ); },
+            Qt::DirectConnection );
+        // Emergency jobs clean up (e.g. unmount the target system) and must not be cut short
+        CancellationToken::setCurrent( jobitem.job->isEmergency() ? nullptr : &m_cancellation );
+        QElapsedTimer timer;
+        timer.start();
+        auto result = jobitem.job->exec();
+        const qreal seconds = timer.elapsed() / 1000.0;
+        CancellationToken::setCurrent( nullptr );
+        disconnect( connection );
+        span.setArgument( QStringLiteral( "ok" ), bool( result ) );
+        if ( !result )
+        {
+            span.setArgument( QStringLiteral( "message" ), result.message() );
+        }
+        emitProgress( index, 1.0 );  // 100% for *this job*
+
+        QMutexLocker slock( &m_stateMutex );
+        if ( !m_failureEncountered && !result )
+        {
+            // so this is the first failure
+            m_failureEncountered = true;
+            m_message = result.message();
+            m_details = result.details();
+        }
+        m_states[ index ] = JobState::Done;
+        if ( result )
+        {
+            m_durations[ index ] = seconds;
+            saveCheckpoint( index );
+        }
+        m_activeJobs--;
+        m_remainingJobs--;
+        m_stateChanged.wakeAll();
+    }
+
+    /* This is called from the worker threads; overall progress is
+     * the weighted sum of the progress of each job, so that jobs
+     * running concurrently each contribute their share.
+     */
+    void emitProgress( int index, qreal percentage )
     {
         percentage = qBound( 0.0, percentage, 1.0 );
+        const auto& jobitem = m_runningJobs->at( index );
 
-        QString message;
         qreal progress = 0.0;
-        if ( m_jobIndex < m_runningJobs->count() )
         {
-            const auto& jobitem = m_runningJobs->at( m_jobIndex );
-            progress = ( jobitem.cumulative + jobitem.weight * percentage ) / m_overallQueueWeight;
+            QMutexLocker plock( &m_progressMutex );
+            m_progressSum += jobitem.weight * ( percentage - m_jobProgress[ index ] );
+            m_jobProgress[ index ] = percentage;
+            progress = m_progressSum;
+        }
+        progress = qBound( 0.0, progress / m_overallQueueWeight, 1.0 );
+
+        // Asking for the status message may be expensive (e.g. calling
+        // into Python), so do that at the start and end of the job and
+        // otherwise at most once per interval. The status entries for
+        // this job are only touched by the thread running it.
+        QString message;
+        const qint64 now = m_clock.elapsed();
+        if ( percentage == 0.0 || percentage == 1.0 || now - m_statusTimes[ index ] >= PROGRESS_INTERVAL )
+        {
+            m_statusTimes[ index ] = now;
+            CalamaresUtils::Trace::counter( "progress", jobitem.job->prettyName(), percentage );
             message = jobitem.job->prettyStatusMessage();
             // In progress reports at the start of a job (e.g. when the queue
             // starts the job, or if the job itself reports 0.0) be more
@@ -189,15 +675,40 @@ private:
                     message = jobitem.job->prettyName();
                 }
             }
+            if ( message == m_statusMessages[ index ] && percentage != 0.0 )
+            {
+                message.clear();  // Unchanged, no need to deliver it again
+            }
+            else if ( !message.isEmpty() )
+            {
+                m_statusMessages[ index ] = message;
+            }
         }
-        else
+        setProgress( progress, message );
+    }
+    /** @brief Replaces the pending progress report
+     *
+     * An empty @p message leaves the pending message alone, so that a
+     * status change is not lost when the report is coalesced with
+     * later ones. When not coalescing, every report is delivered.
+     */
+    void setProgress( qreal progress, const QString& message )
+    {
+        if ( !m_coalesceProgress )
         {
-            progress = 1.0;
-            message = tr( "Done" );
+            QMetaObject::invokeMethod(
+                m_queue, "progress", Qt::QueuedConnection, Q_ARG( qreal, progress ), Q_ARG( QString, message ) );
+            return;
         }
-        QMetaObject::invokeMethod(
-            m_queue, "progress", Qt::QueuedConnection, Q_ARG( qreal, progress ), Q_ARG( QString, message ) );
+        QMutexLocker lock( &m_reportMutex );
+        m_reportProgress = progress;
+        if ( !message.isEmpty() )
+        {
+            m_reportMessage = message;
+        }
+        m_reportPending = true;
     }
+    void emitDone() { setProgress( 1.0, tr( "Done" ) ); }
 
     mutable QMutex m_runMutex;
     mutable QMutex m_enqueMutex;
@@ -206,8 +717,44 @@ private:
     std::unique_ptr< WeightedJobList > m_queuedJobs = std::make_unique< WeightedJobList >();
 
     JobQueue* m_queue;
-    int m_jobIndex = 0;  ///< Index into m_runningJobs
+    int m_maxParallelJobs = 1;
     qreal m_overallQueueWeight = 0.0;  ///< cumulation when **all** the jobs are done
+
+    JobProfile m_profile;
+    bool m_hasMeasuredWeights = false;
+    bool m_resume = false;
+
+    // Scheduling state while running, protected by m_stateMutex
+    QMutex m_stateMutex;
+    QWaitCondition m_stateChanged;
+    QVector< JobState > m_states;  ///< One for each job in m_runningJobs
+    QVector< qreal > m_durations;  ///< Seconds, for jobs that succeeded
+    int m_remainingJobs = 0;  ///< Jobs not Done or Skipped yet
+    int m_activeJobs = 0;  ///< Jobs Running
+    bool m_failureEncountered = false;
+    QString m_message;  ///< Filled in with errors
+    QString m_details;
+    JobCheckpoint m_checkpoint;  ///< Jobs that succeeded so far
+    QStringList m_jobKeys;  ///< JobCheckpoint::jobKey() for each running job
+    CancellationToken m_cancellation;  ///< Also for the prepare jobs
+    QThreadPool m_preparePool;
+
+    // Progress of each running job, protected by m_progressMutex
+    QMutex m_progressMutex;
+    QVector< qreal > m_jobProgress;
+    qreal m_progressSum = 0.0;  ///< Weighted sum of m_jobProgress
+
+    // Status message last reported by each job, and when it was asked for
+    QVector< QString > m_statusMessages;
+    QVector< qint64 > m_statusTimes;
+    QElapsedTimer m_clock;
+
+    // Pending progress report, protected by m_reportMutex
+    QMutex m_reportMutex;
+    std::atomic< bool > m_reportPending { false };  ///< Checked without the lock
+    std::atomic< bool > m_coalesceProgress { true };
+    qreal m_reportProgress = 0.0;
+    QString m_reportMessage;
 };
 
 JobThread::~JobThread() {}
@@ -230,20 +777,37 @@ JobQueue::JobQueue( QObject* parent )
     : QObject( parent )
     , m_thread( new JobThread( this ) )
     , m_storage( new GlobalStorage( this ) )
+    , m_progressTimer( new QTimer( this ) )
 {
     Q_ASSERT( !s_instance );
     s_instance = this;
+
+    m_progressTimer->setInterval( PROGRESS_INTERVAL );
+    connect( m_progressTimer, &QTimer::timeout, this, &JobQueue::deliverProgress );
 }
 
 
 JobQueue::~JobQueue()
 {
+    if ( !m_thread->waitForPrepareJobs( 0 ) )
+    {
+        m_thread->cancel();
+        if ( !m_thread->waitForPrepareJobs( int( SHUTDOWN_TIMEOUT ) ) )
+        {
+            cError() << "Preparations did not stop after cancellation.";
+        }
+    }
     if ( m_thread->isRunning() )
     {
-        m_thread->terminate();
-        if ( !m_thread->wait( 300 ) )
+        m_thread->cancel();
+        if ( !m_thread->wait( SHUTDOWN_TIMEOUT ) )
         {
-            cError() << "Could not terminate job thread (expect a crash now).";
+            cError() << "Job thread did not stop after cancellation, terminating it.";
+            m_thread->terminate();
+            if ( !m_thread->wait( 300 ) )
+            {
+                cError() << "Could not terminate job thread (expect a crash now).";
+            }
         }
         delete m_thread;
     }
@@ -258,26 +822,93 @@ JobQueue::start()
     Q_ASSERT( !m_thread->isRunning() );
     m_thread->finalize();
     m_finished = false;
+    if ( m_progressTimer->interval() > 0 )
+    {
+        m_progressTimer->start();
+    }
     m_thread->start();
 }
 
 
 void
 JobQueue::enqueue( int moduleWeight, const JobList& jobs )
+{
+    enqueue( moduleWeight, jobs, JobConstraints() );
+}
+
+
+void
+JobQueue::enqueue( int moduleWeight, const JobList& jobs, const JobConstraints& constraints )
 {
     Q_ASSERT( !m_thread->isRunning() );
-    m_thread->enqueue( moduleWeight, jobs );
+    m_thread->enqueue( moduleWeight, jobs, constraints );
     emit queueChanged( m_thread->queuedJobs() );
 }
 
+
+bool
+JobQueue::hasMeasuredWeights() const
+{
+    return m_thread->hasMeasuredWeights();
+}
+
+
+void
+JobQueue::setMaximumParallelJobs( int n )
+{
+    Q_ASSERT( !m_thread->isRunning() );
+    m_thread->setMaximumParallelJobs( n );
+}
+
+void
+JobQueue::setProgressInterval( int msecs )
+{
+    Q_ASSERT( !m_thread->isRunning() );
+    m_progressTimer->setInterval( qMax( msecs, 0 ) );
+    m_thread->setCoalesceProgress( msecs > 0 );
+}
+
+void
+JobQueue::setResumeFromCheckpoint( bool resume )
+{
+    Q_ASSERT( !m_thread->isRunning() );
+    m_thread->setResumeFromCheckpoint( resume );
+}
+
+void
+JobQueue::prepare( const JobList& jobs )
+{
+    m_thread->prepare( jobs );
+}
+
+
+void
+JobQueue::cancel()
+{
+    m_thread->cancel();
+}
+
 void
 JobQueue::finish()
 {
+    m_progressTimer->stop();
+    deliverProgress();
     m_finished = true;
     emit finished();
     emit queueChanged( m_thread->queuedJobs() );
 }
 
+void
+JobQueue::deliverProgress()
+{
+    qreal percent = 0.0;
+    QString message;
+    if ( m_thread->takeProgress( percent, message ) )
+    {
+        emit progress( percent, message );
+    }
+}
+
 GlobalStorage*
 JobQueue::globalStorage() const
 {
@@ -14,12 +14,40 @@
 #include "Job.h"
 
 #include <QObject>
+#include <QStringList>
+
+class QTimer;
 
 namespace Calamares
 {
 class GlobalStorage;
 class JobThread;
 
+/** @brief Scheduling constraints for the jobs of one module instance
+ *
+ * Jobs enqueued without constraints (the default) act as barriers:
+ * they start only once every job enqueued before them has finished,
+ * and every job enqueued after them waits for them. Jobs with
+ * constraints may run concurrently with other constrained jobs,
+ * unless
+ *  - they come from the same enqueue() call (those stay in order),
+ *  - one names the other's module in *after*, or
+ *  - they share a resource that at least one of them lists in *outputs*.
+ *
+ * Resources are free-form strings; the convention is to use paths
+ * in the target system (e.g. "/etc/locale.conf") or globalstorage keys.
+ */
+struct DLLEXPORT JobConstraints
+{
+    QString instanceKey;  ///< Identifies the jobs in the job profile, see JobProfile
+    QString moduleName;  ///< Matched against *after* of later jobs
+    QStringList after;
+    QStringList inputs;
+    QStringList outputs;
+
+    bool isSchedulable() const { return !after.isEmpty() || !inputs.isEmpty() || !outputs.isEmpty(); }
+};
+
 class DLLEXPORT JobQueue : public QObject
 {
     Q_OBJECT
@@ -37,6 +65,24 @@ public:
      * of the module.
      */
     void enqueue( int moduleWeight, const JobList& jobs );
+    /** @brief Queues up jobs from a single module source, with constraints
+     *
+     * As above, but the jobs may be scheduled concurrently with other
+     * jobs, as far as the @p constraints allow.
+     */
+    void enqueue( int moduleWeight, const JobList& jobs, const JobConstraints& constraints );
+    /** @brief Runs @p jobs in the background, right away
+     *
+     * This is for work that is safe to do before the user has agreed
+     * to install (it must not touch the disks being installed to),
+     * e.g. downloading or verifying the image, while the user is busy
+     * with the rest of the UI. The jobs hand their results to the jobs
+     * that run later through GlobalStorage.
+     *
+     * These jobs run concurrently, and independently of the queue;
+     * failures are only logged. start() waits until they are done.
+     */
+    void prepare( const JobList& jobs );
     /** @brief Starts all the jobs that are enqueued.
      *
      * After this, isRunning() returns @c true until
@@ -46,6 +92,52 @@ public:
 
     bool isRunning() const { return !m_finished; }
 
+    /** @brief Stops the jobs that are running, and skips the rest
+     *
+     * The running jobs (and jobs given to prepare()) are asked to
+     * stop (see CancellationToken) and commands they run are killed.
+     * Emergency jobs still run.
+     * The queue then emits failed() and finished(), as usual.
+     * When the queue is destroyed while running, it is cancelled
+     * and given some time to stop.
+     */
+    void cancel();
+
+    /** @brief Sets the number of jobs that may run at the same time.
+     *
+     * Values less than 1 select the number of CPU cores. Only
+     * jobs enqueued with constraints are ever run concurrently.
+     */
+    void setMaximumParallelJobs( int n );
+
+    /** @brief Sets the interval (ms) at which progress is delivered
+     *
+     * Progress reports from the jobs are coalesced and delivered
+     * by a timer, about 60 times per second. An interval of 0
+     * delivers every report, in order; that is mostly for testing.
+     */
+    void setProgressInterval( int msecs );
+
+    /** @brief Is progress based on measured durations?
+     *
+     * When durations of (some of) the jobs were measured in an earlier
+     * run, the queue uses them instead of the configured weights, so that
+     * progress is proportional to time. This is valid once the queue
+     * reports progress, since the weights are computed after the
+     * preparations (see Job::workSize()) are done.
+     */
+    bool hasMeasuredWeights() const;
+
+    /** @brief Continue an installation that failed
+     *
+     * The queue writes a checkpoint after each job that succeeds
+     * (see JobCheckpoint). When resuming, start() restores global storage
+     * and the mounts of the target system from the checkpoint, and
+     * skips the jobs that succeeded then. This only happens if the
+     * checkpoint was written for the same jobs as are in the queue now.
+     */
+    void setResumeFromCheckpoint( bool resume );
+
 signals:
     /** @brief Report progress of the whole queue, with a status message
      *
@@ -53,6 +145,11 @@ signals:
      * overall queue progress (not of the current job), while
      * @p prettyName is the status message from the job -- often
      * just the name of the job, but some jobs include more information.
+     * The message is empty if it has not changed since the last report.
+     *
+     * Progress reports from the jobs are coalesced: this is emitted
+     * at most about 60 times per second, with the most recent progress
+     * (see setProgressInterval()).
      */
     void progress( qreal percent, const QString& prettyName );
     /** @brief Indicate that the queue is empty, after calling start()
@@ -85,11 +182,16 @@ public slots:
      */
     void finish();
 
+private slots:
+    /// @brief Emits progress(), if the job thread has reported any
+    void deliverProgress();
+
 private:
     static JobQueue* s_instance;
 
     JobThread* m_thread;
     GlobalStorage* m_storage;
+    QTimer* m_progressTimer;
     bool m_finished = true;  ///< Initially, not running
 };
 
@@ -16,6 +16,9 @@
 
 #include <QDir>
 #include <QFileInfo>
+#include <QPointer>
+
+#include <mutex>
 
 namespace bp = boost::python;
 
@@ -214,26 +217,39 @@ Helper::Helper()
     : QObject( nullptr )
 {
     // Let's make extra sure we only call Py_Initialize once
+    bool initializedHere = false;
     if ( !Py_IsInitialized() )
     {
-        Py_Initialize();
+        Py_Initialize();  // Also sets up the GIL, since Python 3.7
+        initializedHere = true;
     }
 
-    m_mainModule = bp::import( "__main__" );
-    m_mainNamespace = m_mainModule.attr( "__dict__" );
+    {
+        GILScopedAcquire gil;
+
+        m_mainModule = bp::import( "__main__" );
+        m_mainNamespace = m_mainModule.attr( "__dict__" );
 
-    // If we're running from the build dir
-    add_if_lib_exists( QDir::current(), "libcalamares.so", m_pythonPaths );
+        // If we're running from the build dir
+        add_if_lib_exists( QDir::current(), "libcalamares.so", m_pythonPaths );
 
-    QDir calaPythonPath( CalamaresUtils::systemLibDir().absolutePath() + QDir::separator() + "calamares" );
-    add_if_lib_exists( calaPythonPath, "libcalamares.so", m_pythonPaths );
+        QDir calaPythonPath( CalamaresUtils::systemLibDir().absolutePath() + QDir::separator() + "calamares" );
+        add_if_lib_exists( calaPythonPath, "libcalamares.so", m_pythonPaths );
 
-    bp::object sys = bp::import( "sys" );
+        bp::object sys = bp::import( "sys" );
 
-    foreach ( QString path, m_pythonPaths )
+        foreach ( QString path, m_pythonPaths )
+        {
+            bp::str dir = path.toLocal8Bit().data();
+            sys.attr( "path" ).attr( "append" )( dir );
+        }
+    }
+
+    if ( initializedHere )
     {
-        bp::str dir = path.toLocal8Bit().data();
-        sys.attr( "path" ).attr( "append" )( dir );
+        // Py_Initialize() leaves this thread holding the GIL; release it
+        // so that Python jobs on any thread can take it (see GILScopedAcquire).
+        PyEval_SaveThread();
     }
 }
 
@@ -242,12 +258,11 @@ Helper::~Helper() {}
 Helper*
 Helper::instance()
 {
+    // Python jobs may start on several threads at once
+    static std::once_flag s_once;
     static Helper* s_helper = nullptr;
 
-    if ( !s_helper )
-    {
-        s_helper = new Helper;
-    }
+    std::call_once( s_once, []() { s_helper = new Helper; } );
     return s_helper;
 }
 
@@ -378,6 +393,196 @@ Helper::handleLastError()
     return QString( "<div>%1</div>" ).arg( msgList.join( "</div><div>" ) );
 }
 
+/// @brief Raises a Python exception of the given @p type
+[[noreturn]] static void
+raiseError( PyObject* type, const std::string& message )
+{
+    PyErr_SetString( type, message.c_str() );
+    throw bp::error_already_set();
+}
+
+VariantView::VariantView( const QVariant& v )
+    : m_variant( v )
+{
+}
+
+bool
+VariantView::isContainer( const QVariant& v )
+{
+    return v.type() == QVariant::Map || v.type() == QVariant::List || v.type() == QVariant::StringList;
+}
+
+bp::object
+VariantView::wrap( const QVariant& v )
+{
+    return isContainer( v ) ? bp::object( VariantView( v ) ) : variantToPyObject( v );
+}
+
+int
+VariantView::length() const
+{
+    return isMap() ? m_variant.toMap().count() : m_variant.toList().count();
+}
+
+bp::object
+VariantView::getItem( const bp::object& key ) const
+{
+    if ( isMap() )
+    {
+        bp::extract< std::string > k( key );
+        if ( k.check() )
+        {
+            const auto map = m_variant.toMap();
+            auto it = map.constFind( QString::fromStdString( k() ) );
+            if ( it != map.constEnd() )
+            {
+                return wrap( it.value() );
+            }
+        }
+        raiseError( PyExc_KeyError, bp::extract< std::string >( bp::str( key ) ) );
+    }
+
+    bp::extract< int > index( key );
+    if ( !index.check() )
+    {
+        // Slices and such
+        return copy()[ key ];
+    }
+    const auto list = m_variant.toList();
+    const int i = index() < 0 ? index() + list.count() : index();
+    if ( i < 0 || i >= list.count() )
+    {
+        raiseError( PyExc_IndexError, "list index out of range" );
+    }
+    return wrap( list.at( i ) );
+}
+
+bp::object
+VariantView::get( const std::string& key, const bp::object& fallback ) const
+{
+    if ( !isMap() )
+    {
+        raiseError( PyExc_AttributeError, "list has no attribute 'get'" );
+    }
+    const auto map = m_variant.toMap();
+    auto it = map.constFind( QString::fromStdString( key ) );
+    return it != map.constEnd() ? wrap( it.value() ) : fallback;
+}
+
+bool
+VariantView::contains( const bp::object& key ) const
+{
+    if ( isMap() )
+    {
+        bp::extract< std::string > k( key );
+        return k.check() && m_variant.toMap().contains( QString::fromStdString( k() ) );
+    }
+    for ( const auto& v : m_variant.toList() )
+    {
+        if ( wrap( v ) == key )
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+bp::object
+VariantView::iter() const
+{
+    // Like a dict, iterating over a map gives the keys
+    const bp::list l = isMap() ? keys() : values();
+    return bp::object( bp::handle<>( PyObject_GetIter( l.ptr() ) ) );
+}
+
+bp::list
+VariantView::keys() const
+{
+    bp::list l;
+    if ( isMap() )
+    {
+        const auto map = m_variant.toMap();
+        for ( auto it = map.constBegin(); it != map.constEnd(); ++it )
+        {
+            l.append( it.key().toStdString() );
+        }
+    }
+    return l;
+}
+
+bp::list
+VariantView::values() const
+{
+    bp::list l;
+    if ( isMap() )
+    {
+        const auto map = m_variant.toMap();
+        for ( auto it = map.constBegin(); it != map.constEnd(); ++it )
+        {
+            l.append( wrap( it.value() ) );
+        }
+    }
+    else
+    {
+        for ( const auto& v : m_variant.toList() )
+        {
+            l.append( wrap( v ) );
+        }
+    }
+    return l;
+}
+
+bp::list
+VariantView::items() const
+{
+    bp::list l;
+    if ( isMap() )
+    {
+        const auto map = m_variant.toMap();
+        for ( auto it = map.constBegin(); it != map.constEnd(); ++it )
+        {
+            l.append( bp::make_tuple( it.key().toStdString(), wrap( it.value() ) ) );
+        }
+    }
+    return l;
+}
+
+bp::object
+VariantView::copy() const
+{
+    return variantToPyObject( m_variant );
+}
+
+bp::object
+VariantView::add( const bp::object& other ) const
+{
+    return copy() + other;
+}
+
+bp::object
+VariantView::radd( const bp::object& other ) const
+{
+    return other + copy();
+}
+
+bool
+VariantView::equals( const bp::object& other ) const
+{
+    bp::extract< const VariantView& > view( other );
+    if ( view.check() )
+    {
+        return m_variant == view().m_variant;
+    }
+    return bool( copy() == other );
+}
+
+std::string
+VariantView::repr() const
+{
+    return bp::extract< std::string >( bp::str( copy() ) );
+}
+
+
 Calamares::GlobalStorage* GlobalStoragePythonWrapper::s_gs_instance = nullptr;
 
 // The special handling for nullptr is only for the testing
@@ -438,7 +643,72 @@ GlobalStoragePythonWrapper::remove( const std::string& key )
 bp::object
 GlobalStoragePythonWrapper::value( const std::string& key ) const
 {
-    return CalamaresPython::variantToPyObject( m_gs->value( QString::fromStdString( key ) ) );
+    return cached( key, false );
+}
+
+
+bp::object
+GlobalStoragePythonWrapper::view( const std::string& key ) const
+{
+    return cached( key, true );
+}
+
+
+bp::object
+GlobalStoragePythonWrapper::cached( const std::string& key, bool containers ) const
+{
+    const QString k = QString::fromStdString( key );
+    const auto s = m_gs->snapshot();
+    const QVariant v = s->data.value( k );
+    if ( !containers && VariantView::isContainer( v ) )
+    {
+        // Plain lists and dicts can be modified by the caller, so they can't be shared
+        return CalamaresPython::variantToPyObject( v );
+    }
+
+    const quint64 version = s->keyVersion( k );
+    Cache& values = cache();
+    auto it = values.constFind( k );
+    if ( it != values.constEnd() && it->version == version )
+    {
+        return it->object;
+    }
+    CachedValue c { version, VariantView::wrap( v ) };
+    values.insert( k, c );
+    return c.object;
+}
+
+GlobalStoragePythonWrapper::Cache&
+GlobalStoragePythonWrapper::cache() const
+{
+    struct StorageCache
+    {
+        QPointer< Calamares::GlobalStorage > storage;  ///< Null once the storage is gone
+        Cache values;
+    };
+    // Never freed: the Python objects may only be released with the GIL held.
+    static auto* caches = new QHash< const Calamares::GlobalStorage*, StorageCache >;
+
+    // Versions are per storage, so drop the caches of storages that are
+    // gone; a new storage may have the same address.
+    for ( auto it = caches->begin(); it != caches->end(); )
+    {
+        if ( it->storage.isNull() )
+        {
+            it = caches->erase( it );
+        }
+        else
+        {
+            ++it;
+        }
+    }
+
+    StorageCache& c = ( *caches )[ m_gs ];
+    if ( c.storage.isNull() )
+    {
+        c.storage = m_gs;
+    }
+    return c.values;
 }
 
 }  // namespace CalamaresPython
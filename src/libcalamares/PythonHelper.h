@@ -14,6 +14,7 @@
 #include "PythonJob.h"
 #include "utils/BoostPython.h"
 
+#include <QHash>
 #include <QStringList>
 
 namespace Calamares
@@ -37,6 +38,43 @@ boost::python::dict variantHashToPyDict( const QVariantHash& variantHash );
 QVariantHash variantHashFromPyDict( const boost::python::dict& pyDict );
 
 
+/** @brief RAII for holding the Python interpreter lock (GIL)
+ *
+ * Python jobs may run on any of the job queue's worker threads,
+ * so Python code is only run while holding the GIL.
+ */
+class GILScopedAcquire
+{
+public:
+    GILScopedAcquire()
+        : m_state( PyGILState_Ensure() )
+    {
+    }
+    ~GILScopedAcquire() { PyGILState_Release( m_state ); }
+
+private:
+    PyGILState_STATE m_state;
+};
+
+/** @brief RAII for releasing the GIL around a blocking call
+ *
+ * Use this (with the GIL held) around C++ code that does not touch
+ * Python objects and may take long, e.g. running a command, so that
+ * other Python jobs can continue.
+ */
+class GILScopedRelease
+{
+public:
+    GILScopedRelease()
+        : m_state( PyEval_SaveThread() )
+    {
+    }
+    ~GILScopedRelease() { PyEval_RestoreThread( m_state ); }
+
+private:
+    PyThreadState* m_state;
+};
+
 class Helper : public QObject
 {
     Q_OBJECT
@@ -57,6 +95,47 @@ private:
     QStringList m_pythonPaths;
 };
 
+/** @brief Read-only view of a list or map, for Python
+ *
+ * This behaves like a (read-only) Python list or dict, but converts
+ * the values only when they are accessed; nested lists and maps
+ * are views as well. Since the underlying QVariant is implicitly
+ * shared, making a view does not copy any data.
+ *
+ * Use copy() to get a plain Python list or dict that can be modified.
+ */
+class VariantView
+{
+public:
+    explicit VariantView( const QVariant& v );
+
+    /// @brief Is @p v a list or map (for which a view makes sense)?
+    static bool isContainer( const QVariant& v );
+    /// @brief A view if @p v is a container, otherwise the converted value
+    static boost::python::api::object wrap( const QVariant& v );
+
+    int length() const;
+    boost::python::api::object getItem( const boost::python::api::object& key ) const;
+    boost::python::api::object get( const std::string& key, const boost::python::api::object& fallback ) const;
+    bool contains( const boost::python::api::object& key ) const;
+    boost::python::api::object iter() const;
+
+    boost::python::list keys() const;
+    boost::python::list values() const;
+    boost::python::list items() const;
+
+    boost::python::api::object copy() const;
+    boost::python::api::object add( const boost::python::api::object& other ) const;
+    boost::python::api::object radd( const boost::python::api::object& other ) const;
+    bool equals( const boost::python::api::object& other ) const;
+    std::string repr() const;
+
+private:
+    bool isMap() const { return m_variant.type() == QVariant::Map; }
+
+    QVariant m_variant;
+};
+
 class GlobalStoragePythonWrapper
 {
 public:
@@ -67,7 +146,20 @@ public:
     void insert( const std::string& key, const boost::python::api::object& value );
     boost::python::list keys() const;
     int remove( const std::string& key );
+    /** @brief The value of @p key, converted to Python objects
+     *
+     * Lists and maps are converted completely, on each call, and may be
+     * modified by the caller. Other values are cached until the
+     * key changes.
+     */
     boost::python::api::object value( const std::string& key ) const;
+    /** @brief A read-only view of the value of @p key
+     *
+     * Lists and maps are returned as a VariantView, other values
+     * as with value(). The result is cached until the key changes,
+     * so reading a large value (e.g. "partitions") repeatedly is cheap.
+     */
+    boost::python::api::object view( const std::string& key ) const;
 
     // This is a helper for scripts that do not go through
     // the JobQueue (i.e. the module testpython script),
@@ -75,6 +167,22 @@ public:
     static Calamares::GlobalStorage* globalStorageInstance() { return s_gs_instance; }
 
 private:
+    struct CachedValue
+    {
+        quint64 version = 0;  ///< From GlobalStorage::Snapshot::keyVersion()
+        boost::python::api::object object;
+    };
+    using Cache = QHash< QString, CachedValue >;
+
+    boost::python::api::object cached( const std::string& key, bool containers ) const;
+    /** @brief The cached values for m_gs
+     *
+     * Each job gets a wrapper of its own, so the cache is kept per
+     * GlobalStorage instead, for all the jobs. Only use this with
+     * the GIL held.
+     */
+    Cache& cache() const;
+
     Calamares::GlobalStorage* m_gs;
     static Calamares::GlobalStorage* s_gs_instance;  // See globalStorageInstance()
 };
@@ -18,6 +18,7 @@
 #include "utils/Logger.h"
 
 #include <QDir>
+#include <QElapsedTimer>
 
 namespace bp = boost::python;
 
@@ -34,6 +35,56 @@ BOOST_PYTHON_FUNCTION_OVERLOADS( check_target_env_output_list_overloads,
                                  CalamaresPython::check_target_env_output,
                                  1,
                                  3 );
+BOOST_PYTHON_FUNCTION_OVERLOADS( target_env_output_lines_overloads, CalamaresPython::target_env_output_lines, 1, 4 );
+
+/// @brief Python iterators return themselves from __iter__
+static bp::object
+pass_through( const bp::object& o )
+{
+    return o;
+}
+/** @brief The libcalamares.job object of the Python job running on this thread
+ *
+ * Python jobs may run concurrently on different threads, so *job* is not
+ * a plain attribute of the libcalamares module: it is looked up through
+ * the module-level __getattr__ (PEP 562, so Python 3.7 or later) instead.
+ */
+static thread_local bp::object* s_currentJobInterface = nullptr;
+
+static bp::object
+libcalamares_getattr( const std::string& name )
+{
+    if ( name == "job" && s_currentJobInterface )
+    {
+        return *s_currentJobInterface;
+    }
+    PyErr_SetString( PyExc_AttributeError, name.c_str() );
+    bp::throw_error_already_set();
+    return bp::object();
+}
+
+/** @brief The public names in the libcalamares module @p ns, for __all__
+ *
+ * Star-imports look up the names in __all__ with getattr(), so
+ * *job* is found, too, even though it is not in the module dict.
+ */
+static bp::list
+libcalamares_all( const bp::dict& ns )
+{
+    bp::list all;
+    const bp::list keys = ns.keys();
+    for ( bp::ssize_t i = 0; i < bp::len( keys ); ++i )
+    {
+        bp::extract< std::string > key( keys[ i ] );
+        if ( key.check() && !key().empty() && key()[ 0 ] != '_' )
+        {
+            all.append( keys[ i ] );
+        }
+    }
+    all.append( "job" );
+    return all;
+}
+
 BOOST_PYTHON_MODULE( libcalamares )
 {
     bp::object package = bp::scope();
@@ -45,6 +96,7 @@ BOOST_PYTHON_MODULE( libcalamares )
     bp::scope().attr( "VERSION" ) = CALAMARES_VERSION;
     bp::scope().attr( "VERSION_SHORT" ) = CALAMARES_VERSION_SHORT;
 
+    bp::def( "__getattr__", &libcalamares_getattr );
     bp::class_< CalamaresPython::PythonJobInterface >( "Job", bp::init< Calamares::PythonJob* >() )
         .def_readonly( "module_name", &CalamaresPython::PythonJobInterface::moduleName )
         .def_readonly( "pretty_name", &CalamaresPython::PythonJobInterface::prettyName )
@@ -54,7 +106,17 @@ BOOST_PYTHON_MODULE( libcalamares )
               &CalamaresPython::PythonJobInterface::setprogress,
               bp::args( "progress" ),
               "Reports the progress status of this job to Calamares, "
-              "as a real number between 0 and 1." );
+              "as a real number between 0 and 1." )
+        .def( "is_cancelled",
+              &CalamaresPython::PythonJobInterface::isCancelled,
+              "Returns True if the installation was cancelled; long-running "
+              "jobs should check this regularly and return an error." )
+        .def( "set_work_size",
+              &CalamaresPython::PythonJobInterface::setWorkSize,
+              bp::args( "size" ),
+              "Tells Calamares how much work (e.g. files to copy) run() "
+              "does, to scale the duration measured in earlier runs. "
+              "Usually called from prepare()." );
 
     bp::class_< CalamaresPython::GlobalStoragePythonWrapper >( "GlobalStorage",
                                                                bp::init< Calamares::GlobalStorage* >() )
@@ -63,7 +125,31 @@ BOOST_PYTHON_MODULE( libcalamares )
         .def( "insert", &CalamaresPython::GlobalStoragePythonWrapper::insert )
         .def( "keys", &CalamaresPython::GlobalStoragePythonWrapper::keys )
         .def( "remove", &CalamaresPython::GlobalStoragePythonWrapper::remove )
-        .def( "value", &CalamaresPython::GlobalStoragePythonWrapper::value );
+        .def( "value", &CalamaresPython::GlobalStoragePythonWrapper::value )
+        .def( "view",
+              &CalamaresPython::GlobalStoragePythonWrapper::view,
+              bp::args( "key" ),
+              "Returns a read-only view of the value of key; lists and "
+              "dicts are converted only as far as they are used. Use "
+              "copy() on the view for a list or dict that can be modified." );
+
+    bp::class_< CalamaresPython::VariantView >( "VariantView", bp::no_init )
+        .def( "__len__", &CalamaresPython::VariantView::length )
+        .def( "__getitem__", &CalamaresPython::VariantView::getItem )
+        .def( "__contains__", &CalamaresPython::VariantView::contains )
+        .def( "__iter__", &CalamaresPython::VariantView::iter )
+        .def( "__eq__", &CalamaresPython::VariantView::equals )
+        .def( "__add__", &CalamaresPython::VariantView::add )
+        .def( "__radd__", &CalamaresPython::VariantView::radd )
+        .def( "__repr__", &CalamaresPython::VariantView::repr )
+        .def( "__str__", &CalamaresPython::VariantView::repr )
+        .def( "get",
+              &CalamaresPython::VariantView::get,
+              ( bp::arg( "key" ), bp::arg( "default" ) = bp::object() ) )
+        .def( "keys", &CalamaresPython::VariantView::keys )
+        .def( "values", &CalamaresPython::VariantView::values )
+        .def( "items", &CalamaresPython::VariantView::items )
+        .def( "copy", &CalamaresPython::VariantView::copy );
 
     // libcalamares.utils submodule starts here
     bp::object utilsModule( bp::handle<>( bp::borrowed( PyImport_AddModule( "libcalamares.utils" ) ) ) );
@@ -135,6 +221,24 @@ BOOST_PYTHON_MODULE( libcalamares )
                                                      "Runs the specified command in the chroot of the target system.\n"
                                                      "Returns the program's standard output, and raises a "
                                                      "subprocess.CalledProcessError if something went wrong." ) );
+    bp::def( "target_env_output_lines",
+             &CalamaresPython::target_env_output_lines,
+             target_env_output_lines_overloads(
+                 bp::args( "args", "stdin", "timeout", "keep_input_open" ),
+                 "Runs the specified command in the chroot of the target system.\n"
+                 "Returns an iterator over the lines of output, as they are produced; "
+                 "at the end, raises a subprocess.CalledProcessError if something went wrong. "
+                 "If keep_input_open is True, use write() and close_input() on the "
+                 "iterator to send more standard input." ) );
+    bp::class_< CalamaresPython::ProcessLines >( "ProcessLines", bp::no_init )
+        .def( "__iter__", &pass_through )
+        .def( "__next__", &CalamaresPython::ProcessLines::next )
+        .def( "write", &CalamaresPython::ProcessLines::write, bp::args( "data" ) )
+        .def( "close_input", &CalamaresPython::ProcessLines::closeInput )
+        .def( "wait",
+              &CalamaresPython::ProcessLines::wait,
+              "Waits for the command to finish and returns its exit code." );
+
     bp::def( "obscure",
              &CalamaresPython::obscure,
              bp::args( "s" ),
@@ -155,9 +259,18 @@ BOOST_PYTHON_MODULE( libcalamares )
 namespace Calamares
 {
 
+/** @brief Interval (ms) at which pretty_status_message() is called
+ *
+ * A script may call setprogress() for every file it copies; the status
+ * text only needs to be readable, so it is not asked for on each call.
+ */
+static constexpr qint64 STATUS_INTERVAL = 100;
+
 struct PythonJob::Private
 {
     bp::object m_prettyStatusMessage;
+    bp::object m_jobInterface;  ///< libcalamares.job while this job runs
+    QElapsedTimer m_statusClock;  ///< Since the last pretty_status_message() call
 };
 
 PythonJob::PythonJob( const QString& scriptFile,
@@ -170,11 +283,20 @@ PythonJob::PythonJob( const QString& scriptFile,
     , m_workingPath( workingPath )
     , m_description()
     , m_configurationMap( moduleConfiguration )
+    , m_workSize( std::make_shared< std::atomic< qint64 > >( 0 ) )
 {
 }
 
 
-PythonJob::~PythonJob() {}
+PythonJob::~PythonJob()
+{
+    if ( Py_IsInitialized() )
+    {
+        // The Python objects held by the job are released with the GIL held
+        CalamaresPython::GILScopedAcquire gil;
+        m_d.reset();
+    }
+}
 
 QString
 PythonJob::prettyName() const
@@ -183,6 +305,13 @@ PythonJob::prettyName() const
 }
 
 
+qint64
+PythonJob::workSize() const
+{
+    return m_workSize->load();
+}
+
+
 QString
 PythonJob::prettyStatusMessage() const
 {
@@ -231,23 +360,35 @@ PythonJob::exec()
                                      .arg( prettyName() ) );
     }
 
+    // Make sure the interpreter exists before taking the GIL
+    CalamaresPython::Helper* helper = CalamaresPython::Helper::instance();
+    CalamaresPython::GILScopedAcquire gil;
+    struct CurrentJob
+    {
+        CurrentJob( bp::object* o ) { s_currentJobInterface = o; }
+        ~CurrentJob() { s_currentJobInterface = nullptr; }
+    };
+
     try
     {
-        bp::dict scriptNamespace = CalamaresPython::Helper::instance()->createCleanNamespace();
+        bp::dict scriptNamespace = helper->createCleanNamespace();
 
         bp::object calamaresModule = bp::import( "libcalamares" );
         bp::dict calamaresNamespace = bp::extract< bp::dict >( calamaresModule.attr( "__dict__" ) );
 
-        calamaresNamespace[ "job" ] = CalamaresPython::PythonJobInterface( this );
+        m_d->m_jobInterface = bp::object( CalamaresPython::PythonJobInterface( this ) );
+        CurrentJob currentJob( &m_d->m_jobInterface );
         calamaresNamespace[ "globalstorage" ]
             = CalamaresPython::GlobalStoragePythonWrapper( JobQueue::instance()->globalStorage() );
+        calamaresNamespace[ "__all__" ] = libcalamares_all( calamaresNamespace );
 
         cDebug() << "Job file" << scriptFI.absoluteFilePath();
         bp::object execResult
             = bp::exec_file( scriptFI.absoluteFilePath().toLocal8Bit().data(), scriptNamespace, scriptNamespace );
-        bp::object entryPoint = scriptNamespace[ "run" ];
+        bp::object entryPoint = scriptNamespace[ m_entryPoint.toStdString() ];
 
         m_d->m_prettyStatusMessage = scriptNamespace.get( "pretty_status_message", bp::object() );
+        m_d->m_statusClock.invalidate();
         m_description = pythonStringMethod( scriptNamespace, "pretty_name" );
         if ( m_description.isEmpty() )
         {
@@ -306,8 +447,14 @@ PythonJob::emitProgress( qreal progressValue )
     // so it is safe to call into the Python interpreter. Update the description
     // as needed (don't call this from prettyStatusMessage(), which can be
     // called from other threads as well).
-    if ( m_d && !m_d->m_prettyStatusMessage.is_none() )
+    //
+    // Calling into Python is slow, so that is done at the start and end of the
+    // job and otherwise at most once every STATUS_INTERVAL.
+    if ( m_d && !m_d->m_prettyStatusMessage.is_none()
+         && ( progressValue <= 0.0 || progressValue >= 1.0 || !m_d->m_statusClock.isValid()
+              || m_d->m_statusClock.elapsed() >= STATUS_INTERVAL ) )
     {
+        m_d->m_statusClock.start();
         QString r;
         bp::extract< std::string > result( m_d->m_prettyStatusMessage() );
         r = result.check() ? QString::fromStdString( result() ).trimmed() : QString();
@@ -16,6 +16,7 @@
 
 #include <QVariantMap>
 
+#include <atomic>
 #include <memory>
 
 namespace CalamaresPython
@@ -40,6 +41,23 @@ public:
     QString prettyName() const override;
     QString prettyStatusMessage() const override;
     JobResult exec() override;
+    qint64 workSize() const override;
+
+    /** @brief Call a different function from the script than run()
+     *
+     * This is used for the prepare() function of Python modules,
+     * which runs in the background, see JobQueue::prepare().
+     */
+    void setEntryPoint( const QString& name ) { m_entryPoint = name; }
+
+    /** @brief Share the work size with @p other
+     *
+     * The prepare() function of a Python module usually finds out
+     * how much work run() is going to do. The two are different
+     * jobs, so the prepare job shares the work size it reports
+     * (with libcalamares.job.set_work_size()) with the run job.
+     */
+    void shareWorkSize( const PythonJob& other ) { m_workSize = other.m_workSize; }
 
 private:
     struct Private;
@@ -52,6 +70,8 @@ private:
     QString m_workingPath;
     QString m_description;
     QVariantMap m_configurationMap;
+    QString m_entryPoint = QStringLiteral( "run" );
+    std::shared_ptr< std::atomic< qint64 > > m_workSize;
 };
 
 }  // namespace Calamares
@@ -55,6 +55,7 @@ mount( const std::string& device_path,
        const std::string& filesystem_name,
        const std::string& options )
 {
+    GILScopedRelease nogil;
     return CalamaresUtils::Partition::mount( QString::fromStdString( device_path ),
                                              QString::fromStdString( mount_point ),
                                              QString::fromStdString( filesystem_name ),
@@ -76,6 +77,8 @@ _bp_list_to_qstringlist( const bp::list& args )
 static inline CalamaresUtils::ProcessResult
 _target_env_command( const QStringList& args, const std::string& stdin, int timeout )
 {
+    // Other Python jobs may continue while the command runs.
+    GILScopedRelease nogil;
     // Since Python doesn't give us the type system for distinguishing
     // seconds from other integral types, massage to seconds here.
     return CalamaresUtils::System::instance()->targetEnvCommand(
@@ -136,6 +139,80 @@ check_target_env_output( const bp::list& args, const std::string& stdin, int tim
     return ec.second.toStdString();
 }
 
+ProcessLines::ProcessLines( const QStringList& args, const std::string& stdin, int timeout, bool keepInputOpen )
+    : m_runner( std::make_shared< CalamaresUtils::Runner >( args ) )
+    , m_command( args.join( ' ' ) )
+{
+    // Enough lines to not stall the command, and the last lines for an error message
+    static constexpr int QUEUE_SIZE = 256;
+    static constexpr int OUTPUT_LIMIT = 64;
+
+    m_runner
+        ->setLocation( CalamaresUtils::System::instance()->doChroot()
+                           ? CalamaresUtils::System::RunLocation::RunInTarget
+                           : CalamaresUtils::System::RunLocation::RunInHost )
+        .setInput( QByteArray::fromStdString( stdin ), keepInputOpen )
+        .setTimeout( std::chrono::seconds( timeout ) )
+        .setQueueSize( QUEUE_SIZE )
+        .setOutputLimit( OUTPUT_LIMIT );
+    m_runner->start();
+}
+
+ProcessLines::~ProcessLines()
+{
+    // Copies of the iterator are destroyed by Python, with the GIL held
+    if ( m_runner && m_runner.use_count() == 1 )
+    {
+        GILScopedRelease nogil;
+        m_runner.reset();
+    }
+}
+
+std::string
+ProcessLines::next()
+{
+    QString line;
+    bool haveLine = false;
+    {
+        GILScopedRelease nogil;
+        haveLine = m_runner->nextLine( line );
+    }
+    if ( haveLine )
+    {
+        return line.toStdString();
+    }
+
+    _handle_check_target_env_call_error( m_runner->wait(), m_command );
+    PyErr_SetNone( PyExc_StopIteration );
+    bp::throw_error_already_set();
+    return std::string();
+}
+
+bool
+ProcessLines::write( const std::string& data )
+{
+    return m_runner->write( QByteArray::fromStdString( data ) );
+}
+
+void
+ProcessLines::closeInput()
+{
+    m_runner->closeInput();
+}
+
+int
+ProcessLines::wait()
+{
+    GILScopedRelease nogil;
+    return m_runner->wait().getExitCode();
+}
+
+ProcessLines
+target_env_output_lines( const bp::list& args, const std::string& stdin, int timeout, bool keep_input_open )
+{
+    return ProcessLines( _bp_list_to_qstringlist( args ), stdin, timeout, keep_input_open );
+}
+
 void
 debug( const std::string& s )
 {
@@ -169,6 +246,23 @@ PythonJobInterface::setprogress( qreal progress )
 }
 
 
+bool
+PythonJobInterface::isCancelled() const
+{
+    return m_parent->isCancelled();
+}
+
+
+void
+PythonJobInterface::setWorkSize( qint64 size )
+{
+    if ( size >= 0 )
+    {
+        m_parent->m_workSize->store( size );
+    }
+}
+
+
 std::string
 obscure( const std::string& string )
 {
@@ -13,12 +13,19 @@
 
 #include "utils/BoostPython.h"
 
+#include <QStringList>
 #include <qglobal.h>  // For qreal
 
+#include <memory>
+
 namespace Calamares
 {
 class PythonJob;
 }
+namespace CalamaresUtils
+{
+class Runner;
+}
 
 namespace CalamaresPython
 {
@@ -42,6 +49,39 @@ check_target_env_output( const std::string& command, const std::string& stdin =
 std::string
 check_target_env_output( const boost::python::list& args, const std::string& stdin = std::string(), int timeout = 0 );
 
+/** @brief The output of a command in the target system, line by line
+ *
+ * This is a Python iterator; the command runs in the background
+ * and each call to next() returns the next line of output.
+ * At the end, raises subprocess.CalledProcessError if the command failed.
+ */
+class ProcessLines
+{
+public:
+    ProcessLines( const QStringList& args, const std::string& stdin, int timeout, bool keepInputOpen );
+    /** @brief Stops the command, if this is the last copy
+     *
+     * Stopping may take a while (the command gets some time to exit
+     * before it is killed), so the GIL is released meanwhile.
+     */
+    ~ProcessLines();
+
+    std::string next();
+    bool write( const std::string& data );
+    void closeInput();
+    int wait();
+
+private:
+    // Shared, since Python copies the iterator
+    std::shared_ptr< CalamaresUtils::Runner > m_runner;
+    QString m_command;
+};
+
+ProcessLines target_env_output_lines( const boost::python::list& args,
+                                      const std::string& stdin = std::string(),
+                                      int timeout = 0,
+                                      bool keep_input_open = false );
+
 std::string obscure( const std::string& string );
 
 boost::python::object gettext_path();
@@ -63,6 +103,8 @@ public:
     boost::python::dict configuration;
 
     void setprogress( qreal progress );
+    bool isCancelled() const;
+    void setWorkSize( qint64 size );
 
 private:
     Calamares::PythonJob* m_parent;
@@ -309,6 +309,18 @@ Settings::setConfiguration( const QByteArray& ba, const QString& explainName )
         m_disableCancel = requireBool( config, "disable-cancel", false );
         m_disableCancelDuringExec = requireBool( config, "disable-cancel-during-exec", false );
         m_quitAtEnd = requireBool( config, "quit-at-end", false );
+        if ( hasValue( config[ "parallel-jobs" ] ) )
+        {
+            m_parallelJobs = qMax( 0, config[ "parallel-jobs" ].as< int >() );
+        }
+        if ( hasValue( config[ "target-helper" ] ) )
+        {
+            m_targetHelper = config[ "target-helper" ].as< bool >();
+        }
+        if ( hasValue( config[ "config-cache" ] ) )
+        {
+            m_configCache = QString::fromStdString( config[ "config-cache" ].as< std::string >() );
+        }
 
         reconcileInstancesAndSequence();
     }
@@ -160,6 +160,28 @@ public:
     /** @brief Is quit-at-end set? (Quit automatically when done) */
     bool quitAtEnd() const { return m_quitAtEnd; }
 
+    /** @brief How many jobs may run at the same time?
+     *
+     * Returns 0 (use the number of CPU cores) unless *parallel-jobs*
+     * is set. Only modules that describe their scheduling constraints
+     * are ever run concurrently.
+     */
+    int parallelJobs() const { return m_parallelJobs; }
+
+    /** @brief Run commands in the target through a helper process?
+     *
+     * Returns false (use chroot for each command) unless *target-helper*
+     * is set. See CalamaresUtils::TargetHelper.
+     */
+    bool targetHelper() const { return m_targetHelper; }
+
+    /** @brief Read-only YAML cache shipped with the image
+     *
+     * Returns the path set as *config-cache*, or an empty string.
+     * See CalamaresUtils::YamlCache::setCacheFile().
+     */
+    QString configCache() const { return m_configCache; }
+
 private:
     static Settings* s_instance;
 
@@ -177,6 +199,9 @@ private:
     bool m_disableCancel;
     bool m_disableCancelDuringExec;
     bool m_quitAtEnd;
+    int m_parallelJobs = 0;
+    bool m_targetHelper = false;
+    QString m_configCache;
 };
 
 }  // namespace Calamares
@@ -10,15 +10,24 @@
  */
 
 #include "GlobalStorage.h"
+#include "JobCheckpoint.h"
+#include "JobProfile.h"
 #include "JobQueue.h"
 #include "Settings.h"
 #include "modulesystem/InstanceKey.h"
+#include "utils/CalamaresUtilsSystem.h"
 #include "utils/Logger.h"
 
+#include <QElapsedTimer>
 #include <QObject>
 #include <QSignalSpy>
+#include <QStandardPaths>
+#include <QTemporaryFile>
+#include <QThread>
 #include <QtTest/QtTest>
 
+#include <atomic>
+
 class TestLibCalamares : public QObject
 {
     Q_OBJECT
@@ -27,7 +36,11 @@ public:
     ~TestLibCalamares() override {}
 
 private Q_SLOTS:
+    void initTestCase();
+
     void testGSModify();
+    void testGSSnapshot();
+    void testGSBatch();
     void testGSLoadSave();
     void testGSLoadSave2();
     void testGSLoadSaveYAMLStringList();
@@ -38,8 +51,20 @@ private Q_SLOTS:
     void testSettings();
 
     void testJobQueue();
+    void testJobQueueParallel();
+    void testJobProfile();
+    void testJobQueueResume();
+    void testJobQueueCancel();
 };
 
+void
+TestLibCalamares::initTestCase()
+{
+    // A finished JobQueue writes its trace, profile and checkpoint
+    // to the cache directory; keep those out of the user's cache.
+    QStandardPaths::setTestModeEnabled( true );
+}
+
 void
 TestLibCalamares::testGSModify()
 {
@@ -66,6 +91,126 @@ TestLibCalamares::testGSModify()
     QCOMPARE( spy.count(), 2 );  // one insert, one remove
 }
 
+/// @brief Reads snapshots until done, checking that they make sense
+class SnapshotReader : public QThread
+{
+public:
+    SnapshotReader( const Calamares::GlobalStorage& gs )
+        : m_gs( gs )
+    {
+    }
+
+    void run() override
+    {
+        quint64 version = 0;
+        while ( !done )
+        {
+            const auto s = m_gs.snapshot();
+            if ( s->version < version || s->data.value( "derp" ).toInt() != 18 )
+            {
+                errors++;
+            }
+            version = s->version;
+            reads++;
+        }
+    }
+
+    std::atomic< bool > done { false };
+    int errors = 0;
+    int reads = 0;
+
+private:
+    const Calamares::GlobalStorage& m_gs;
+};
+
+void
+TestLibCalamares::testGSSnapshot()
+{
+    Calamares::GlobalStorage gs;
+    const auto empty = gs.snapshot();
+    QVERIFY( empty );
+    QCOMPARE( empty->data.count(), 0 );
+
+    gs.insert( "derp", 17 );
+    const auto first = gs.snapshot();
+    QVERIFY( first->version > empty->version );
+    QCOMPARE( first->data.value( "derp" ).toInt(), 17 );
+    QCOMPARE( empty->data.count(), 0 );  // Snapshots do not change
+
+    gs.insert( "derp", 18 );
+    gs.insert( "herp", 19 );
+    QCOMPARE( first->data.value( "derp" ).toInt(), 17 );
+    QCOMPARE( first->data.count(), 1 );
+    QVERIFY( gs.snapshot()->version > first->version );
+    QCOMPARE( gs.data().count(), 2 );
+
+    // A reader and a writer at the same time
+    SnapshotReader reader( gs );
+    reader.start();
+    for ( int i = 0; i < 1000; ++i )
+    {
+        gs.insert( QStringLiteral( "key%1" ).arg( i ), i );
+    }
+    reader.done = true;
+    reader.wait();
+    QVERIFY( reader.reads > 0 );
+    QCOMPARE( reader.errors, 0 );
+    QCOMPARE( gs.count(), 1002 );
+}
+
+void
+TestLibCalamares::testGSBatch()
+{
+    Calamares::GlobalStorage gs;
+    gs.insert( "derp", 17 );
+    gs.insert( "gone", true );
+
+    QSignalSpy spy( &gs, &Calamares::GlobalStorage::changed );
+    QSignalSpy keySpy( &gs, &Calamares::GlobalStorage::keyChanged );
+    QSignalSpy keysSpy( &gs, &Calamares::GlobalStorage::keysChanged );
+
+    {
+        Calamares::GlobalStorage::Batch b( &gs );
+        b.insert( "derp", 17 );  // Not a change
+        b.insert( "one", 1 );
+        b.insert( "two", 2 );
+        b.remove( "gone" );
+        b.remove( "two" );
+        b.insert( "two", 3 );
+        QCOMPARE( b.value( "two" ).toInt(), 3 );
+        QVERIFY( !b.value( "gone" ).isValid() );
+        QCOMPARE( b.value( "derp" ).toInt(), 17 );
+
+        // Nothing happens until the batch is done
+        QCOMPARE( spy.count(), 0 );
+        QVERIFY( !gs.contains( "one" ) );
+        QVERIFY( gs.contains( "gone" ) );
+    }
+
+    QCOMPARE( spy.count(), 1 );
+    QCOMPARE( keysSpy.count(), 1 );
+    QCOMPARE( keySpy.count(), 3 );
+    auto keys = keysSpy.takeFirst().at( 0 ).toStringList();
+    keys.sort();
+    QCOMPARE( keys, QStringList() << "gone"
+                                  << "one"
+                                  << "two" );
+    QCOMPARE( gs.count(), 3 );
+    QCOMPARE( gs.value( "two" ).toInt(), 3 );
+
+    // Unchanged values do not emit keyChanged
+    gs.insert( "one", 1 );
+    QCOMPARE( spy.count(), 2 );
+    QCOMPARE( keySpy.count(), 3 );
+    QCOMPARE( keysSpy.count(), 0 );
+    gs.remove( "nonexistent" );
+    QCOMPARE( spy.count(), 3 );
+    QCOMPARE( keySpy.count(), 3 );
+    gs.insert( "one", QStringLiteral( "one" ) );
+    QCOMPARE( keySpy.count(), 4 );
+    QCOMPARE( keySpy.last().at( 0 ).toString(), QStringLiteral( "one" ) );
+}
+
 void
 TestLibCalamares::testGSLoadSave()
 {
@@ -509,6 +654,77 @@ DummyJob::exec()
     return Calamares::JobResult::ok();
 }
 
+/// @brief Reports progress very often, like rsync does
+class ChattyJob : public Calamares::Job
+{
+public:
+    ChattyJob( QObject* parent )
+        : Calamares::Job( parent )
+    {
+    }
+    ~ChattyJob() override;
+
+    QString prettyName() const override { return QString( "ChattyJob" ); }
+    Calamares::JobResult exec() override
+    {
+        for ( int i = 0; i < 100000; ++i )
+        {
+            progress( i / 100000.0 );
+        }
+        return Calamares::JobResult::ok();
+    }
+};
+
+ChattyJob::~ChattyJob() {}
+
+/// @brief Counts how often it runs, and fails if asked to
+class CountingJob : public Calamares::Job
+{
+public:
+    CountingJob( int& count, bool fail, QObject* parent )
+        : Calamares::Job( parent )
+        , m_count( count )
+        , m_fail( fail )
+    {
+    }
+    ~CountingJob() override;
+
+    QString prettyName() const override { return QString( "CountingJob" ); }
+    Calamares::JobResult exec() override
+    {
+        m_count++;
+        return m_fail ? Calamares::JobResult::error( QStringLiteral( "Failed" ) ) : Calamares::JobResult::ok();
+    }
+
+private:
+    int& m_count;
+    bool m_fail;
+};
+
+CountingJob::~CountingJob() {}
+
+/// @brief Runs a command that takes a long time
+class SleepingJob : public Calamares::Job
+{
+public:
+    SleepingJob( QObject* parent )
+        : Calamares::Job( parent )
+    {
+    }
+    ~SleepingJob() override;
+
+    QString prettyName() const override { return QString( "SleepingJob" ); }
+    Calamares::JobResult exec() override
+    {
+        auto r = CalamaresUtils::System::runCommand( { "sleep", "30" }, std::chrono::seconds( 60 ) );
+        m_cancelled = isCancelled();
+        return r.explainProcess( QStringLiteral( "sleep" ), std::chrono::seconds( 60 ) );
+    }
+
+    bool m_cancelled = false;
+};
+
+SleepingJob::~SleepingJob() {}
 
 void
 TestLibCalamares::testJobQueue()
@@ -539,6 +755,7 @@ TestLibCalamares::testJobQueue()
         Calamares::JobQueue q;
         QVERIFY( !q.isRunning() );
 
+        q.setProgressInterval( 0 );  // Deliver every report, so they can be counted
         q.enqueue( 8, Calamares::JobList() << Calamares::job_ptr( new DummyJob( this ) ) );
         QSignalSpy spy_progress( &q, &Calamares::JobQueue::progress );
         QSignalSpy spy_finished( &q, &Calamares::JobQueue::finished );
@@ -555,16 +772,18 @@ TestLibCalamares::testJobQueue()
         QCOMPARE( spy_failed.count(), 0 );
         // 0% by the queue at job start
         // 50% by the job itself
-        // 90% by the job itself
+        // 75% by the job itself
         // 100% by the queue at job end
         // 100% by the queue at queue end
         QCOMPARE( spy_progress.count(), 5 );
+        QCOMPARE( spy_progress.last().first().toReal(), 1.0 );
     }
 
     {
         Calamares::JobQueue q;
         QVERIFY( !q.isRunning() );
 
+        q.setProgressInterval( 0 );
         q.enqueue( 8, Calamares::JobList() << Calamares::job_ptr( new DummyJob( this ) ) );
         q.enqueue( 12,
                    Calamares::JobList() << Calamares::job_ptr( new DummyJob( this ) )
@@ -585,7 +804,7 @@ TestLibCalamares::testJobQueue()
         QCOMPARE( spy_failed.count(), 0 );
         // 0% by the queue at job start
         // 50% by the job itself
-        // 90% by the job itself
+        // 75% by the job itself
         // 100% by the queue at job end
         // 4 more for the next job
         // 4 more for the next job
@@ -627,8 +846,243 @@ TestLibCalamares::testJobQueue()
             overallProgress = progress;
         }
     }
+
+    // Progress reports are coalesced
+    {
+        Calamares::JobQueue q;
+        q.enqueue( 8, Calamares::JobList() << Calamares::job_ptr( new ChattyJob( this ) ) );
+        QSignalSpy spy_progress( &q, &Calamares::JobQueue::progress );
+
+        QEventLoop loop;
+        connect( &q, &Calamares::JobQueue::finished, &loop, &QEventLoop::quit );
+        QTimer::singleShot( MAX_TEST_DURATION, &loop, &QEventLoop::quit );
+        q.start();
+        loop.exec();
+        QVERIFY( !q.isRunning() );
+        QVERIFY( spy_progress.count() >= 1 );
+        QVERIFY( spy_progress.count() < 1000 );
+        QCOMPARE( spy_progress.last().first().toReal(), 1.0 );
+        QCOMPARE( spy_progress.last().last().toString(), QStringLiteral( "Done" ) );
+    }
 }
 
+void
+TestLibCalamares::testJobQueueParallel()
+{
+    auto runQueue = []( Calamares::JobQueue& q ) {
+        QEventLoop loop;
+        connect( &q, &Calamares::JobQueue::finished, &loop, &QEventLoop::quit );
+        QTimer::singleShot( 3 * MAX_TEST_DURATION, &loop, &QEventLoop::quit );
+        QElapsedTimer timer;
+        timer.start();
+        q.start();
+        loop.exec();
+        return std::chrono::milliseconds( timer.elapsed() );
+    };
+
+    Calamares::JobConstraints c0;
+    c0.moduleName = QStringLiteral( "dummy0" );
+    c0.outputs << QStringLiteral( "/etc/dummy0" );
+    Calamares::JobConstraints c1;
+    c1.moduleName = QStringLiteral( "dummy1" );
+    c1.outputs << QStringLiteral( "/etc/dummy1" );
+
+    // Disjoint outputs, so both jobs run at the same time
+    {
+        Calamares::JobQueue q;
+        q.setMaximumParallelJobs( 2 );
+        q.setProgressInterval( 0 );
+        q.enqueue( 8, Calamares::JobList() << Calamares::job_ptr( new DummyJob( this ) ), c0 );
+        q.enqueue( 8, Calamares::JobList() << Calamares::job_ptr( new DummyJob( this ) ), c1 );
+        QSignalSpy spy_progress( &q, &Calamares::JobQueue::progress );
+        QSignalSpy spy_failed( &q, &Calamares::JobQueue::failed );
+
+        auto elapsed = runQueue( q );
+        QVERIFY( !q.isRunning() );
+        QCOMPARE( spy_failed.count(), 0 );
+        QCOMPARE( spy_progress.count(), 9 );  // 4 for each job, and the queue end
+        QVERIFY( elapsed < std::chrono::seconds( 2 * MAX_TEST_SLEEP ) );
+        QCOMPARE( spy_progress.last().first().toReal(), 1.0 );
+    }
+    // One is *after* the other, so they run in sequence
+    {
+        Calamares::JobQueue q;
+        q.setMaximumParallelJobs( 2 );
+        c1.after << c0.moduleName;
+        q.enqueue( 8, Calamares::JobList() << Calamares::job_ptr( new DummyJob( this ) ), c0 );
+        q.enqueue( 8, Calamares::JobList() << Calamares::job_ptr( new DummyJob( this ) ), c1 );
+
+        auto elapsed = runQueue( q );
+        QVERIFY( !q.isRunning() );
+        QVERIFY( elapsed >= std::chrono::seconds( 2 * MAX_TEST_SLEEP ) );
+    }
+}
+
+
+void
+TestLibCalamares::testJobProfile()
+{
+    Calamares::JobProfile p;
+    QVERIFY( p.isEmpty() );
+    QCOMPARE( p.estimate( QStringLiteral( "shellprocess@shellprocess#0" ) ), 0.0 );
+
+    p.record( QStringLiteral( "shellprocess@shellprocess#0" ), 4.0 );
+    QCOMPARE( p.count(), 1 );
+    QCOMPARE( p.estimate( QStringLiteral( "shellprocess@shellprocess#0" ) ), 4.0 );
+    // Smoothed with the previous estimate
+    p.record( QStringLiteral( "shellprocess@shellprocess#0" ), 2.0 );
+    QCOMPARE( p.estimate( QStringLiteral( "shellprocess@shellprocess#0" ) ), 3.0 );
+
+    // Scaled by work size
+    p.record( QStringLiteral( "unpackfs@unpackfs#0" ), 10.0, 1000 );
+    QCOMPARE( p.estimate( QStringLiteral( "unpackfs@unpackfs#0" ), 2000 ), 20.0 );
+    QCOMPARE( p.estimate( QStringLiteral( "unpackfs@unpackfs#0" ) ), 10.0 );
+    // Nonsense measurements are ignored
+    p.record( QStringLiteral( "bogus@bogus#0" ), -1.0 );
+    QCOMPARE( p.count(), 2 );
+
+    QTemporaryFile f( QDir::tempPath() + QStringLiteral( "/calamares-profile-XXXXXX.json" ) );
+    QVERIFY( f.open() );
+    f.close();
+    QVERIFY( p.save( f.fileName() ) );
+
+    Calamares::JobProfile p2;
+    QVERIFY( p2.load( f.fileName() ) );
+    QCOMPARE( p2.count(), 2 );
+    QCOMPARE( p2.estimate( QStringLiteral( "shellprocess@shellprocess#0" ) ), 3.0 );
+    QCOMPARE( p2.estimate( QStringLiteral( "unpackfs@unpackfs#0" ), 500 ), 5.0 );
+
+    QVERIFY( !p2.load( QStringLiteral( "/nonexistent/job-profile.json" ) ) );
+}
+
+
+void
+TestLibCalamares::testJobQueueResume()
+{
+    auto runQueue = []( Calamares::JobQueue& q ) {
+        QEventLoop loop;
+        connect( &q, &Calamares::JobQueue::finished, &loop, &QEventLoop::quit );
+        QTimer::singleShot( MAX_TEST_DURATION, &loop, &QEventLoop::quit );
+        q.start();
+        loop.exec();
+    };
+
+    Calamares::JobCheckpoint::remove();
+
+    Calamares::JobConstraints c0;
+    c0.instanceKey = QStringLiteral( "first@first" );
+    Calamares::JobConstraints c1;
+    c1.instanceKey = QStringLiteral( "second@second" );
+
+    int first = 0;
+    int second = 0;
+    int emergency = 0;
+    const QVariantList partitions { QVariantMap { { QStringLiteral( "device" ), QStringLiteral( "/dev/sda1" ) },
+                                                  { QStringLiteral( "luksPassphrase" ), QStringLiteral( "secret" ) } } };
+    // The second job fails, so a checkpoint is left after the first
+    {
+        Calamares::JobQueue q;
+        q.globalStorage()->insert( QStringLiteral( "resumed" ), true );
+        q.globalStorage()->insert( QStringLiteral( "password" ), QStringLiteral( "secret" ) );
+        q.globalStorage()->insert( QStringLiteral( "partitions" ), partitions );
+        auto cleanup = Calamares::job_ptr( new CountingJob( emergency, false, this ) );
+        cleanup->setEmergency( true );
+        q.enqueue( 1, Calamares::JobList() << Calamares::job_ptr( new CountingJob( first, false, this ) ), c0 );
+        q.enqueue( 1, Calamares::JobList() << Calamares::job_ptr( new CountingJob( second, true, this ) ), c1 );
+        q.enqueue( 1, Calamares::JobList() << cleanup );
+        QSignalSpy spy_failed( &q, &Calamares::JobQueue::failed );
+        runQueue( q );
+        QCOMPARE( spy_failed.count(), 1 );
+        QCOMPARE( first, 1 );
+        QCOMPARE( second, 1 );
+        QCOMPARE( emergency, 1 );
+    }
+
+    Calamares::JobCheckpoint checkpoint;
+    QVERIFY( checkpoint.load() );
+    QCOMPARE( checkpoint.doneJobs, QStringList { QStringLiteral( "first@first/CountingJob" ) } );
+    QCOMPARE( checkpoint.lastInstanceKey, c0.instanceKey );
+
+    // Secrets are not written, and only the user can read the files
+    {
+        QFile storage( Calamares::JobCheckpoint::storageFile() );
+        QVERIFY( storage.open( QIODevice::ReadOnly ) );
+        const auto contents = storage.readAll();
+        QVERIFY( contents.contains( "resumed" ) );
+        QVERIFY( contents.contains( "/dev/sda1" ) );
+        QVERIFY( !contents.contains( "secret" ) );
+        const auto others = QFileDevice::ReadGroup | QFileDevice::WriteGroup | QFileDevice::ReadOther
+            | QFileDevice::WriteOther;
+        QVERIFY( !( storage.permissions() & others ) );
+        QVERIFY( !( QFile::permissions( Calamares::JobCheckpoint::checkpointFile() ) & others ) );
+    }
+
+    // A different sequence of jobs does not resume; the job fails,
+    // so the checkpoint is left alone.
+    {
+        int other = 0;
+        Calamares::JobQueue q;
+        q.enqueue( 1, Calamares::JobList() << Calamares::job_ptr( new CountingJob( other, true, this ) ), c1 );
+        q.setResumeFromCheckpoint( true );
+        runQueue( q );
+        QCOMPARE( other, 1 );
+        QVERIFY( !q.globalStorage()->contains( QStringLiteral( "resumed" ) ) );
+    }
+
+    // Resume, the first job is skipped and global storage restored,
+    // with the secrets that were entered again.
+    {
+        Calamares::JobQueue q;
+        q.globalStorage()->insert( QStringLiteral( "password" ), QStringLiteral( "secret" ) );
+        q.globalStorage()->insert( QStringLiteral( "partitions" ), partitions );
+        auto cleanup = Calamares::job_ptr( new CountingJob( emergency, false, this ) );
+        cleanup->setEmergency( true );
+        q.enqueue( 1, Calamares::JobList() << Calamares::job_ptr( new CountingJob( first, false, this ) ), c0 );
+        q.enqueue( 1, Calamares::JobList() << Calamares::job_ptr( new CountingJob( second, false, this ) ), c1 );
+        q.enqueue( 1, Calamares::JobList() << cleanup );
+        q.setResumeFromCheckpoint( true );
+        QSignalSpy spy_failed( &q, &Calamares::JobQueue::failed );
+        runQueue( q );
+        QCOMPARE( spy_failed.count(), 0 );
+        QCOMPARE( first, 1 );
+        QCOMPARE( second, 2 );
+        QCOMPARE( emergency, 2 );  // Emergency jobs always run again
+        QVERIFY( q.globalStorage()->value( QStringLiteral( "resumed" ) ).toBool() );
+        QCOMPARE( q.globalStorage()->value( QStringLiteral( "password" ) ).toString(), QStringLiteral( "secret" ) );
+        QCOMPARE( q.globalStorage()->value( QStringLiteral( "partitions" ) ), QVariant( partitions ) );
+    }
+
+    // Successful installations leave no checkpoint behind
+    QVERIFY( !checkpoint.load() );
+}
+
+void
+TestLibCalamares::testJobQueueCancel()
+{
+    int emergency = 0;
+    Calamares::JobQueue q;
+    auto sleeper = new SleepingJob( this );
+    auto cleanup = Calamares::job_ptr( new CountingJob( emergency, false, this ) );
+    cleanup->setEmergency( true );
+    q.enqueue( 1, Calamares::JobList() << Calamares::job_ptr( sleeper ) );
+    q.enqueue( 1, Calamares::JobList() << cleanup );
+    QSignalSpy spy_failed( &q, &Calamares::JobQueue::failed );
+
+    QEventLoop loop;
+    connect( &q, &Calamares::JobQueue::finished, &loop, &QEventLoop::quit );
+    QTimer::singleShot( MAX_TEST_DURATION, &loop, &QEventLoop::quit );
+    QTimer::singleShot( 200, &q, &Calamares::JobQueue::cancel );
+    QElapsedTimer timer;
+    timer.start();
+    q.start();
+    loop.exec();
+
+    QVERIFY( !q.isRunning() );
+    QVERIFY( std::chrono::milliseconds( timer.elapsed() ) < MAX_TEST_DURATION );
+    QVERIFY( sleeper->m_cancelled );
+    QCOMPARE( spy_failed.count(), 1 );
+    QCOMPARE( emergency, 1 );  // Emergency jobs still run
+}
 
 QTEST_GUILESS_MAIN( TestLibCalamares )
 
@@ -88,8 +88,12 @@ Descriptor::fromDescriptorData( const QVariantMap& moduleDesc )
     d.m_hasConfig = !CalamaresUtils::getBool( moduleDesc, "noconfig", false );  // Inverted logic during load
     d.m_requiredModules = CalamaresUtils::getStringList( moduleDesc, "requiredModules" );
     d.m_weight = int( CalamaresUtils::getInteger( moduleDesc, "weight", -1 ) );
+    d.m_after = CalamaresUtils::getStringList( moduleDesc, "after" );
+    d.m_inputs = CalamaresUtils::getStringList( moduleDesc, "inputs" );
+    d.m_outputs = CalamaresUtils::getStringList( moduleDesc, "outputs" );
 
-    QStringList consumedKeys { "type", "interface", "name", "emergency", "noconfig", "requiredModules", "weight" };
+    QStringList consumedKeys { "type",   "interface", "name",   "emergency", "noconfig", "requiredModules",
+                               "weight", "after",     "inputs", "outputs" };
 
     switch ( d.interface() )
     {
@@ -100,12 +104,14 @@ Descriptor::fromDescriptorData( const QVariantMap& moduleDesc )
     case Interface::Python:
     case Interface::PythonQt:
         d.m_script = CalamaresUtils::getString( moduleDesc, "script" );
+        d.m_hasPrepare = CalamaresUtils::getBool( moduleDesc, "prepare", false );
         if ( d.m_script.isEmpty() )
         {
             cWarning() << "Module descriptor contains no *script*" << d.name();
             d.m_isValid = false;
         }
-        consumedKeys << "script";
+        consumedKeys << "script"
+                     << "prepare";
         break;
     case Interface::Process:
         d.m_script = CalamaresUtils::getString( moduleDesc, "command" );
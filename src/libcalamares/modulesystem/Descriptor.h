@@ -80,6 +80,24 @@ public:
 
     const QStringList& requiredModules() const { return m_requiredModules; }
 
+    /** @section Job scheduling
+     *
+     * A module may describe what its jobs touch, so that the job queue
+     * can run it alongside other modules. Modules that say nothing here
+     * run strictly in sequence-order (which is the traditional behavior).
+     */
+    /// @brief Names of modules whose jobs must finish before this one's start
+    const QStringList& after() const { return m_after; }
+    /// @brief Resources (e.g. files in the target, globalstorage keys) read
+    const QStringList& inputs() const { return m_inputs; }
+    /// @brief Resources written
+    const QStringList& outputs() const { return m_outputs; }
+    /// @brief Does this module describe its scheduling constraints?
+    bool hasSchedulingInformation() const
+    {
+        return !m_after.isEmpty() || !m_inputs.isEmpty() || !m_outputs.isEmpty();
+    }
+
     /** @section C++ Modules
      *
      * The C++ modules are the most general, and are loaded as
@@ -113,17 +131,27 @@ public:
     {
         return ( m_interface == Interface::Python || m_interface == Interface::PythonQt ) ? m_script : QString();
     }
+    /** @brief Does the script have a prepare() function?
+     *
+     * If so, that function is run in the background while the
+     * user goes through the UI, see JobQueue::prepare().
+     */
+    bool hasPrepare() const { return m_interface == Interface::Python && m_hasPrepare; }
 
 private:
     QString m_name;
     QString m_directory;
     QStringList m_requiredModules;
+    QStringList m_after;
+    QStringList m_inputs;
+    QStringList m_outputs;
     int m_weight = -1;
     Type m_type;
     Interface m_interface;
     bool m_isValid = false;
     bool m_isEmergeny = false;
     bool m_hasConfig = true;
+    bool m_hasPrepare = false;
 
     /** @brief The name of the thing to load
      *
@@ -18,6 +18,7 @@
 #include "utils/Logger.h"
 #include "utils/NamedEnum.h"
 #include "utils/Yaml.h"
+#include "utils/YamlCache.h"
 
 #include <QDir>
 #include <QFile>
@@ -92,27 +93,25 @@ void Module::loadConfigurationFile( const QString& configFileName )  //throws YA
         = moduleConfigurationCandidates( Settings::instance()->debugMode(), name(), configFileName );
     for ( const QString& path : configCandidates )
     {
-        QFile configFile( path );
-        if ( configFile.exists() && configFile.open( QFile::ReadOnly | QFile::Text ) )
+        bool exists = false;
+        const QVariant doc = CalamaresUtils::YamlCache::load( path, &exists );
+        if ( exists )
         {
-            QByteArray ba = configFile.readAll();
-
-            YAML::Node doc = YAML::Load( ba.constData() );
-            if ( doc.IsNull() )
+            if ( !doc.isValid() )
             {
                 cDebug() << "Found empty module configuration" << path;
                 // Special case: empty config files are valid,
                 // but aren't a map.
                 return;
             }
-            if ( !doc.IsMap() )
+            if ( doc.type() != QVariant::Map )
             {
                 cWarning() << "Bad module configuration format" << path;
                 return;
             }
 
             cDebug() << "Loaded module configuration" << path;
-            m_configurationMap = CalamaresUtils::yamlMapToVariant( doc );
+            m_configurationMap = doc.toMap();
             m_emergency = m_maybe_emergency && m_configurationMap.contains( EMERGENCY )
                 && m_configurationMap[ EMERGENCY ].toBool();
             return;
@@ -153,4 +152,16 @@ Module::checkRequirements()
     return RequirementsList();
 }
 
+
+JobList
+Module::prepareJobs() const
+{
+    return JobList();
+}
+
+void
+Module::preloadSelf()
+{
+}
+
 }  // namespace Calamares
@@ -115,12 +115,32 @@ public:
      */
     virtual void loadSelf() = 0;
 
+    /**
+     * @brief preloadSelf does the slow part of loadSelf(), on any thread
+     *
+     * The ModuleManager calls this for many modules at once, on a
+     * thread pool, and then loadSelf() for each (on the GUI thread,
+     * in sequence order). Subclasses can load plugins and other files
+     * here, but must not create widgets. The default implementation
+     * does nothing.
+     */
+    virtual void preloadSelf();
+
     /**
      * @brief jobs returns any jobs exposed by this module.
      * @return a list of jobs (can be empty).
      */
     virtual JobList jobs() const = 0;
 
+    /**
+     * @brief prepareJobs returns jobs to run in the background, early
+     *
+     * These jobs are started as soon as the modules are loaded, while
+     * the user is still going through the UI, see JobQueue::prepare().
+     * The default implementation returns an empty list.
+     */
+    virtual JobList prepareJobs() const;
+
     /**
      * @brief type returns the Type of this module object.
      * @return the type enum value.
@@ -12,6 +12,7 @@
 
 #include "utils/CalamaresUtilsSystem.h"
 #include "utils/Logger.h"
+#include "utils/Probe.h"
 
 void
 CalamaresUtils::Partition::sync()
@@ -32,4 +33,6 @@ CalamaresUtils::Partition::sync()
     }
 
     CalamaresUtils::System::runCommand( { "sync" }, std::chrono::seconds( 10 ) );
+    // Whatever was found on the disks before may have changed
+    CalamaresUtils::Probe::invalidate();
 }
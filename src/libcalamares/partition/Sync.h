@@ -23,6 +23,8 @@ namespace Partition
  * actions (in particular, KPMcore actions with the sfdisk backend
  * are sensitive, and systemd tends to keep disks busy after a change
  * for a while).
+ *
+ * This also forgets the results of probes (see CalamaresUtils::Probe).
  */
 void sync();
 
@@ -12,14 +12,28 @@
 #include "CalamaresUtilsSystem.h"
 
 #include "GlobalStorage.h"
+#include "Job.h"
 #include "JobQueue.h"
 #include "Settings.h"
 #include "utils/Logger.h"
+#include "utils/Probe.h"
+#include "utils/String.h"
+#include "utils/TargetHelper.h"
+#include "utils/Trace.h"
 
 #include <QCoreApplication>
 #include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QMutex>
 #include <QProcess>
+#include <QProcessEnvironment>
+#include <QQueue>
 #include <QRegularExpression>
+#include <QStandardPaths>
+#include <QThread>
+#include <QWaitCondition>
 
 #ifdef Q_OS_LINUX
 #include <sys/sysinfo.h>
@@ -33,6 +47,260 @@
 // clang-format on
 #endif
 
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <signal.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/** @brief A QProcess that runs in a process group of its own
+ *
+ * When the command is killed (on timeout, or because the job queue
+ * is cancelled) the whole group is killed, so that commands run by
+ * the command (e.g. by a shell script) do not linger in the target.
+ *
+ * With a root set, the process changes root before it executes the
+ * program, like chroot(1) does, without executing chroot(1) first.
+ */
+class GroupProcess : public QProcess
+{
+public:
+    void setRoot( const QString& root )
+    {
+        // Changing root into / is pointless, and needs privileges
+        m_root = QDir( root ).canonicalPath() == QStringLiteral( "/" ) ? QByteArray() : QFile::encodeName( root );
+    }
+
+protected:
+    void setupChildProcess() override
+    {
+        ::setpgid( 0, 0 );
+        // Same exit code as chroot(1) when this fails
+        if ( !m_root.isEmpty() && ( ::chroot( m_root.constData() ) != 0 || ::chdir( "/" ) != 0 ) )
+        {
+            ::_exit( 125 );
+        }
+    }
+
+private:
+    QByteArray m_root;  ///< Encoded beforehand, the child should not allocate
+};
+
+/** @brief The host path of @p path in the target system at @p root
+ *
+ * Symlinks are followed the way they are after changing root into
+ * @p root: absolute link targets (e.g. /sbin -> /usr/bin) start
+ * at @p root, and .. does not go above it. Returns an empty
+ * string if the path does not exist, or if there are too many
+ * symlinks, in which case the caller can't tell.
+ */
+static QString
+resolveInTarget( const QString& root, const QString& path )
+{
+    static constexpr int MAX_SYMLINKS = 40;  // Like the kernel's ELOOP limit
+
+    QStringList pending = path.split( '/', SplitSkipEmptyParts );
+    QStringList resolved;  // Components below root, none of them symlinks
+    int symlinks = 0;
+    while ( !pending.isEmpty() )
+    {
+        const QString part = pending.takeFirst();
+        if ( part == QStringLiteral( "." ) )
+        {
+            continue;
+        }
+        if ( part == QStringLiteral( ".." ) )
+        {
+            if ( !resolved.isEmpty() )
+            {
+                resolved.removeLast();
+            }
+            continue;
+        }
+
+        resolved.append( part );
+        const QString hostPath = root + '/' + resolved.join( '/' );
+        QFileInfo fi( hostPath );
+        if ( fi.isSymLink() )
+        {
+            char target[ PATH_MAX ];
+            const ssize_t length = ::readlink( QFile::encodeName( hostPath ).constData(), target, sizeof( target ) );
+            if ( length <= 0 || ++symlinks > MAX_SYMLINKS )
+            {
+                return QString();
+            }
+            const QString link = QFile::decodeName( QByteArray( target, int( length ) ) );
+            resolved.removeLast();
+            if ( link.startsWith( '/' ) )
+            {
+                resolved.clear();
+            }
+            pending = link.split( '/', SplitSkipEmptyParts ) + pending;
+        }
+        else if ( !fi.exists() )
+        {
+            return QString();
+        }
+    }
+    return root + '/' + resolved.join( '/' );
+}
+
+/** @brief Finds @p program in the target system at @p root
+ *
+ * Programs without a directory are looked up in PATH, like the
+ * shell (or chroot(1)) does, but in the target system. Returns
+ * the path of the program in the target, or an empty string if
+ * it is not there (or can't be found from outside the target).
+ */
+static QString
+findInTarget( const QString& root, const QString& program )
+{
+    auto isProgram = [ & ]( const QString& path ) {
+        const QString hostPath = resolveInTarget( root, path );
+        QFileInfo fi( hostPath );
+        return !hostPath.isEmpty() && fi.isFile() && fi.isExecutable();
+    };
+
+    if ( program.contains( '/' ) )
+    {
+        return program.startsWith( '/' ) && isProgram( program ) ? program : QString();
+    }
+    QString path = QString::fromLocal8Bit( qgetenv( "PATH" ) );
+    if ( path.isEmpty() )
+    {
+        path = QStringLiteral( "/usr/local/sbin:/usr/local/bin:/usr/sbin:/usr/bin:/sbin:/bin" );
+    }
+    for ( const auto& dir : path.split( ':', SplitSkipEmptyParts ) )
+    {
+        const QString candidate = dir + '/' + program;
+        if ( dir.startsWith( '/' ) && isProgram( candidate ) )
+        {
+            return candidate;
+        }
+    }
+    return QString();
+}
+
+/** @brief Exit code for a @p program that could not be started
+ *
+ * Commands used to be started through env(1) or chroot(1), which
+ * exit with 127 if the program is not there and 126 if it can't be
+ * run; callers check for those, so they are kept. The program is
+ * looked up in the target system at @p root, if that is set.
+ */
+static int
+notStartedExitCode( const QString& root, const QString& program )
+{
+    bool exists = false;
+    if ( !root.isEmpty() )
+    {
+        exists = !resolveInTarget( root, program ).isEmpty();
+    }
+    else if ( program.contains( '/' ) )
+    {
+        exists = QFileInfo::exists( program );
+    }
+    else
+    {
+        exists = !QStandardPaths::findExecutable( program ).isEmpty();
+    }
+    return exists ? 126 : 127;
+}
+
+static qint64
+toMilliseconds( const timeval& t )
+{
+    return qint64( t.tv_sec ) * 1000 + t.tv_usec / 1000;
+}
+
+/** @brief Measures resources used by child processes while a command runs
+ *
+ * QProcess reaps its children itself, so wait4() can't be used for
+ * them. This takes the difference of getrusage( RUSAGE_CHILDREN )
+ * before and after the command, which is exact only if no other
+ * command ran at the same time. Commands run by the TargetHelper,
+ * which uses wait4() for each command, don't need this.
+ */
+class ChildUsage
+{
+public:
+    ChildUsage()
+    {
+        QMutexLocker l( &s_mutex );
+        m_overlap = s_running > 0;
+        ++s_running;
+        m_generation = ++s_generation;
+        ::getrusage( RUSAGE_CHILDREN, &m_before );
+    }
+    ~ChildUsage()
+    {
+        if ( !m_finished )
+        {
+            QMutexLocker l( &s_mutex );
+            --s_running;
+        }
+    }
+
+    /// @brief Call once the command is done (and reaped)
+    CalamaresUtils::ResourceUsage finish()
+    {
+        struct rusage after;
+        ::getrusage( RUSAGE_CHILDREN, &after );
+
+        CalamaresUtils::ResourceUsage u;
+        {
+            QMutexLocker l( &s_mutex );
+            u.exact = !m_overlap && s_generation == m_generation;
+            --s_running;
+            m_finished = true;
+        }
+        u.userTime = toMilliseconds( after.ru_utime ) - toMilliseconds( m_before.ru_utime );
+        u.systemTime = toMilliseconds( after.ru_stime ) - toMilliseconds( m_before.ru_stime );
+        // This is the largest of all children so far; if it grew, it's this command
+        u.maxRss = after.ru_maxrss > m_before.ru_maxrss ? after.ru_maxrss : -1;
+        u.blocksRead = after.ru_inblock - m_before.ru_inblock;
+        u.blocksWritten = after.ru_oublock - m_before.ru_oublock;
+        return u;
+    }
+
+private:
+    static QMutex s_mutex;
+    static int s_running;  ///< Commands being measured
+    static quint64 s_generation;  ///< Counts started commands
+
+    struct rusage m_before;
+    quint64 m_generation = 0;
+    bool m_overlap = false;
+    bool m_finished = false;
+};
+
+QMutex ChildUsage::s_mutex;
+int ChildUsage::s_running = 0;
+quint64 ChildUsage::s_generation = 0;
+
+/// @brief Interval (ms) at which a running command checks for cancellation
+static constexpr int CANCEL_POLL_INTERVAL = 100;
+
+/// @brief Kills the process group of @p process, politely at first
+static void
+killProcessGroup( QProcess& process )
+{
+    const auto pid = process.processId();
+    if ( pid <= 0 || process.state() == QProcess::NotRunning )
+    {
+        return;
+    }
+    ::kill( -pid, SIGTERM );
+    if ( !process.waitForFinished( 2000 ) )
+    {
+        ::kill( -pid, SIGKILL );
+        process.waitForFinished( 1000 );
+    }
+}
+
 /** @brief When logging commands, don't log everything.
  *
  * The command-line arguments to some commands may contain the
@@ -116,7 +384,186 @@ System::runCommand( System::RunLocation location,
                     const QString& stdInput,
                     std::chrono::seconds timeoutSec )
 {
-    if ( args.isEmpty() )
+    return Runner( args )
+        .setLocation( location )
+        .setWorkingDirectory( workingPath )
+        .setInput( stdInput.toLocal8Bit() )
+        .setTimeout( timeoutSec )
+        .run();
+}
+
+struct Runner::Private
+{
+    QStringList command;
+    System::RunLocation location = System::RunLocation::RunInHost;
+    QString workingDirectory;
+    std::chrono::seconds timeout { 0 };
+    QByteArray input;
+    bool keepInputOpen = false;
+    int outputLimit = -1;
+    LineCallback callback;
+    int queueSize = 0;
+
+    /// Cancellation token of the job that runs the command
+    const Calamares::CancellationToken* token = nullptr;
+    std::unique_ptr< QThread > thread;
+
+    // Shared between the thread running the command and the others
+    mutable QMutex mutex;
+    QWaitCondition lineQueued;  ///< Also woken when finished
+    QWaitCondition lineTaken;  ///< Also woken when stopping
+    QQueue< QString > queue;
+    QByteArray pendingInput;
+    bool closeInputRequested = false;
+    bool stopping = false;  ///< The Runner is destroyed while running
+    bool finished = false;
+    ProcessResult result { ProcessResult::Code::FailedToStart };
+
+    // Used only by the thread running the command
+    QByteArray partialLine;
+    QStringList lastLines;  ///< When outputLimit >= 0
+    QByteArray output;  ///< When outputLimit < 0
+
+    ProcessResult exec();
+    ProcessResult execInHelper( TargetHelper& helper, CalamaresUtils::Trace::Span& span );
+    /// @brief Common end of exec() and execInHelper(), once the command is done
+    ProcessResult outcome( int failure,
+                           bool crashed,
+                           int exitCode,
+                           const ResourceUsage& usage,
+                           CalamaresUtils::Trace::Span& span );
+    /// @brief Returns a failure code if the command should be stopped, sets @p wait otherwise
+    int checkStop( const QElapsedTimer& timer, qint64 timeoutMs, int& wait ) const;
+    void handleOutput( const QByteArray& data );
+    void deliver( QByteArray line );
+    /// @brief Takes the input from write(), returns true if closeInput() was called
+    bool takeInput( QByteArray& data );
+    bool isStopping() const;
+    void finish( const ProcessResult& r );
+};
+
+/// @brief Runs Runner::Private::exec() in the background
+class RunnerThread : public QThread
+{
+public:
+    RunnerThread( Runner::Private* d )
+        : m_d( d )
+    {
+    }
+
+protected:
+    void run() override { m_d->finish( m_d->exec() ); }
+
+private:
+    Runner::Private* m_d;
+};
+
+bool
+Runner::Private::isStopping() const
+{
+    QMutexLocker l( &mutex );
+    return stopping;
+}
+
+void
+Runner::Private::finish( const ProcessResult& r )
+{
+    QMutexLocker l( &mutex );
+    result = r;
+    finished = true;
+    lineQueued.wakeAll();
+}
+
+void
+Runner::Private::deliver( QByteArray line )
+{
+    if ( line.endsWith( '\r' ) )
+    {
+        line.chop( 1 );
+    }
+    const QString s = QString::fromLocal8Bit( line );
+    if ( callback )
+    {
+        callback( s );
+    }
+    if ( outputLimit > 0 )
+    {
+        lastLines.append( s );
+        if ( lastLines.count() > outputLimit )
+        {
+            lastLines.removeFirst();
+        }
+    }
+    if ( queueSize > 0 )
+    {
+        QMutexLocker l( &mutex );
+        while ( queue.count() >= queueSize && !stopping )
+        {
+            lineTaken.wait( &mutex );
+        }
+        queue.enqueue( s );
+        lineQueued.wakeAll();
+    }
+}
+
+void
+Runner::Private::handleOutput( const QByteArray& data )
+{
+    if ( data.isEmpty() )
+    {
+        return;
+    }
+    if ( outputLimit < 0 )
+    {
+        output.append( data );
+    }
+    if ( !callback && queueSize <= 0 && outputLimit <= 0 )
+    {
+        // Nobody is interested in separate lines
+        return;
+    }
+
+    partialLine.append( data );
+    int start = 0;
+    for ( int newline = partialLine.indexOf( '\n' ); newline >= 0; newline = partialLine.indexOf( '\n', start ) )
+    {
+        deliver( partialLine.mid( start, newline - start ) );
+        start = newline + 1;
+    }
+    partialLine.remove( 0, start );
+}
+
+bool
+Runner::Private::takeInput( QByteArray& data )
+{
+    QMutexLocker l( &mutex );
+    data.swap( pendingInput );
+    pendingInput.clear();
+    const bool close = closeInputRequested;
+    closeInputRequested = false;
+    return close;
+}
+
+int
+Runner::Private::checkStop( const QElapsedTimer& timer, qint64 timeoutMs, int& wait ) const
+{
+    if ( ( token && token->isCancelled() ) || isStopping() )
+    {
+        return static_cast< int >( ProcessResult::Code::Cancelled );
+    }
+    const qint64 remaining = timeoutMs > 0 ? timeoutMs - timer.elapsed() : CANCEL_POLL_INTERVAL;
+    if ( remaining <= 0 )
+    {
+        return static_cast< int >( ProcessResult::Code::TimedOut );
+    }
+    wait = int( qMin< qint64 >( remaining, CANCEL_POLL_INTERVAL ) );
+    return 0;
+}
+
+ProcessResult
+Runner::Private::exec()
+{
+    if ( command.isEmpty() )
     {
         cWarning() << "Cannot run an empty program list";
         return ProcessResult::Code::FailedToStart;
@@ -131,84 +578,458 @@ System::runCommand( System::RunLocation location,
         return ProcessResult::Code::NoWorkingDirectory;
     }
 
-    QString program;
-    QStringList arguments( args );
-
+    QString destDir;
     if ( location == System::RunLocation::RunInTarget )
     {
-        QString destDir = gs->value( "rootMountPoint" ).toString();
+        destDir = gs->value( "rootMountPoint" ).toString();
         if ( !QDir( destDir ).exists() )
         {
             cWarning() << "rootMountPoint points to a dir which does not exist";
             return ProcessResult::Code::NoWorkingDirectory;
         }
+    }
 
-        program = "chroot";
-        arguments.prepend( destDir );
+    if ( !workingDirectory.isEmpty() && !QDir( workingDirectory ).exists() )
+    {
+        cWarning() << "Invalid working directory:" << workingDirectory;
+        return ProcessResult::Code::NoWorkingDirectory;
     }
-    else
+
+    CalamaresUtils::Trace::Span span( "command", command.first() );
+    span.setArgument( QStringLiteral( "location" ),
+                      location == System::RunLocation::RunInTarget ? QStringLiteral( "target" )
+                                                                    : QStringLiteral( "host" ) );
+    if ( !command.contains( "usermod" ) )
     {
-        program = "env";
+        // Same as RedactedList, don't record the password
+        span.setArgument( QStringLiteral( "argv" ), command );
     }
 
-    QProcess process;
-    process.setProgram( program );
-    process.setArguments( arguments );
-    process.setProcessChannelMode( QProcess::MergedChannels );
+    // The helper reaps the command itself, so it knows exactly what
+    // resources the command used; see ChildUsage for the others.
+    {
+        auto helper = TargetHelper::acquire();
+        if ( helper )
+        {
+            const bool inTarget = location == System::RunLocation::RunInTarget;
+            const QString root = inTarget ? destDir : QStringLiteral( "/" );
+            // Like chroot(1), commands in the target start in its root directory
+            const QString directory = inTarget ? QStringLiteral( "/" )
+                : workingDirectory.isEmpty()   ? QDir::currentPath()
+                                               : QDir( workingDirectory ).absolutePath();
+            cDebug() << "Running in" << root << RedactedList( command );
+            const qint64 pid
+                = helper->start( root, directory, command, QProcessEnvironment::systemEnvironment().toStringList() );
+            if ( pid > 0 )
+            {
+                span.setArgument( QStringLiteral( "helper" ), true );
+                const auto r = execInHelper( *helper, span );
+                TargetHelper::release( std::move( helper ) );
+                return r;
+            }
+            if ( pid != -EPIPE && pid != -ETIMEDOUT )
+            {
+                cWarning() << "Process" << command.first() << "failed to start" << ::strerror( int( -pid ) );
+                span.setArgument( QStringLiteral( "exit" ),
+                                  static_cast< int >( ProcessResult::Code::FailedToStart ) );
+                TargetHelper::release( std::move( helper ) );
+                return ProcessResult::Code::FailedToStart;
+            }
+            // The helper is gone; the command was not run, so run it the usual way
+            cWarning() << "Target helper failed, using chroot instead.";
+        }
+    }
 
-    if ( !workingPath.isEmpty() )
+    // The program is executed directly, also in the target; only
+    // if it is not found there, chroot(1) reports that as before.
+    GroupProcess process;
+    QString program;
+    QStringList arguments( command );
+    if ( location == System::RunLocation::RunInTarget )
     {
-        if ( QDir( workingPath ).exists() )
+        program = findInTarget( destDir, command.first() );
+        if ( program.isEmpty() )
         {
-            process.setWorkingDirectory( QDir( workingPath ).absolutePath() );
+            program = "chroot";
+            arguments.prepend( destDir );
         }
         else
         {
-            cWarning() << "Invalid working directory:" << workingPath;
-            return ProcessResult::Code::NoWorkingDirectory;
+            arguments.removeFirst();
+            process.setRoot( destDir );
         }
     }
+    else
+    {
+        program = arguments.takeFirst();
+    }
+
+    process.setProgram( program );
+    process.setArguments( arguments );
+    process.setProcessChannelMode( QProcess::MergedChannels );
+    if ( !workingDirectory.isEmpty() )
+    {
+        process.setWorkingDirectory( QDir( workingDirectory ).absolutePath() );
+    }
 
-    cDebug() << "Running" << program << RedactedList( arguments );
+    // The whole command, so that RedactedList recognizes it
+    cDebug() << "Running" << program << RedactedList( command );
+    ChildUsage childUsage;
+    QElapsedTimer wallTimer;
+    wallTimer.start();
     process.start();
     if ( !process.waitForStarted() )
     {
-        cWarning() << "Process" << args.first() << "failed to start" << process.error();
+        cWarning() << "Process" << command.first() << "failed to start" << process.error();
+        if ( process.error() == QProcess::FailedToStart )
+        {
+            const bool inTarget = location == System::RunLocation::RunInTarget && program != QStringLiteral( "chroot" );
+            const int exitCode = notStartedExitCode( inTarget ? destDir : QString(), program );
+            span.setArgument( QStringLiteral( "exit" ), exitCode );
+            return ProcessResult( exitCode, QString() );
+        }
+        span.setArgument( QStringLiteral( "exit" ), static_cast< int >( ProcessResult::Code::FailedToStart ) );
         return ProcessResult::Code::FailedToStart;
     }
 
-    if ( !stdInput.isEmpty() )
+    if ( !input.isEmpty() )
     {
-        process.write( stdInput.toLocal8Bit() );
+        process.write( input );
+    }
+    if ( !keepInputOpen )
+    {
+        process.closeWriteChannel();
     }
-    process.closeWriteChannel();
 
-    if ( !process.waitForFinished( timeoutSec > std::chrono::seconds::zero()
-                                       ? ( static_cast< int >( std::chrono::milliseconds( timeoutSec ).count() ) )
-                                       : -1 ) )
+    // Read the output as it arrives, checking for cancellation and timeout in between
+    const qint64 timeoutMs = std::chrono::milliseconds( timeout ).count();
+    QElapsedTimer timer;
+    timer.start();
+    int failure = 0;
+    while ( process.state() != QProcess::NotRunning )
     {
-        cWarning() << "Process" << args.first() << "timed out after" << timeoutSec.count() << "s. Output so far:\n"
-                   << Logger::NoQuote {} << process.readAllStandardOutput();
-        return ProcessResult::Code::TimedOut;
+        int wait = 0;
+        failure = checkStop( timer, timeoutMs, wait );
+        if ( failure )
+        {
+            break;
+        }
+        if ( keepInputOpen )
+        {
+            QByteArray data;
+            const bool close = takeInput( data );
+            if ( !data.isEmpty() )
+            {
+                process.write( data );
+            }
+            if ( close )
+            {
+                process.closeWriteChannel();
+            }
+        }
+        process.waitForReadyRead( wait );
+        handleOutput( process.readAllStandardOutput() );
     }
+    if ( failure )
+    {
+        killProcessGroup( process );
+    }
+    handleOutput( process.readAllStandardOutput() );
 
-    QString output = QString::fromLocal8Bit( process.readAllStandardOutput() ).trimmed();
+    ResourceUsage usage = childUsage.finish();
+    usage.wallTime = wallTimer.elapsed();
+    return outcome( failure, process.exitStatus() == QProcess::CrashExit, process.exitCode(), usage, span );
+}
+
+ProcessResult
+Runner::Private::execInHelper( TargetHelper& helper, CalamaresUtils::Trace::Span& span )
+{
+    if ( !input.isEmpty() )
+    {
+        helper.write( input );
+    }
+    if ( !keepInputOpen )
+    {
+        helper.closeInput();
+    }
+
+    const qint64 timeoutMs = std::chrono::milliseconds( timeout ).count();
+    QElapsedTimer timer;
+    timer.start();
+    int failure = 0;
+    bool lost = false;
+    while ( !helper.isFinished() )
+    {
+        int wait = 0;
+        failure = checkStop( timer, timeoutMs, wait );
+        if ( failure )
+        {
+            break;
+        }
+        if ( keepInputOpen )
+        {
+            QByteArray data;
+            const bool close = takeInput( data );
+            if ( !data.isEmpty() )
+            {
+                helper.write( data );
+            }
+            if ( close )
+            {
+                helper.closeInput();
+            }
+        }
+        QByteArray data;
+        lost = !helper.waitForOutput( data, wait );
+        handleOutput( data );
+        if ( lost )
+        {
+            break;
+        }
+    }
+    {
+        // A quick command may be done before start() returns; then
+        // its output arrived with the Started frame and is still there.
+        QByteArray data;
+        helper.waitForOutput( data, 0 );
+        handleOutput( data );
+    }
+    if ( failure )
+    {
+        // The helper kills the whole process group; wait for that, so the helper can be re-used
+        helper.kill();
+        QByteArray data;
+        while ( !helper.isFinished() && helper.waitForOutput( data, CANCEL_POLL_INTERVAL ) )
+        {
+        }
+        handleOutput( data );
+    }
+    if ( lost )
+    {
+        cWarning() << "Lost connection to the target helper while running" << command.first();
+    }
+
+    const int status = helper.exitStatus();
+    ResourceUsage usage = helper.usage();
+    usage.wallTime = timer.elapsed();
+    return outcome(
+        failure, lost || WIFSIGNALED( status ), WIFEXITED( status ) ? WEXITSTATUS( status ) : 0, usage, span );
+}
+
+ProcessResult
+Runner::Private::outcome( int failure,
+                          bool crashed,
+                          int exitCode,
+                          const ResourceUsage& usage,
+                          CalamaresUtils::Trace::Span& span )
+{
+    span.setArgument( QStringLiteral( "wall_ms" ), usage.wallTime );
+    if ( usage.userTime >= 0 )
+    {
+        span.setArgument( QStringLiteral( "user_ms" ), usage.userTime );
+        span.setArgument( QStringLiteral( "system_ms" ), usage.systemTime );
+        span.setArgument( QStringLiteral( "maxrss_kib" ), usage.maxRss );
+        span.setArgument( QStringLiteral( "blocks_read" ), usage.blocksRead );
+        span.setArgument( QStringLiteral( "blocks_written" ), usage.blocksWritten );
+        span.setArgument( QStringLiteral( "usage_exact" ), usage.isExact() );
+    }
+    auto withUsage = [ &usage ]( ProcessResult r ) {
+        r.setUsage( usage );
+        return r;
+    };
+
+    if ( !partialLine.isEmpty() )
+    {
+        deliver( partialLine );
+        partialLine.clear();
+    }
+
+    const QString outputText
+        = outputLimit < 0 ? QString::fromLocal8Bit( output ).trimmed() : lastLines.join( '\n' ).trimmed();
+    output.clear();
+    lastLines.clear();
+
+    if ( failure == static_cast< int >( ProcessResult::Code::Cancelled ) )
+    {
+        cWarning() << "Process" << command.first() << "was cancelled. Output so far:\n"
+                   << Logger::NoQuote {} << outputText;
+        span.setArgument( QStringLiteral( "exit" ), failure );
+        return withUsage( ProcessResult::Code::Cancelled );
+    }
+    if ( failure )
+    {
+        cWarning() << "Process" << command.first() << "timed out after" << timeout.count() << "s. Output so far:\n"
+                   << Logger::NoQuote {} << outputText;
+        span.setArgument( QStringLiteral( "exit" ), failure );
+        return withUsage( ProcessResult::Code::TimedOut );
+    }
 
-    if ( process.exitStatus() == QProcess::CrashExit )
+    if ( crashed )
     {
-        cWarning() << "Process" << args.first() << "crashed. Output so far:\n" << Logger::NoQuote {} << output;
-        return ProcessResult::Code::Crashed;
+        cWarning() << "Process" << command.first() << "crashed. Output so far:\n" << Logger::NoQuote {} << outputText;
+        span.setArgument( QStringLiteral( "exit" ), static_cast< int >( ProcessResult::Code::Crashed ) );
+        return withUsage( ProcessResult::Code::Crashed );
     }
 
-    auto r = process.exitCode();
-    cDebug() << Logger::SubEntry << "Finished. Exit code:" << r;
+    auto r = exitCode;
+    span.setArgument( QStringLiteral( "exit" ), r );
+    cDebug() << Logger::SubEntry << "Finished. Exit code:" << r << "time" << usage.wallTime << "ms, CPU"
+             << ( usage.userTime + usage.systemTime ) << "ms" << ( usage.isExact() ? "" : "(approximately)" );
     bool showDebug = ( !Calamares::Settings::instance() ) || ( Calamares::Settings::instance()->debugMode() );
     if ( ( r != 0 ) || showDebug )
     {
-        cDebug() << Logger::SubEntry << "Target cmd:" << RedactedList( args ) << "output:\n"
-                 << Logger::NoQuote {} << output;
+        cDebug() << Logger::SubEntry << "Target cmd:" << RedactedList( command ) << "output:\n"
+                 << Logger::NoQuote {} << outputText;
+    }
+    return withUsage( ProcessResult( r, outputText ) );
+}
+
+Runner::Runner( const QStringList& command )
+    : d( std::make_unique< Private >() )
+{
+    d->command = command;
+}
+
+Runner::~Runner()
+{
+    if ( d->thread )
+    {
+        {
+            QMutexLocker l( &d->mutex );
+            d->stopping = true;
+            d->lineTaken.wakeAll();
+        }
+        d->thread->wait();
+    }
+}
+
+Runner&
+Runner::setLocation( System::RunLocation location )
+{
+    d->location = location;
+    return *this;
+}
+
+Runner&
+Runner::setWorkingDirectory( const QString& path )
+{
+    d->workingDirectory = path;
+    return *this;
+}
+
+Runner&
+Runner::setTimeout( std::chrono::seconds timeout )
+{
+    d->timeout = timeout;
+    return *this;
+}
+
+Runner&
+Runner::setInput( const QByteArray& input, bool keepOpen )
+{
+    d->input = input;
+    d->keepInputOpen = keepOpen;
+    return *this;
+}
+
+Runner&
+Runner::setOutputLimit( int lines )
+{
+    d->outputLimit = lines;
+    return *this;
+}
+
+Runner&
+Runner::setLineCallback( const LineCallback& callback )
+{
+    d->callback = callback;
+    return *this;
+}
+
+Runner&
+Runner::setQueueSize( int lines )
+{
+    d->queueSize = lines;
+    return *this;
+}
+
+ProcessResult
+Runner::run()
+{
+    if ( d->thread )
+    {
+        return wait();
     }
-    return ProcessResult( r, output );
+    d->token = Calamares::CancellationToken::current();
+    d->finish( d->exec() );
+    return d->result;
+}
+
+bool
+Runner::start()
+{
+    if ( d->thread )
+    {
+        return false;
+    }
+    d->token = Calamares::CancellationToken::current();
+    d->thread = std::make_unique< RunnerThread >( d.get() );
+    d->thread->start();
+    return true;
+}
+
+ProcessResult
+Runner::wait()
+{
+    if ( d->thread )
+    {
+        d->thread->wait();
+    }
+    QMutexLocker l( &d->mutex );
+    return d->result;
+}
+
+bool
+Runner::isFinished() const
+{
+    QMutexLocker l( &d->mutex );
+    return d->finished;
+}
+
+bool
+Runner::nextLine( QString& line )
+{
+    QMutexLocker l( &d->mutex );
+    while ( d->queue.isEmpty() && !d->finished )
+    {
+        d->lineQueued.wait( &d->mutex );
+    }
+    if ( d->queue.isEmpty() )
+    {
+        return false;
+    }
+    line = d->queue.dequeue();
+    d->lineTaken.wakeAll();
+    return true;
+}
+
+bool
+Runner::write( const QByteArray& data )
+{
+    QMutexLocker l( &d->mutex );
+    if ( d->finished || !d->keepInputOpen )
+    {
+        return false;
+    }
+    d->pendingInput.append( data );
+    return true;
+}
+
+void
+Runner::closeInput()
+{
+    QMutexLocker l( &d->mutex );
+    d->closeInputRequested = true;
 }
 
 /// @brief Cheap check if a path is absolute.
@@ -369,17 +1190,15 @@ System::getCpuDescription() const
     QString model;
 
 #ifdef Q_OS_LINUX
-    QFile file( "/proc/cpuinfo" );
-    if ( file.open( QIODevice::ReadOnly | QIODevice::Text ) )
-        while ( !file.atEnd() )
+    const auto lines = CalamaresUtils::Probe::readFile( "/proc/cpuinfo" ).split( '\n' );
+    for ( const QByteArray& line : lines )
+    {
+        if ( line.startsWith( "model name" ) && ( line.indexOf( ':' ) > 0 ) )
         {
-            QByteArray line = file.readLine();
-            if ( line.startsWith( "model name" ) && ( line.indexOf( ':' ) > 0 ) )
-            {
-                model = QString::fromLatin1( line.right( line.length() - line.indexOf( ':' ) ) );
-                break;
-            }
+            model = QString::fromLatin1( line.right( line.length() - line.indexOf( ':' ) ) );
+            break;
         }
+    }
 #elif defined( Q_OS_FREEBSD )
     // This would use sysctl "hw.model", which has a string value
 #endif
@@ -436,6 +1255,14 @@ ProcessResult::explainProcess( int ec, const QString& command, const QString& ou
                     .arg( timeout.count() )
                 + outputMessage );
 
+    if ( ec == static_cast< int >( ProcessResult::Code::Cancelled ) )
+        return JobResult::error(
+            QCoreApplication::translate( "ProcessResult", "External command was cancelled." ),
+            QCoreApplication::translate( "ProcessResult",
+                                         "Command <i>%1</i> was stopped because the installation was cancelled." )
+                    .arg( command )
+                + outputMessage );
+
     //Any other exit code
     return JobResult::error(
         QCoreApplication::translate( "ProcessResult", "External command finished with errors." ),
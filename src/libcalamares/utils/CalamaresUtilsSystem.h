@@ -15,14 +15,44 @@
 
 #include "Job.h"
 
+#include <QByteArray>
 #include <QObject>
 #include <QPair>
 #include <QString>
+#include <QStringList>
 
 #include <chrono>
+#include <functional>
+#include <memory>
 
 namespace CalamaresUtils
 {
+/** @brief Resources used by a command
+ *
+ * Times are in milliseconds, memory in KiB and I/O in blocks of
+ * 512 bytes (as counted by the kernel). Values that are not known
+ * are -1; the wall time is always known for commands that ran.
+ *
+ * Commands run by a TargetHelper are measured exactly. Other
+ * commands are measured by the difference in resources used by
+ * all child processes of Calamares; isExact() is false if other
+ * commands ran at the same time, so some of their usage may be
+ * counted for this one.
+ */
+struct ResourceUsage
+{
+    qint64 wallTime = -1;
+    qint64 userTime = -1;
+    qint64 systemTime = -1;
+    qint64 maxRss = -1;  ///< Largest resident set size
+    qint64 blocksRead = -1;
+    qint64 blocksWritten = -1;
+    bool exact = false;
+
+    bool isValid() const { return wallTime >= 0; }
+    bool isExact() const { return exact; }
+};
+
 class ProcessResult : public QPair< int, QString >
 {
 public:
@@ -31,7 +61,8 @@ public:
         Crashed = -1,  // Must match special return values from QProcess
         FailedToStart = -2,  // Must match special return values from QProcess
         NoWorkingDirectory = -3,
-        TimedOut = -4
+        TimedOut = -4,
+        Cancelled = -5  ///< The job queue was cancelled, see Calamares::CancellationToken
     };
 
     /** @brief Implicit one-argument constructor has no output, only a return code */
@@ -47,6 +78,10 @@ public:
     int getExitCode() const { return first; }
     QString getOutput() const { return second; }
 
+    /// @brief Resources used by the command (not valid if it did not start)
+    const ResourceUsage& usage() const { return m_usage; }
+    void setUsage( const ResourceUsage& usage ) { m_usage = usage; }
+
     /** @brief Explain a typical external process failure.
      *
      * @param errorCode Return code from runCommand() or similar
@@ -74,6 +109,9 @@ public:
     {
         return explainProcess( getExitCode(), command.join( ' ' ), getOutput(), timeout );
     }
+
+private:
+    ResourceUsage m_usage;
 };
 
 /** @brief The result of a create*() action, for status
@@ -155,6 +193,11 @@ public:
       *             FailedToStart = QProcess cannot start
       *             NoWorkingDirectory = bad arguments
       *             TimedOut = QProcess timeout
+      *     Like env(1) and chroot(1), a program that does not exist
+      *     gives exit code 127, and one that can't be executed 126.
+      *
+      * This waits for the program to finish; use a Runner to read the
+      * output while the program is running.
       */
     static DLLEXPORT ProcessResult runCommand( RunLocation location,
                                                const QStringList& args,
@@ -341,6 +384,88 @@ private:
     bool m_doChroot;
 };
 
+/** @brief Runs a command, with access to its output while it runs
+ *
+ * System::runCommand() returns only when the command has finished,
+ * with all of its output. A Runner can hand each line of output to
+ * a callback (e.g. to report progress) or queue the lines for
+ * nextLine(), keeps only the last lines of output for the result,
+ * and can write to the command's standard input while it runs.
+ *
+ * Set up the Runner, then either run() it, which blocks until the
+ * command has finished, or start() it, which runs the command in a
+ * background thread; then wait() for the result. Destroying a Runner
+ * kills the command if it is still running.
+ *
+ * The command is killed if the job that started it is cancelled.
+ */
+class DLLEXPORT Runner
+{
+public:
+    /// @brief Called with each line of output, without the newline
+    using LineCallback = std::function< void( const QString& ) >;
+
+    explicit Runner( const QStringList& command );
+    Runner( const Runner& ) = delete;
+    Runner& operator=( const Runner& ) = delete;
+    ~Runner();
+
+    Runner& setLocation( System::RunLocation location );
+    Runner& setWorkingDirectory( const QString& path );
+    /// @brief Kills the command after @p timeout (0, the default, for no timeout)
+    Runner& setTimeout( std::chrono::seconds timeout );
+    /** @brief Data written to the command's standard input when it starts
+     *
+     * Standard input is closed afterwards, unless @p keepOpen is true;
+     * then use write() to send more data, and closeInput() when done.
+     */
+    Runner& setInput( const QByteArray& input, bool keepOpen = false );
+    /** @brief Keep only the last @p lines lines of output for the result
+     *
+     * The default, -1, keeps all the output as-is, like
+     * System::runCommand() does. Lines are always handed to
+     * the callback and the queue, regardless of the limit.
+     */
+    Runner& setOutputLimit( int lines );
+    /** @brief Calls @p callback for each line of output
+     *
+     * When start() is used, the callback is called from the
+     * background thread.
+     */
+    Runner& setLineCallback( const LineCallback& callback );
+    /** @brief Queues the output for nextLine(), at most @p lines at a time
+     *
+     * If the queue is full, the Runner stops reading output until
+     * nextLine() is called, which in the end makes the command wait.
+     */
+    Runner& setQueueSize( int lines );
+
+    /// @brief Runs the command and waits for it to finish
+    ProcessResult run();
+    /// @brief Runs the command in a background thread; returns false if already started
+    bool start();
+    /// @brief Waits for the command that was start()ed to finish
+    ProcessResult wait();
+    bool isFinished() const;
+
+    /** @brief Gets the next line of output from the queue
+     *
+     * Blocks until a line is available. Returns false when the
+     * command has finished and all of its output has been read.
+     * See setQueueSize().
+     */
+    bool nextLine( QString& line );
+    /// @brief Writes to standard input; see setInput()
+    bool write( const QByteArray& data );
+    /// @brief Closes standard input, so that the command sees end-of-file
+    void closeInput();
+
+    struct Private;
+
+private:
+    std::unique_ptr< Private > d;
+};
+
 }  // namespace CalamaresUtils
 
 #endif
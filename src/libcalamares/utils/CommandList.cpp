@@ -16,11 +16,18 @@
 // #include "utils/CalamaresUtils.h"
 #include "utils/CalamaresUtilsSystem.h"
 #include "utils/Logger.h"
+#include "utils/String.h"
 #include "utils/Variant.h"
 
 #include <QCoreApplication>
+#include <QRunnable>
+#include <QThread>
+#include <QThreadPool>
 #include <QVariantList>
 
+#include <atomic>
+#include <vector>
+
 namespace CalamaresUtils
 {
 
@@ -38,8 +45,15 @@ get_variant_object( const QVariantMap& m )
     return CommandLine();
 }
 
+/** @brief Reads the commands in @p l
+ *
+ * A map with key *parallel* is a group of commands that may run at
+ * the same time; its limit (*jobs*) is appended to @p groupJobs and
+ * the commands get the index of that + 1 as group. Groups can not
+ * be nested; pass nullptr for @p groupJobs to refuse them.
+ */
 static CommandList_t
-get_variant_stringlist( const QVariantList& l )
+get_variant_stringlist( const QVariantList& l, QVector< int >* groupJobs )
 {
     CommandList_t retl;
     unsigned int count = 0;
@@ -49,6 +63,27 @@ get_variant_stringlist( const QVariantList& l )
         {
             retl.append( CommandLine( v.toString(), CommandLine::TimeoutNotSet() ) );
         }
+        else if ( v.type() == QVariant::Map && v.toMap().contains( "parallel" ) )
+        {
+            const auto m = v.toMap();
+            const auto commands = m.value( "parallel" );
+            if ( !groupJobs )
+            {
+                cWarning() << "Parallel CommandList groups can not be nested" << count << v;
+            }
+            else
+            {
+                groupJobs->append( qMax( 0, int( CalamaresUtils::getInteger( m, "jobs", 0 ) ) ) );
+                const int group = groupJobs->count();
+                auto group_list = get_variant_stringlist(
+                    commands.type() == QVariant::List ? commands.toList() : QVariantList { commands }, nullptr );
+                for ( auto& command : group_list )
+                {
+                    command.setGroup( group );
+                }
+                retl.append( group_list );
+            }
+        }
         else if ( v.type() == QVariant::Map )
         {
             auto command( get_variant_object( v.toMap() ) );
@@ -81,7 +116,7 @@ CommandList::CommandList::CommandList( const QVariant& v, bool doChroot, std::ch
         const auto v_list = v.toList();
         if ( v_list.count() )
         {
-            append( get_variant_stringlist( v_list ) );
+            append( get_variant_stringlist( v_list, &m_groupJobs ) );
         }
         else
         {
@@ -92,6 +127,10 @@ CommandList::CommandList::CommandList( const QVariant& v, bool doChroot, std::ch
     {
         append( v.toString() );
     }
+    else if ( v.type() == QVariant::Map && v.toMap().contains( "parallel" ) )
+    {
+        append( get_variant_stringlist( QVariantList { v }, &m_groupJobs ) );
+    }
     else if ( v.type() == QVariant::Map )
     {
         auto c( get_variant_object( v.toMap() ) );
@@ -109,6 +148,42 @@ CommandList::CommandList::CommandList( const QVariant& v, bool doChroot, std::ch
 
 CommandList::~CommandList() {}
 
+int
+CommandList::groupJobs( int group ) const
+{
+    const int jobs = m_groupJobs.value( group - 1, 1 );
+    return jobs > 0 ? jobs : QThread::idealThreadCount();
+}
+
+QStringList
+splitSimpleCommand( const QString& command )
+{
+    // Characters that the shell takes literally, in the middle of a word
+    static const QString plain = QStringLiteral( "-_./=:,+@%" );
+    // Builtins and keywords do not exist as programs
+    static const QStringList builtins { ".",       ":",        "alias",  "bg",     "break",    "case",   "cd",
+                                        "command", "continue", "eval",   "exec",   "exit",     "export", "fg",
+                                        "for",     "getopts",  "hash",   "if",     "jobs",     "local",  "read",
+                                        "readonly", "return",  "set",    "shift",  "source",   "time",   "times",
+                                        "trap",    "type",     "ulimit", "umask",  "unalias",  "unset",  "until",
+                                        "wait",    "while" };
+
+    for ( const QChar c : command )
+    {
+        if ( !( c == ' ' || c.isLetterOrNumber() || plain.contains( c ) ) )
+        {
+            return QStringList();
+        }
+    }
+    const QStringList words = command.split( ' ', SplitSkipEmptyParts );
+    // The first word might also be a variable assignment
+    if ( words.isEmpty() || words.first().contains( '=' ) || builtins.contains( words.first() ) )
+    {
+        return QStringList();
+    }
+    return words;
+}
+
 static inline bool
 findInCommands( const CommandList& l, const QString& needle )
 {
@@ -120,6 +195,82 @@ findInCommands( const CommandList& l, const QString& needle )
     return false;
 }
 
+namespace
+{
+/// @brief A command from the list, ready to run
+struct PreparedCommand
+{
+    QString command;  ///< After substitution, for messages
+    QStringList arguments;
+    bool suppressResult = false;
+    std::chrono::seconds timeout;
+};
+
+/** @brief Runs one command of a parallel group, on a thread pool
+ *
+ * The cancellation token is per-thread, so the @p token of the job
+ * running the list is passed in and set on the pool thread, so that
+ * the command is killed when the job queue is cancelled.
+ */
+class GroupRunner : public QRunnable
+{
+public:
+    GroupRunner( System::RunLocation location,
+                 const PreparedCommand& command,
+                 ProcessResult& result,
+                 std::atomic< bool >& failed,
+                 const Calamares::CancellationToken* token )
+        : m_location( location )
+        , m_command( command )
+        , m_result( result )
+        , m_failed( failed )
+        , m_token( token )
+    {
+    }
+
+    void run() override
+    {
+        // Once a command has failed, the rest of the group is not started
+        if ( m_failed || ( m_token && m_token->isCancelled() ) )
+        {
+            return;
+        }
+        Calamares::CancellationToken::setCurrent( m_token );
+        m_result = System::runCommand( m_location, m_command.arguments, QString(), QString(), m_command.timeout );
+        Calamares::CancellationToken::setCurrent( nullptr );
+        if ( m_result.getExitCode() != 0 && !m_command.suppressResult )
+        {
+            m_failed = true;
+        }
+    }
+
+private:
+    System::RunLocation m_location;
+    const PreparedCommand& m_command;
+    ProcessResult& m_result;
+    std::atomic< bool >& m_failed;
+    const Calamares::CancellationToken* m_token;
+};
+}  // namespace
+
+/// @brief Checks the result @p r of command @p c; returns false if it stops the list
+static bool
+checkResult( const PreparedCommand& c, const ProcessResult& r )
+{
+    if ( r.getExitCode() != 0 )
+    {
+        if ( c.suppressResult )
+        {
+            cDebug() << "Error code" << r.getExitCode() << "ignored by CommandList configuration.";
+        }
+        else
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
 Calamares::JobResult
 CommandList::run()
 {
@@ -158,34 +309,88 @@ CommandList::run()
     }
     QString user = gs->value( "username" ).toString();  // may be blank if unset
 
+    QVector< PreparedCommand > commands;
+    commands.reserve( count() );
     for ( CommandList::const_iterator i = cbegin(); i != cend(); ++i )
     {
-        QString processed_cmd = i->command();
-        processed_cmd.replace( rootMagic, root ).replace( userMagic, user );
-        bool suppress_result = false;
-        if ( processed_cmd.startsWith( '-' ) )
+        PreparedCommand c;
+        c.command = i->command();
+        c.command.replace( rootMagic, root ).replace( userMagic, user );
+        if ( c.command.startsWith( '-' ) )
+        {
+            c.suppressResult = true;
+            c.command.remove( 0, 1 );  // Drop the -
+        }
+
+        c.arguments = splitSimpleCommand( c.command );
+        if ( c.arguments.isEmpty() )
+        {
+            c.arguments = QStringList { "/bin/sh", "-c", c.command };
+        }
+
+        c.timeout = i->timeout() >= std::chrono::seconds::zero() ? i->timeout() : m_timeout;
+        commands.append( c );
+    }
+
+    for ( int i = 0; i < commands.count(); )
+    {
+        const int group = at( i ).group();
+        if ( !group )
         {
-            suppress_result = true;
-            processed_cmd.remove( 0, 1 );  // Drop the -
+            const auto& c = commands.at( i );
+            ProcessResult r = System::runCommand( location, c.arguments, QString(), QString(), c.timeout );
+            if ( !checkResult( c, r ) )
+            {
+                return r.explainProcess( c.command, c.timeout );
+            }
+            ++i;
+            continue;
         }
 
-        QStringList shell_cmd { "/bin/sh", "-c" };
-        shell_cmd << processed_cmd;
+        int end = i + 1;
+        while ( end < commands.count() && at( end ).group() == group )
+        {
+            ++end;
+        }
 
-        std::chrono::seconds timeout = i->timeout() >= std::chrono::seconds::zero() ? i->timeout() : m_timeout;
-        ProcessResult r = System::runCommand( location, shell_cmd, QString(), QString(), timeout );
+        cDebug() << "Running" << ( end - i ) << "commands, at most" << groupJobs( group ) << "at a time.";
+        // Commands that are not started keep this result
+        std::vector< ProcessResult > results( std::size_t( end - i ), ProcessResult::Code::Cancelled );
+        std::atomic< bool > failed { false };
+        const auto* token = Calamares::CancellationToken::current();
+        {
+            QThreadPool pool;
+            pool.setMaxThreadCount( groupJobs( group ) );
+            for ( int k = i; k < end; ++k )
+            {
+                pool.start(
+                    new GroupRunner( location, commands.at( k ), results[ std::size_t( k - i ) ], failed, token ) );
+            }
+            pool.waitForDone();
+        }
 
-        if ( r.getExitCode() != 0 )
+        // Log the output of each command together, and report
+        // the first failure in the order of the list.
+        for ( int k = i; k < end; ++k )
         {
-            if ( suppress_result )
+            const auto& c = commands.at( k );
+            const auto& r = results[ std::size_t( k - i ) ];
+            cDebug() << Logger::SubEntry << "Command" << c.command << "exit code" << r.getExitCode();
+            if ( !r.getOutput().isEmpty() )
             {
-                cDebug() << "Error code" << r.getExitCode() << "ignored by CommandList configuration.";
+                cDebug() << Logger::SubEntry << "output:\n" << Logger::NoQuote {} << r.getOutput();
             }
-            else
+        }
+        for ( int k = i; k < end; ++k )
+        {
+            const auto& c = commands.at( k );
+            const auto& r = results[ std::size_t( k - i ) ];
+            if ( !checkResult( c, r ) )
             {
-                return r.explainProcess( processed_cmd, timeout );
+                return r.explainProcess( c.command, c.timeout );
             }
         }
+        i = end;
     }
 
     return Calamares::JobResult::ok();
@@ -15,6 +15,7 @@
 
 #include <QStringList>
 #include <QVariant>
+#include <QVector>
 
 #include <chrono>
 
@@ -50,8 +51,29 @@ struct CommandLine : public QPair< QString, std::chrono::seconds >
     std::chrono::seconds timeout() const { return second; }
 
     bool isValid() const { return !first.isEmpty(); }
+
+    /** @brief The parallel group of this command
+     *
+     * Consecutive commands with the same (non-zero) group may run
+     * at the same time. Group 0 means the command runs on its own.
+     */
+    int group() const { return m_group; }
+    void setGroup( int group ) { m_group = group; }
+
+private:
+    int m_group = 0;
 };
 
+/** @brief Splits @p command into words, if it does not need a shell
+ *
+ * Commands in a CommandList are shell commands, but most of them are
+ * just words that can be executed directly, without starting a shell
+ * first. Returns an empty list if the shell would do something with
+ * the command: quotes, variables, redirection, globs, and so on, or
+ * if the command is a shell builtin.
+ */
+DLLEXPORT QStringList splitSimpleCommand( const QString& command );
+
 /** @brief Abbreviation, used internally. */
 using CommandList_t = QList< CommandLine >;
 
@@ -73,6 +95,22 @@ public:
 
     bool doChroot() const { return m_doChroot; }
 
+    /** @brief How many commands of parallel @p group may run at once
+     *
+     * This is the *jobs* value of the group, or the number of
+     * CPU cores if that is not set.
+     */
+    int groupJobs( int group ) const;
+
+    /** @brief Runs the commands
+     *
+     * Commands run one after the other, except for parallel groups:
+     * all the commands in a group may run at the same time (up to the
+     * group's limit). A failing command in a group does not stop the
+     * commands that are already running, but the remaining commands
+     * of the group are not started, and the list fails once the
+     * running ones are done.
+     */
     Calamares::JobResult run();
 
     using CommandList_t::at;
@@ -89,6 +127,7 @@ protected:
 private:
     bool m_doChroot;
     std::chrono::seconds m_timeout;
+    QVector< int > m_groupJobs;  ///< The jobs limit of group n is at n - 1
 };
 
 }  // namespace CalamaresUtils
@@ -17,29 +17,449 @@
 #include "utils/Dirs.h"
 
 #include <QCoreApplication>
+#include <QDateTime>
 #include <QDir>
-#include <QFileInfo>
+#include <QFile>
 #include <QMutex>
+#include <QThread>
 #include <QTime>
 #include <QVariant>
+#include <QWaitCondition>
 
+#include <atomic>
+#include <csignal>
+#include <cstdlib>
+#include <ctime>
 #include <fstream>
 #include <iostream>
+#include <memory>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <sys/stat.h>
+#include <zlib.h>
 
 static constexpr const int LOGFILE_SIZE = 1024 * 256;
+/// @brief Number of old (compressed) logs that are kept
+static constexpr const int LOGFILE_GENERATIONS = 3;
 
 static std::ofstream logfile;
+static int s_crashFd = -1;  ///< The log file again, for writing from the crash handler
 static unsigned int s_threshold =
 #ifdef QT_NO_DEBUG
     Logger::LOG_DISABLE;
 #else
     Logger::LOGEXTRA + 1;  // Comparison is < in log() function
 #endif
-static QMutex s_mutex;
+static QMutex s_mutex;  ///< Held while writing
+static std::atomic< bool > s_asynchronous { false };
 
 static const char s_Continuation[] = "\n    ";
 static const char s_SubEntry[] = "    .. ";
 
+/// @brief Interval (ms) at which the writer thread writes out queued lines
+static constexpr unsigned long WRITER_INTERVAL = 100;
+
+namespace
+{
+struct LogEntry
+{
+    qint64 time = 0;  ///< ms since the epoch
+    unsigned int level = 0;
+    bool withTime = true;
+    QByteArray message;
+};
+
+/** @brief Bounded multi-producer queue of log lines
+ *
+ * This is the array-based queue by Dmitry Vyukov: producers claim
+ * a slot by advancing the enqueue position, and publish the entry
+ * by setting the sequence number of the slot. Logging threads
+ * never wait for each other, or for the disk.
+ *
+ * There is only one consumer at a time: whoever holds s_mutex.
+ */
+class LogQueue
+{
+public:
+    static constexpr std::size_t Size = 4096;  // Must be a power of two
+
+    LogQueue()
+        : m_slots( new Slot[ Size ] )
+    {
+        for ( std::size_t i = 0; i < Size; ++i )
+        {
+            m_slots[ i ].sequence.store( i, std::memory_order_relaxed );
+        }
+    }
+
+    /// @brief Adds @p e to the queue; returns false if the queue is full
+    bool push( LogEntry& e )
+    {
+        std::size_t position = m_enqueue.load( std::memory_order_relaxed );
+        for ( ;; )
+        {
+            Slot& slot = m_slots[ position & ( Size - 1 ) ];
+            const std::size_t sequence = slot.sequence.load( std::memory_order_acquire );
+            const auto difference = static_cast< std::ptrdiff_t >( sequence - position );
+            if ( difference == 0 )
+            {
+                if ( m_enqueue.compare_exchange_weak( position, position + 1, std::memory_order_relaxed ) )
+                {
+                    slot.entry = std::move( e );
+                    slot.sequence.store( position + 1, std::memory_order_release );
+                    return true;
+                }
+            }
+            else if ( difference < 0 )
+            {
+                return false;
+            }
+            else
+            {
+                position = m_enqueue.load( std::memory_order_relaxed );
+            }
+        }
+    }
+
+    /// @brief Takes the oldest entry; returns false if there is none (yet)
+    bool pop( LogEntry& e )
+    {
+        const std::size_t position = m_dequeue.load( std::memory_order_relaxed );
+        Slot& slot = m_slots[ position & ( Size - 1 ) ];
+        if ( slot.sequence.load( std::memory_order_acquire ) != position + 1 )
+        {
+            return false;
+        }
+        e = std::move( slot.entry );
+        slot.sequence.store( position + Size, std::memory_order_release );
+        m_dequeue.store( position + 1, std::memory_order_relaxed );
+        return true;
+    }
+
+    /** @brief Calls @p f for each entry that is queued, without taking it
+     *
+     * This does not allocate or free anything, so the crash handler
+     * can use it. Call this with s_mutex held.
+     */
+    template < typename F >
+    void peekAll( F f ) const
+    {
+        for ( std::size_t position = m_dequeue.load( std::memory_order_relaxed );; ++position )
+        {
+            const Slot& slot = m_slots[ position & ( Size - 1 ) ];
+            if ( slot.sequence.load( std::memory_order_acquire ) != position + 1 )
+            {
+                return;
+            }
+            f( slot.entry );
+        }
+    }
+
+    /// @brief Is the queue filling up? Then the writer should hurry
+    bool isFilling() const
+    {
+        return m_enqueue.load( std::memory_order_relaxed ) - m_dequeue.load( std::memory_order_relaxed ) > Size / 2;
+    }
+
+private:
+    struct Slot
+    {
+        std::atomic< std::size_t > sequence;
+        LogEntry entry;
+    };
+
+    std::unique_ptr< Slot[] > m_slots;
+    std::atomic< std::size_t > m_enqueue { 0 };
+    std::atomic< std::size_t > m_dequeue { 0 };  ///< Only changed by the consumer
+};
+}  // namespace
+
+static LogQueue s_queue;
+
+/// @brief Formats @p time like QTime::toString() does, with the date like Qt::ISODate
+static void
+formatTime( qint64 time, char ( &date )[ 16 ], char ( &clock )[ 16 ] )
+{
+    const std::time_t seconds = static_cast< std::time_t >( time / 1000 );
+    struct tm t;
+    ::localtime_r( &seconds, &t );
+    std::strftime( date, sizeof( date ), "%Y-%m-%d", &t );
+    std::strftime( clock, sizeof( clock ), "%H:%M:%S", &t );
+}
+
+/** @brief Writes one entry to the log file and stdout, without flushing
+ *
+ * Call this with s_mutex held.
+ */
+static void
+writeEntry( const LogEntry& e )
+{
+    char date[ 16 ];
+    char clock[ 16 ];
+    formatTime( e.time, date, clock );
+
+    logfile << date << " - " << clock << " [" << e.level << "]: " << e.message.constData() << '\n';
+
+    if ( Logger::logLevelEnabled( e.level ) )
+    {
+        if ( e.withTime )
+        {
+            std::cout << clock << " [" << e.level << "]: ";
+        }
+        std::cout << e.message.constData() << '\n';
+    }
+}
+
+/// @brief Writes all the queued entries; call this with s_mutex held
+static void
+drainQueue()
+{
+    LogEntry e;
+    bool written = false;
+    while ( s_queue.pop( e ) )
+    {
+        writeEntry( e );
+        written = true;
+    }
+    if ( written )
+    {
+        logfile.flush();
+        std::cout.flush();
+    }
+}
+
+/// @brief The name of old log number @p generation of @p path
+static QByteArray
+generationName( const QByteArray& path, int generation, bool compressed )
+{
+    return path + '.' + QByteArray::number( generation ) + ( compressed ? ".gz" : "" );
+}
+
+/** @brief Compresses @p path to @p path.gz, and removes @p path
+ *
+ * The file is streamed through zlib in blocks. If compression fails,
+ * the uncompressed file is kept.
+ */
+static bool
+compressFile( const QByteArray& path )
+{
+    QFile in( path );
+    if ( !in.open( QIODevice::ReadOnly ) )
+    {
+        return false;
+    }
+    const QByteArray target = path + ".gz";
+    gzFile out = gzopen( target.constData(), "wb" );
+    if ( !out )
+    {
+        return false;
+    }
+
+    char buffer[ 16384 ];
+    qint64 r = 0;
+    bool ok = true;
+    while ( ok && ( r = in.read( buffer, sizeof( buffer ) ) ) > 0 )
+    {
+        ok = gzwrite( out, buffer, unsigned( r ) ) == int( r );
+    }
+    ok = ( gzclose( out ) == Z_OK ) && ok && r == 0;
+    QFile::remove( ok ? path : target );
+    return ok;
+}
+
+/** @brief Moves the log at @p path aside if it is too large
+ *
+ * Only the size of the log is checked. A large log becomes old log
+ * number 1 (uncompressed, by renaming it), older logs are shifted up
+ * and the oldest is dropped. Returns the uncompressed old log that
+ * still needs compressing, if any.
+ */
+static QByteArray
+rotateLogfile( const QByteArray& path )
+{
+    const QByteArray pending = generationName( path, 1, false );
+    struct stat st;
+    if ( ::stat( path.constData(), &st ) != 0 || st.st_size <= LOGFILE_SIZE )
+    {
+        // Maybe an earlier run stopped before compressing it
+        return ::stat( pending.constData(), &st ) == 0 ? pending : QByteArray();
+    }
+
+    if ( ::stat( pending.constData(), &st ) == 0 )
+    {
+        compressFile( pending );
+    }
+    ::unlink( generationName( path, LOGFILE_GENERATIONS, true ).constData() );
+    for ( int generation = LOGFILE_GENERATIONS - 1; generation > 0; --generation )
+    {
+        ::rename( generationName( path, generation, true ).constData(),
+                  generationName( path, generation + 1, true ).constData() );
+    }
+    if ( ::rename( path.constData(), pending.constData() ) != 0 )
+    {
+        // Start over in place, then
+        ::truncate( path.constData(), 0 );
+        return QByteArray();
+    }
+    return pending;
+}
+
+namespace
+{
+/// @brief Writes queued log lines to disk, in batches
+class LogWriter : public QThread
+{
+public:
+    void wake() { m_wake.wakeAll(); }
+    void stop()
+    {
+        {
+            QMutexLocker l( &m_wakeMutex );
+            m_stopping = true;
+        }
+        wake();
+        wait();
+    }
+
+    /// @brief Compress old log @p path (see rotateLogfile()) before writing
+    void setPendingCompression( const QByteArray& path ) { m_compress = path; }
+
+protected:
+    void run() override
+    {
+        if ( !m_compress.isEmpty() )
+        {
+            compressFile( m_compress );
+        }
+        for ( ;; )
+        {
+            {
+                QMutexLocker l( &m_wakeMutex );
+                if ( m_stopping )
+                {
+                    break;
+                }
+                m_wake.wait( &m_wakeMutex, WRITER_INTERVAL );
+            }
+            QMutexLocker lock( &s_mutex );
+            drainQueue();
+        }
+    }
+
+private:
+    QMutex m_wakeMutex;
+    QWaitCondition m_wake;
+    bool m_stopping = false;
+    QByteArray m_compress;
+};
+}  // namespace
+
+static LogWriter* s_writer = nullptr;
+
+/// @brief At exit, stop the writer (which writes what is left)
+static void
+stopWriter()
+{
+    if ( s_writer )
+    {
+        s_asynchronous = false;
+        s_writer->stop();
+        QMutexLocker lock( &s_mutex );
+        drainQueue();
+        delete s_writer;
+        s_writer = nullptr;
+    }
+}
+
+/// @brief Writes @p length bytes of @p data to the crash fd; async-signal-safe
+static void
+crashWrite( const char* data, std::size_t length )
+{
+    while ( length > 0 )
+    {
+        const ssize_t r = ::write( s_crashFd, data, length );
+        if ( r <= 0 )
+        {
+            return;
+        }
+        data += r;
+        length -= std::size_t( r );
+    }
+}
+
+/// @brief Writes @p value in decimal to the crash fd; async-signal-safe
+static void
+crashWriteNumber( unsigned long value )
+{
+    char digits[ 24 ];
+    std::size_t i = sizeof( digits );
+    do
+    {
+        digits[ --i ] = char( '0' + value % 10 );
+        value /= 10;
+    } while ( value && i > 0 );
+    crashWrite( digits + i, sizeof( digits ) - i );
+}
+
+static constexpr const int s_crashSignals[] = { SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT };
+/// @brief The handlers that were there before crashHandler(), e.g. from KCrash
+static struct sigaction s_previousHandlers[ sizeof( s_crashSignals ) / sizeof( s_crashSignals[ 0 ] ) ];
+
+/** @brief On a crash, write what is queued before dying
+ *
+ * The queued lines are written with write(2) to a file descriptor
+ * opened by setupLogfile(), with the time as seconds since the epoch,
+ * so that nothing here allocates, locks or formats through libc.
+ * If the crash happened while writing, the queue is left alone.
+ * Then the previous handler (KCrash's, if it is set up) gets the
+ * signal, so crash dialogs and core dumps still work.
+ */
+static void
+crashHandler( int signal, siginfo_t* info, void* context )
+{
+    if ( s_crashFd >= 0 && s_mutex.tryLock() )
+    {
+        static const char header[] = "=== CRASH, signal ";
+        crashWrite( header, sizeof( header ) - 1 );
+        crashWriteNumber( static_cast< unsigned long >( signal ) );
+        crashWrite( "\n", 1 );
+        s_queue.peekAll( []( const LogEntry& e ) {
+            crashWriteNumber( static_cast< unsigned long >( e.time / 1000 ) );
+            crashWrite( " [", 2 );
+            crashWriteNumber( e.level );
+            crashWrite( "]: ", 3 );
+            crashWrite( e.message.constData(), std::size_t( e.message.size() ) );
+            crashWrite( "\n", 1 );
+        } );
+        // The previous handler may log, too
+        s_mutex.unlock();
+    }
+
+    const struct sigaction* previous = nullptr;
+    for ( std::size_t i = 0; i < sizeof( s_crashSignals ) / sizeof( s_crashSignals[ 0 ] ); ++i )
+    {
+        if ( s_crashSignals[ i ] == signal )
+        {
+            previous = &s_previousHandlers[ i ];
+        }
+    }
+    if ( previous && ( previous->sa_flags & SA_SIGINFO ) && previous->sa_sigaction )
+    {
+        previous->sa_sigaction( signal, info, context );
+    }
+    else if ( previous && previous->sa_handler != SIG_DFL && previous->sa_handler != SIG_IGN
+              && previous->sa_handler != nullptr )
+    {
+        previous->sa_handler( signal );
+    }
+    // Either there was no handler, or it returned: die the default way
+    struct sigaction defaultAction = {};
+    defaultAction.sa_handler = SIG_DFL;
+    ::sigaction( signal, &defaultAction, nullptr );
+    ::raise( signal );
+}
 
 namespace Logger
 {
@@ -66,33 +486,43 @@ logLevel()
     return s_threshold > 0 ? s_threshold - 1 : 0;
 }
 
-static void
-log( const char* msg, unsigned int debugLevel, bool withTime = true )
+void
+flush()
 {
-    if ( true )
-    {
-        QMutexLocker lock( &s_mutex );
-
-        // If we don't format the date as a Qt::ISODate then we get a crash when
-        // logging at exit as Qt tries to use QLocale to format, but QLocale is
-        // on its way out.
-        logfile << QDate::currentDate().toString( Qt::ISODate ).toUtf8().data() << " - "
-                << QTime::currentTime().toString().toUtf8().data() << " ["
-                << QString::number( debugLevel ).toUtf8().data() << "]: " << msg << std::endl;
+    QMutexLocker lock( &s_mutex );
+    drainQueue();
+}
 
-        logfile.flush();
-    }
+/** @brief Logs @p msg
+ *
+ * Once the log file is set up, lines are queued for the writer
+ * thread. Errors are written (with everything before them) right
+ * away, as is everything when the queue is full, so that no lines
+ * are lost and the order is kept.
+ */
+static void
+log( const QByteArray& msg, unsigned int debugLevel, bool withTime = true )
+{
+    LogEntry e;
+    e.time = QDateTime::currentMSecsSinceEpoch();
+    e.level = debugLevel;
+    e.withTime = withTime;
+    e.message = msg;
 
-    if ( logLevelEnabled( debugLevel ) )
+    if ( s_asynchronous && debugLevel > LOGERROR && s_queue.push( e ) )
     {
-        QMutexLocker lock( &s_mutex );
-        if ( withTime )
+        if ( s_queue.isFilling() && s_writer )
         {
-            std::cout << QTime::currentTime().toString().toUtf8().data() << " ["
-                      << QString::number( debugLevel ).toUtf8().data() << "]: ";
+            s_writer->wake();
         }
-        std::cout << msg << std::endl;
+        return;
     }
+
+    QMutexLocker lock( &s_mutex );
+    drainQueue();
+    writeEntry( e );
+    logfile.flush();
+    std::cout.flush();
 }
 
 
@@ -101,26 +531,33 @@ CalamaresLogHandler( QtMsgType type, const QMessageLogContext&, const QString& m
 {
     static QMutex s_mutex;
 
-    QByteArray ba = msg.toUtf8();
-    const char* message = ba.constData();
-
-    QMutexLocker locker( &s_mutex );
+    unsigned int level = 0;
     switch ( type )
     {
     case QtDebugMsg:
-        log( message, LOGVERBOSE );
+        level = LOGVERBOSE;
         break;
 
     case QtInfoMsg:
-        log( message, 1 );
+        level = 1;
         break;
 
     case QtCriticalMsg:
     case QtWarningMsg:
     case QtFatalMsg:
-        log( message, 0 );
+        level = 0;
         break;
     }
+    // Qt messages (e.g. from QML) are just as chatty as our own
+    if ( !logLevelEnabled( level ) )
+    {
+        return;
+    }
+
+    QByteArray ba = msg.toUtf8();
+
+    QMutexLocker locker( &s_mutex );
+    log( ba, level );
 }
 
 
@@ -134,25 +571,7 @@ logFile()
 void
 setupLogfile()
 {
-    if ( QFileInfo( logFile().toLocal8Bit() ).size() > LOGFILE_SIZE )
-    {
-        QByteArray lc;
-        {
-            QFile f( logFile().toLocal8Bit() );
-            f.open( QIODevice::ReadOnly | QIODevice::Text );
-            lc = f.readAll();
-            f.close();
-        }
-
-        QFile::remove( logFile().toLocal8Bit() );
-
-        {
-            QFile f( logFile().toLocal8Bit() );
-            f.open( QIODevice::WriteOnly | QIODevice::Text );
-            f.write( lc.right( LOGFILE_SIZE - ( LOGFILE_SIZE / 4 ) ) );
-            f.close();
-        }
-    }
+    const QByteArray pending = rotateLogfile( QFile::encodeName( logFile() ) );
 
     // Since the log isn't open yet, this probably only goes to stdout
     cDebug() << "Using log file:" << logFile();
@@ -166,9 +585,37 @@ setupLogfile()
             logfile << "\n\n" << std::endl;
         }
         logfile << "=== START CALAMARES " << CALAMARES_VERSION << std::endl;
+
+        if ( s_crashFd < 0 )
+        {
+            s_crashFd = ::open( logFile().toLocal8Bit().constData(), O_WRONLY | O_APPEND | O_CLOEXEC );
+        }
     }
 
     qInstallMessageHandler( CalamaresLogHandler );
+
+    if ( !s_writer )
+    {
+        s_writer = new LogWriter;
+        // Compressing takes a moment, so leave it to the writer
+        s_writer->setPendingCompression( pending );
+        s_writer->start( QThread::LowPriority );
+        s_asynchronous = true;
+        std::atexit( stopWriter );
+        // Chain to the handlers that are already there (KCrash is set up before this)
+        struct sigaction action = {};
+        action.sa_sigaction = crashHandler;
+        action.sa_flags = SA_SIGINFO;
+        sigemptyset( &action.sa_mask );
+        for ( std::size_t i = 0; i < sizeof( s_crashSignals ) / sizeof( s_crashSignals[ 0 ] ); ++i )
+        {
+            ::sigaction( s_crashSignals[ i ], &action, &s_previousHandlers[ i ] );
+        }
+    }
+    else if ( !pending.isEmpty() )
+    {
+        compressFile( pending );
+    }
 }
 
 CDebug::CDebug( unsigned int debugLevel, const char* func )
@@ -196,7 +643,7 @@ CDebug::~CDebug()
             m_msg.prepend( s_Continuation );  // Prepending, so back-to-front
             m_msg.prepend( m_funcinfo );
         }
-        log( m_msg.toUtf8().data(), m_debugLevel, m_funcinfo );
+        log( m_msg.toUtf8(), m_debugLevel, m_funcinfo );
     }
 }
 
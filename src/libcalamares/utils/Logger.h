@@ -17,6 +17,15 @@
 
 #include "DllMacro.h"
 
+/** @brief The most-verbose level that is compiled in
+ *
+ * Release builds can set this (with the CMake variable of the same
+ * name) to, e.g., 2 (LOGWARNING) to drop the debug-logging code.
+ */
+#ifndef CALAMARES_LOG_COMPILED_LEVEL
+#define CALAMARES_LOG_COMPILED_LEVEL 8
+#endif
+
 namespace Logger
 {
 struct FuncSuppressor
@@ -95,10 +104,21 @@ DLLEXPORT QString logFile();
  *
  * Call this (once) to start logging to the log file (usually
  * ~/.cache/calamares/session.log ). An existing log file is
- * rolled over if it is too large.
+ * rolled over if it is too large: it is kept as session.log.1.gz,
+ * and a few older generations are kept as well.
  */
 DLLEXPORT void setupLogfile();
 
+/**
+ * @brief Write all log lines that are still queued.
+ *
+ * Once the log file is set up, log lines are written by a background
+ * thread. Errors are written right away, and the remaining lines are
+ * written when Calamares exits (or crashes), so this is only needed
+ * when something else must see the log file complete, now.
+ */
+DLLEXPORT void flush();
+
 /**
  * @brief Set a log level for future logging.
  *
@@ -116,6 +136,27 @@ DLLEXPORT unsigned int logLevel();
 /** @brief Would the given @p level really be logged? */
 DLLEXPORT bool logLevelEnabled( unsigned int level );
 
+/** @brief Would the given @p level be logged, in this build and at runtime?
+ *
+ * Levels above CALAMARES_LOG_COMPILED_LEVEL are never logged, so
+ * that the compiler can remove those log-lines entirely.
+ */
+inline bool
+isLogged( unsigned int level )
+{
+    return level <= CALAMARES_LOG_COMPILED_LEVEL && logLevelEnabled( level );
+}
+
+/// @brief Turns the logging expression in CALAMARES_LOG into a void
+struct LogVoidify
+{
+};
+
+inline void
+operator&( const LogVoidify&, const QDebug& )
+{
+}
+
 /**
  * @brief Row-oriented formatted logging.
  *
@@ -259,8 +300,21 @@ operator<<( QDebug& s, const Pointer& p )
 }
 }  // namespace Logger
 
-#define cDebug() Logger::CDebug( Logger::LOGDEBUG, Q_FUNC_INFO )
-#define cWarning() Logger::CDebug( Logger::LOGWARNING, Q_FUNC_INFO )
-#define cError() Logger::CDebug( Logger::LOGERROR, Q_FUNC_INFO )
+/** @brief Lazy logging
+ *
+ * The level is checked before a CDebug is created, so when the line
+ * would not be logged, none of the arguments are evaluated, e.g.
+ *      cDebug() << DebugList( expensiveList() );
+ * does not call expensiveList() unless debug-logging is enabled.
+ * Lines above CALAMARES_LOG_COMPILED_LEVEL are removed by the compiler.
+ * (The & in the macro binds less tightly than <<, so the whole chain
+ * of arguments is on its right-hand side.)
+ */
+#define CALAMARES_LOG( level ) \
+    !Logger::isLogged( level ) ? (void)0 : Logger::LogVoidify() & Logger::CDebug( level, Q_FUNC_INFO )
+
+#define cDebug() CALAMARES_LOG( Logger::LOGDEBUG )
+#define cWarning() CALAMARES_LOG( Logger::LOGWARNING )
+#define cError() CALAMARES_LOG( Logger::LOGERROR )
 
 #endif
@@ -10,4 +10,30 @@
 
 #include "PluginFactory.h"
 
+#include <QHash>
+
+/** @brief Static modules, by name
+ *
+ * Modules are registered before main() runs, and then only
+ * looked up, so this needs no locking.
+ */
+static QHash< QString, QtPluginInstanceFunction >&
+staticModules()
+{
+    static QHash< QString, QtPluginInstanceFunction > modules;
+    return modules;
+}
+
 CalamaresPluginFactory::~CalamaresPluginFactory() {}
+
+void
+CalamaresPluginFactory::registerStaticModule( const char* name, QtPluginInstanceFunction instance )
+{
+    staticModules().insert( QString::fromUtf8( name ), instance );
+}
+
+QtPluginInstanceFunction
+CalamaresPluginFactory::staticModule( const QString& name )
+{
+    return staticModules().value( name, nullptr );
+}
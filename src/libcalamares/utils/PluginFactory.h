@@ -16,7 +16,10 @@
 #ifndef UTILS_PLUGINFACTORY_H
 #define UTILS_PLUGINFACTORY_H
 
+#include "DllMacro.h"
+
 #include <KPluginFactory>
+#include <QtPlugin>
 
 #define CalamaresPluginFactory_iid "io.calamares.PluginFactory"
 
@@ -72,6 +75,22 @@ public:
     {
         KPluginFactory::registerPlugin< T >( QString(), &createInstance< T, QObject > );
     }
+
+    /** @brief Registers module @p name, which is linked into Calamares
+     *
+     * With BUILD_STATIC_MODULES, C++ modules are static plugins.
+     * Each one has a registration function (see the factory macros,
+     * below), which the calamares executable calls before main().
+     * The @p instance function returns the plugin factory.
+     */
+    DLLEXPORT static void registerStaticModule( const char* name, QtPluginInstanceFunction instance );
+    /** @brief The factory-instance function of static module @p name
+     *
+     * Returns nullptr if module @p name is not linked in, in which
+     * case it must be loaded from a plugin file. Call the function
+     * on the GUI thread, since it creates the factory the first time.
+     */
+    DLLEXPORT static QtPluginInstanceFunction staticModule( const QString& name );
 };
 
 /** @brief declare a Calamares Plugin Factory
@@ -91,6 +110,30 @@ public:
         ~name() override; \
     };
 #define CALAMARES_PLUGIN_FACTORY_DEFINITION( name, pluginRegistrations ) \
-    K_PLUGIN_FACTORY_DEFINITION_WITH_BASEFACTORY( name, CalamaresPluginFactory, pluginRegistrations )
+    K_PLUGIN_FACTORY_DEFINITION_WITH_BASEFACTORY( name, CalamaresPluginFactory, pluginRegistrations ) \
+    CALAMARES_STATIC_MODULE_REGISTRATION( name )
+
+/** @brief Registration of a static module
+ *
+ * A module built as a static plugin is compiled with QT_STATICPLUGIN,
+ * and with CALAMARES_STATIC_MODULE (the module name as a C identifier)
+ * and CALAMARES_STATIC_MODULE_NAME (the module name as a string) defined.
+ * The registration function is calamares_static_module_<identifier>(),
+ * which is called from the calamares executable (which also makes
+ * the linker keep the module). Otherwise, this expands to nothing.
+ */
+#define CALAMARES_STATIC_MODULE_FUNCTION_( id ) calamares_static_module_##id
+#define CALAMARES_STATIC_MODULE_FUNCTION( id ) CALAMARES_STATIC_MODULE_FUNCTION_( id )
+#ifdef CALAMARES_STATIC_MODULE
+#define CALAMARES_STATIC_MODULE_REGISTRATION( name ) \
+    extern const QStaticPlugin qt_static_plugin_##name(); \
+    extern "C" void CALAMARES_STATIC_MODULE_FUNCTION( CALAMARES_STATIC_MODULE )() \
+    { \
+        CalamaresPluginFactory::registerStaticModule( CALAMARES_STATIC_MODULE_NAME, \
+                                                      qt_static_plugin_##name().instance ); \
+    }
+#else
+#define CALAMARES_STATIC_MODULE_REGISTRATION( name )
+#endif
 
 #endif
@@ -0,0 +1,130 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2026 agent <agent@local>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#include "Probe.h"
+
+#include "utils/Logger.h"
+
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+
+#include <algorithm>
+
+namespace
+{
+struct CachedFile
+{
+    qint64 size;
+    QDateTime modified;
+    QByteArray contents;
+};
+}  // namespace
+
+/* The arguments of a command are joined with NUL, which can't
+ * appear in an argument, to make the key.
+ */
+static QString
+commandKey( const QStringList& command )
+{
+    return command.join( QChar( 0 ) );
+}
+
+static QMutex s_mutex;
+static QHash< QString, CalamaresUtils::ProcessResult > s_commands;
+static QHash< QString, CachedFile > s_files;
+
+namespace CalamaresUtils
+{
+namespace Probe
+{
+
+ProcessResult
+run( const QStringList& command, std::chrono::seconds timeout )
+{
+    const QString key = commandKey( command );
+    {
+        QMutexLocker l( &s_mutex );
+        auto it = s_commands.constFind( key );
+        if ( it != s_commands.constEnd() )
+        {
+            return it.value();
+        }
+    }
+
+    // Not locked while running, other probes can go ahead
+    auto r = System::runCommand( System::RunLocation::RunInHost, command, QString(), QString(), timeout );
+    if ( r.getExitCode() >= 0 )
+    {
+        QMutexLocker l( &s_mutex );
+        s_commands.insert( key, r );
+    }
+    return r;
+}
+
+QByteArray
+readFile( const QString& path )
+{
+    QFileInfo fi( path );
+    const qint64 size = fi.size();
+    const QDateTime modified = fi.lastModified();
+    {
+        QMutexLocker l( &s_mutex );
+        auto it = s_files.constFind( path );
+        if ( it != s_files.constEnd() && it->size == size && it->modified == modified )
+        {
+            return it->contents;
+        }
+    }
+
+    QFile file( path );
+    if ( !file.open( QIODevice::ReadOnly ) )
+    {
+        cWarning() << "Could not read" << path;
+        return QByteArray();
+    }
+    CachedFile cached { size, modified, file.readAll() };
+    QMutexLocker l( &s_mutex );
+    s_files.insert( path, cached );
+    return cached.contents;
+}
+
+void
+invalidate()
+{
+    QMutexLocker l( &s_mutex );
+    s_commands.clear();
+    s_files.clear();
+}
+
+void
+invalidate( const QString& argument )
+{
+    QMutexLocker l( &s_mutex );
+    for ( auto it = s_commands.begin(); it != s_commands.end(); )
+    {
+        const auto arguments = it.key().split( QChar( 0 ) );
+        const bool matches = std::any_of(
+            arguments.cbegin(), arguments.cend(), [ &argument ]( const QString& a ) { return a.startsWith( argument ); } );
+        if ( matches )
+        {
+            it = s_commands.erase( it );
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+}  // namespace Probe
+}  // namespace CalamaresUtils
@@ -0,0 +1,66 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2026 agent <agent@local>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#ifndef UTILS_PROBE_H
+#define UTILS_PROBE_H
+
+#include "DllMacro.h"
+
+#include "utils/CalamaresUtilsSystem.h"
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+
+#include <chrono>
+
+namespace CalamaresUtils
+{
+/** @brief Cached results of probing the host system
+ *
+ * Many modules ask the same questions of the host system: what
+ * is on this partition (blkid), which kernel is running (uname),
+ * what CPU is this (/proc/cpuinfo). The answers do not change
+ * unless the disks change, so they are remembered here.
+ *
+ * Code that changes the disks calls invalidate(); for instance
+ * CalamaresUtils::Partition::sync() does.
+ */
+namespace Probe
+{
+/** @brief Runs @p command in the host, or returns the result of the last run
+ *
+ * Results are remembered by the complete command line. Failures to run
+ * the command (e.g. a timeout) are not remembered, but the results of
+ * commands that ran and failed (non-zero exit code) are.
+ */
+DLLEXPORT ProcessResult run( const QStringList& command,
+                             std::chrono::seconds timeout = std::chrono::seconds( 10 ) );
+
+/** @brief Reads the file at @p path, or returns what was read last time
+ *
+ * The contents are read again if the size or modification time of
+ * the file has changed. Returns an empty array if the file can't
+ * be read (which is not remembered).
+ */
+DLLEXPORT QByteArray readFile( const QString& path );
+
+/// @brief Forgets all remembered results
+DLLEXPORT void invalidate();
+/** @brief Forgets results of commands with an argument starting with @p argument
+ *
+ * Use a device path, e.g. /dev/sda, to forget about the device
+ * and all its partitions.
+ */
+DLLEXPORT void invalidate( const QString& argument );
+
+}  // namespace Probe
+}  // namespace CalamaresUtils
+
+#endif
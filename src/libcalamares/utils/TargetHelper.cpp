@@ -0,0 +1,329 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2026 agent <agent@local>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#include "TargetHelper.h"
+
+#include "CalamaresConfig.h"
+#include "TargetHelperProtocol.h"
+#include "utils/Logger.h"
+
+#include <QElapsedTimer>
+#include <QFile>
+#include <QMutex>
+#include <QMutexLocker>
+
+#include <vector>
+
+#include <cerrno>
+#include <cstring>
+#include <poll.h>
+#include <spawn.h>
+#include <sys/socket.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace Protocol = CalamaresUtils::TargetHelperProtocol;
+
+/// @brief How long to wait for the helper to start a command
+static constexpr int START_TIMEOUT = 10000;
+/// @brief Idle helpers kept for later commands; more are stopped
+static constexpr std::size_t MAX_IDLE_HELPERS = 4;
+
+namespace CalamaresUtils
+{
+
+static QMutex s_mutex;
+static QString s_path;
+// Only the pointers are kept here, so that no helpers are stopped
+// (while logging) during static destruction.
+static std::vector< TargetHelper* > s_idle;
+
+QString
+TargetHelper::defaultPath()
+{
+    return QStringLiteral( CMAKE_INSTALL_FULL_LIBEXECDIR "/calamares-target-helper" );
+}
+
+void
+TargetHelper::setPath( const QString& path )
+{
+    QMutexLocker l( &s_mutex );
+    s_path = path;
+    for ( auto* h : s_idle )
+    {
+        delete h;
+    }
+    s_idle.clear();
+}
+
+QString
+TargetHelper::path()
+{
+    QMutexLocker l( &s_mutex );
+    return s_path;
+}
+
+std::unique_ptr< TargetHelper >
+TargetHelper::acquire()
+{
+    QString helperPath;
+    {
+        QMutexLocker l( &s_mutex );
+        if ( !s_idle.empty() )
+        {
+            std::unique_ptr< TargetHelper > h( s_idle.back() );
+            s_idle.pop_back();
+            return h;
+        }
+        helperPath = s_path;
+    }
+    if ( helperPath.isEmpty() )
+    {
+        return nullptr;
+    }
+
+    int fds[ 2 ];
+    if ( ::socketpair( AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, fds ) != 0 )
+    {
+        cWarning() << "Could not connect to target helper" << helperPath << ::strerror( errno );
+        return nullptr;
+    }
+
+    // The helper's end becomes its stdin and stdout; dup2() clears close-on-exec
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init( &actions );
+    posix_spawn_file_actions_adddup2( &actions, fds[ 1 ], STDIN_FILENO );
+    posix_spawn_file_actions_adddup2( &actions, fds[ 1 ], STDOUT_FILENO );
+
+    const QByteArray program = QFile::encodeName( helperPath );
+    char* const argv[] = { const_cast< char* >( program.constData() ), nullptr };
+    pid_t pid = 0;
+    const int r = posix_spawn( &pid, program.constData(), &actions, nullptr, argv, environ );
+    posix_spawn_file_actions_destroy( &actions );
+    ::close( fds[ 1 ] );
+    if ( r != 0 )
+    {
+        cWarning() << "Could not start target helper" << helperPath << ::strerror( r );
+        ::close( fds[ 0 ] );
+        return nullptr;
+    }
+    cDebug() << "Started target helper" << helperPath << "pid" << pid;
+    return std::unique_ptr< TargetHelper >( new TargetHelper( pid, fds[ 0 ] ) );
+}
+
+void
+TargetHelper::release( std::unique_ptr< TargetHelper > helper )
+{
+    if ( !helper || helper->m_broken || !helper->m_finished )
+    {
+        // A broken helper, or one that is still running a command, is stopped
+        return;
+    }
+    QMutexLocker l( &s_mutex );
+    if ( s_idle.size() < MAX_IDLE_HELPERS )
+    {
+        s_idle.push_back( helper.release() );
+    }
+}
+
+TargetHelper::TargetHelper( qint64 pid, int fd )
+    : m_pid( pid )
+    , m_fd( fd )
+{
+}
+
+TargetHelper::~TargetHelper()
+{
+    // The helper exits (killing the command, if any) when the connection closes
+    ::close( m_fd );
+    int status = 0;
+    while ( ::waitpid( pid_t( m_pid ), &status, 0 ) < 0 && errno == EINTR )
+    {
+    }
+}
+
+bool
+TargetHelper::send( const std::string& frame )
+{
+    std::size_t written = 0;
+    while ( !m_broken && written < frame.size() )
+    {
+        const ssize_t r = ::send( m_fd, frame.data() + written, frame.size() - written, MSG_NOSIGNAL );
+        if ( r < 0 && errno == EINTR )
+        {
+            continue;
+        }
+        if ( r <= 0 )
+        {
+            m_broken = true;
+        }
+        else
+        {
+            written += std::size_t( r );
+        }
+    }
+    return !m_broken;
+}
+
+bool
+TargetHelper::receive( QByteArray* output, int msecs )
+{
+    if ( m_broken )
+    {
+        return false;
+    }
+
+    pollfd fd { m_fd, POLLIN, 0 };
+    const int p = ::poll( &fd, 1, msecs );
+    if ( p < 0 && errno != EINTR )
+    {
+        m_broken = true;
+        return false;
+    }
+    if ( p > 0 )
+    {
+        char data[ 16384 ];
+        const ssize_t r = ::recv( m_fd, data, sizeof( data ), 0 );
+        if ( r < 0 && errno == EINTR )
+        {
+            return true;
+        }
+        if ( r <= 0 )
+        {
+            m_broken = true;
+            return false;
+        }
+        m_buffer.append( data, std::size_t( r ) );
+    }
+
+    Protocol::Frame type;
+    std::string payload;
+    while ( Protocol::takeFrame( m_buffer, type, payload ) )
+    {
+        int32_t value = 0;
+        switch ( type )
+        {
+        case Protocol::Frame::Started:
+            Protocol::Reader( payload ).readInt( value );
+            m_commandPid = value;
+            break;
+        case Protocol::Frame::Output:
+            output->append( payload.data(), int( payload.size() ) );
+            break;
+        case Protocol::Frame::Exited:
+        {
+            Protocol::Reader reader( payload );
+            Protocol::Usage usage;
+            reader.readInt( value );
+            m_status = value;
+            if ( reader.readUsage( usage ) )
+            {
+                m_usage.userTime = usage.userTime;
+                m_usage.systemTime = usage.systemTime;
+                m_usage.maxRss = usage.maxRss;
+                m_usage.blocksRead = usage.blocksRead;
+                m_usage.blocksWritten = usage.blocksWritten;
+                m_usage.exact = true;
+            }
+            m_finished = true;
+            break;
+        }
+        default:
+            cWarning() << "Unexpected message from target helper" << m_pid;
+            m_broken = true;
+            return false;
+        }
+    }
+    return true;
+}
+
+qint64
+TargetHelper::start( const QString& root,
+                     const QString& workingDirectory,
+                     const QStringList& arguments,
+                     const QStringList& environment )
+{
+    auto toStd = []( const QStringList& l ) {
+        std::vector< std::string > v;
+        v.reserve( std::size_t( l.count() ) );
+        for ( const auto& s : l )
+        {
+            v.push_back( s.toStdString() );
+        }
+        return v;
+    };
+
+    std::string payload;
+    Protocol::appendString( payload, QFile::encodeName( root ).toStdString() );
+    Protocol::appendString( payload, QFile::encodeName( workingDirectory ).toStdString() );
+    Protocol::appendList( payload, toStd( arguments ) );
+    Protocol::appendList( payload, toStd( environment ) );
+
+    m_commandPid = 0;
+    m_finished = false;
+    m_status = 0;
+    m_usage = ResourceUsage();
+    m_output.clear();
+    if ( !send( Protocol::frame( Protocol::Frame::Run, payload ) ) )
+    {
+        return -EPIPE;
+    }
+
+    QElapsedTimer timer;
+    timer.start();
+    while ( !m_commandPid )
+    {
+        const qint64 remaining = START_TIMEOUT - timer.elapsed();
+        if ( remaining <= 0 || !receive( &m_output, int( remaining ) ) )
+        {
+            m_broken = true;
+            return -ETIMEDOUT;
+        }
+    }
+    if ( m_commandPid < 0 )
+    {
+        // Nothing is running, so the helper can be used again
+        m_finished = true;
+    }
+    return m_commandPid;
+}
+
+bool
+TargetHelper::write( const QByteArray& data )
+{
+    return send( Protocol::frame( Protocol::Frame::Input, data.toStdString() ) );
+}
+
+bool
+TargetHelper::closeInput()
+{
+    return send( Protocol::frame( Protocol::Frame::CloseInput ) );
+}
+
+bool
+TargetHelper::kill()
+{
+    return send( Protocol::frame( Protocol::Frame::Kill ) );
+}
+
+bool
+TargetHelper::waitForOutput( QByteArray& output, int msecs )
+{
+    if ( !m_output.isEmpty() )
+    {
+        // Arrived together with the Started frame
+        output.append( m_output );
+        m_output.clear();
+        return true;
+    }
+    return receive( &output, msecs );
+}
+
+}  // namespace CalamaresUtils
@@ -0,0 +1,118 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2026 agent <agent@local>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#ifndef UTILS_TARGETHELPER_H
+#define UTILS_TARGETHELPER_H
+
+#include "DllMacro.h"
+
+#include "utils/CalamaresUtilsSystem.h"
+
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+
+#include <memory>
+#include <string>
+
+namespace CalamaresUtils
+{
+
+/** @brief Connection to a calamares-target-helper process
+ *
+ * Commands in the target system are normally run as `chroot <root> ...`,
+ * forked from Calamares itself. With a helper configured (see setPath()),
+ * System::runCommand() and Runner send those commands to a small helper
+ * process instead, which forks and changes root for each command. This
+ * is cheaper than forking the (big, multi-threaded) Calamares process
+ * and executing chroot(1) for each command. Commands in the host
+ * system are sent to the helper as well: the helper reaps each command
+ * itself, so the resources it used are known exactly, which is not
+ * the case for commands run with QProcess (see ResourceUsage).
+ *
+ * A helper runs one command at a time. Runners acquire() an idle
+ * helper, or start a new one, and release() it when the command is done.
+ * Helpers exit when Calamares exits.
+ */
+class DLLEXPORT TargetHelper
+{
+public:
+    ~TargetHelper();
+
+    /// @brief The helper executable that is installed with Calamares
+    static QString defaultPath();
+    /** @brief Use the helper executable at @p path
+     *
+     * An empty path (the default) means that no helper is used.
+     * This is set from the *target-helper* key in settings.conf.
+     */
+    static void setPath( const QString& path );
+    static QString path();
+
+    /** @brief Gets a helper that is not running a command
+     *
+     * Starts a new helper process if there is no idle one.
+     * Returns nullptr if no helper is configured, or if
+     * it can not be started.
+     */
+    static std::unique_ptr< TargetHelper > acquire();
+    /// @brief Makes @p helper available for other commands
+    static void release( std::unique_ptr< TargetHelper > helper );
+
+    /** @brief Runs a command in @p root
+     *
+     * The command starts in @p workingDirectory, which is a path
+     * in @p root. Changing root into / is skipped, so commands in
+     * the host system do not need privileges. Returns the process
+     * ID of the command, or a negative errno value if it could
+     * not be started.
+     */
+    qint64 start( const QString& root,
+                  const QString& workingDirectory,
+                  const QStringList& arguments,
+                  const QStringList& environment );
+    /// @brief Writes to standard input of the running command
+    bool write( const QByteArray& data );
+    bool closeInput();
+    /// @brief Kills the running command, with all its children
+    bool kill();
+
+    /** @brief Waits up to @p msecs for output of the command
+     *
+     * Output is appended to @p output. Returns false if the
+     * connection to the helper is lost.
+     */
+    bool waitForOutput( QByteArray& output, int msecs );
+    bool isFinished() const { return m_finished; }
+    /// @brief The exit status of the command, as from waitpid()
+    int exitStatus() const { return m_status; }
+    /// @brief Resources used by the command, measured by the helper (no wall time)
+    const ResourceUsage& usage() const { return m_usage; }
+
+private:
+    TargetHelper( qint64 pid, int fd );
+
+    bool send( const std::string& frame );
+    /// @brief Reads and handles the frames that arrive in @p msecs
+    bool receive( QByteArray* output, int msecs );
+
+    qint64 m_pid;  ///< Of the helper
+    int m_fd;  ///< Socket connected to the helper
+    std::string m_buffer;  ///< Incomplete frames
+    QByteArray m_output;  ///< Received while waiting for Started
+    qint64 m_commandPid = 0;  ///< Set by the Started frame
+    bool m_broken = false;
+    bool m_finished = false;
+    int m_status = 0;
+    ResourceUsage m_usage;
+};
+
+}  // namespace CalamaresUtils
+
+#endif
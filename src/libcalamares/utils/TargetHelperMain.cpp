@@ -0,0 +1,416 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2026 agent <agent@local>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+/** @file calamares-target-helper
+ *
+ * Runs commands in the target system for Calamares, see TargetHelper.h
+ * and TargetHelperProtocol.h. Calamares talks to the helper over its
+ * standard input and output. Each command is forked from this (small)
+ * process, which changes root into the target system and executes the
+ * command, so that Calamares itself does not need to fork, and no
+ * chroot(1) needs to be executed for each command.
+ *
+ * The helper itself does not change root, so it does not keep the
+ * target system busy when it is unmounted. It exits when Calamares
+ * closes the connection.
+ */
+
+#include "TargetHelperProtocol.h"
+
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/resource.h>
+#include <sys/signalfd.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+using namespace CalamaresUtils::TargetHelperProtocol;
+using Clock = std::chrono::steady_clock;
+
+/// @brief Time between SIGTERM and SIGKILL when killing a command
+static constexpr std::chrono::seconds KILL_GRACE { 2 };
+/// @brief Poll interval while waiting for a killed command, or without s_childExited
+static constexpr int EXIT_POLL_INTERVAL = 20;
+
+static const int CONTROL = STDIN_FILENO;
+static const int REPLY = STDOUT_FILENO;
+/// @brief Readable when a command exits (SIGCHLD, through signalfd); -1 if there is none
+static int s_childExited = -1;
+
+static bool
+writeAll( int fd, const std::string& data )
+{
+    std::size_t written = 0;
+    while ( written < data.size() )
+    {
+        const ssize_t r = ::write( fd, data.data() + written, data.size() - written );
+        if ( r < 0 && errno == EINTR )
+        {
+            continue;
+        }
+        if ( r <= 0 )
+        {
+            return false;
+        }
+        written += std::size_t( r );
+    }
+    return true;
+}
+
+static bool
+reply( Frame type, const std::string& payload = std::string() )
+{
+    return writeAll( REPLY, frame( type, payload ) );
+}
+
+/// @brief Reads what is available from @p fd into @p buffer; false on EOF or error
+static bool
+readSome( int fd, std::string& buffer )
+{
+    char data[ 16384 ];
+    ssize_t r;
+    do
+    {
+        r = ::read( fd, data, sizeof( data ) );
+    } while ( r < 0 && errno == EINTR );
+    if ( r <= 0 )
+    {
+        return false;
+    }
+    buffer.append( data, std::size_t( r ) );
+    return true;
+}
+
+static std::vector< char* >
+toArgv( std::vector< std::string >& l )
+{
+    std::vector< char* > argv;
+    for ( auto& s : l )
+    {
+        argv.push_back( &s[ 0 ] );
+    }
+    argv.push_back( nullptr );
+    return argv;
+}
+
+/// @brief In the forked child: reports why the command can't be run
+[[noreturn]] static void
+failCommand( const char* what, const std::string& path, int exitCode )
+{
+    std::fprintf( stderr, "calamares-target-helper: %s '%s': %s\n", what, path.c_str(), std::strerror( errno ) );
+    ::_exit( exitCode );
+}
+
+/// @brief In the forked child: set up and execute the command; does not return
+[[noreturn]] static void
+execCommand( const std::string& root,
+             const std::string& workingDirectory,
+             std::vector< std::string >& arguments,
+             std::vector< std::string >& environment,
+             int inputFd,
+             int outputFd )
+{
+    // Own process group, so the command can be killed with its children
+    ::setpgid( 0, 0 );
+    ::signal( SIGPIPE, SIG_DFL );
+    // The helper blocks SIGCHLD for s_childExited
+    sigset_t none;
+    sigemptyset( &none );
+    ::sigprocmask( SIG_SETMASK, &none, nullptr );
+
+    // This replaces the connection to Calamares; the pipes are close-on-exec
+    ::dup2( inputFd, STDIN_FILENO );
+    ::dup2( outputFd, STDOUT_FILENO );
+    ::dup2( outputFd, STDERR_FILENO );
+
+    // Changing root into / is pointless, and needs privileges
+    if ( root != "/" && ::chroot( root.c_str() ) != 0 )
+    {
+        failCommand( "cannot change root directory to", root, 125 );
+    }
+    const std::string directory = workingDirectory.empty() ? std::string( "/" ) : workingDirectory;
+    if ( ::chdir( directory.c_str() ) != 0 )
+    {
+        failCommand( "cannot change directory to", directory, 125 );
+    }
+
+    auto env = toArgv( environment );
+    environ = env.data();
+    auto argv = toArgv( arguments );
+    ::execvp( argv[ 0 ], argv.data() );
+    // Same exit codes as chroot(1)
+    failCommand( "failed to run command", arguments.front(), errno == ENOENT ? 127 : 126 );
+}
+
+/** @brief Runs one command, as described by the Run frame @p payload
+ *
+ * Returns false if the connection to Calamares is gone.
+ */
+static bool
+runCommand( const std::string& payload, std::string& control )
+{
+    std::string root, workingDirectory;
+    std::vector< std::string > arguments, environment;
+    Reader reader( payload );
+    if ( !reader.readString( root ) || !reader.readString( workingDirectory ) || !reader.readList( arguments )
+         || !reader.readList( environment ) || arguments.empty() )
+    {
+        std::string r;
+        appendInt( r, -EINVAL );
+        return reply( Frame::Started, r );
+    }
+
+    int input[ 2 ];
+    int output[ 2 ];
+    if ( ::pipe2( input, O_CLOEXEC ) != 0 )
+    {
+        std::string r;
+        appendInt( r, -errno );
+        return reply( Frame::Started, r );
+    }
+    if ( ::pipe2( output, O_CLOEXEC ) != 0 )
+    {
+        std::string r;
+        appendInt( r, -errno );
+        ::close( input[ 0 ] );
+        ::close( input[ 1 ] );
+        return reply( Frame::Started, r );
+    }
+
+    const pid_t pid = ::fork();
+    if ( pid == 0 )
+    {
+        execCommand( root, workingDirectory, arguments, environment, input[ 0 ], output[ 1 ] );
+    }
+    const int forkError = errno;
+    ::close( input[ 0 ] );
+    ::close( output[ 1 ] );
+    int inputFd = input[ 1 ];
+    int outputFd = output[ 0 ];
+    {
+        std::string r;
+        appendInt( r, pid > 0 ? int32_t( pid ) : -forkError );
+        if ( pid < 0 )
+        {
+            ::close( inputFd );
+            ::close( outputFd );
+            return reply( Frame::Started, r );
+        }
+        if ( !reply( Frame::Started, r ) )
+        {
+            ::kill( -pid, SIGKILL );
+            ::waitpid( pid, nullptr, 0 );
+            return false;
+        }
+    }
+    // Writing to the command must not block the helper
+    ::fcntl( inputFd, F_SETFL, ::fcntl( inputFd, F_GETFL ) | O_NONBLOCK );
+
+    std::string pendingInput;
+    bool closeInput = false;
+    bool connected = true;
+    bool killed = false;
+    Clock::time_point killDeadline;
+    int status = 0;
+    struct rusage rusage;
+    std::memset( &rusage, 0, sizeof( rusage ) );
+
+    for ( ;; )
+    {
+        // Is the command done?
+        pid_t w;
+        do
+        {
+            w = ::wait4( pid, &status, WNOHANG, &rusage );
+        } while ( w < 0 && errno == EINTR );
+        if ( w == pid )
+        {
+            break;
+        }
+        if ( w < 0 )
+        {
+            // Can't happen, but would otherwise loop forever
+            status = 0x7f00;  // Exit code 127
+            break;
+        }
+        if ( killed && Clock::now() >= killDeadline )
+        {
+            ::kill( -pid, SIGKILL );
+        }
+
+        pollfd fds[ 4 ];
+        nfds_t count = 0;
+        fds[ count++ ] = pollfd { connected ? CONTROL : -1, POLLIN, 0 };
+        fds[ count++ ] = pollfd { outputFd, POLLIN, 0 };
+        fds[ count++ ] = pollfd { inputFd >= 0 && !pendingInput.empty() ? inputFd : -1, POLLOUT, 0 };
+        fds[ count++ ] = pollfd { s_childExited, POLLIN, 0 };
+        // The exit wakes up poll() through s_childExited; without it, poll for the exit
+        const int timeout = ( killed || ( s_childExited < 0 && outputFd < 0 ) ) ? EXIT_POLL_INTERVAL : 250;
+        if ( ::poll( fds, count, timeout ) < 0 && errno != EINTR )
+        {
+            break;
+        }
+
+        if ( fds[ 3 ].revents )
+        {
+            // Only wakes up the loop; wait4() above checks which child it was
+            signalfd_siginfo info;
+            while ( ::read( s_childExited, &info, sizeof( info ) ) > 0 )
+            {
+            }
+        }
+
+        if ( fds[ 1 ].revents )
+        {
+            std::string data;
+            if ( readSome( outputFd, data ) )
+            {
+                connected = connected && reply( Frame::Output, data );
+            }
+            else
+            {
+                ::close( outputFd );
+                outputFd = -1;
+            }
+        }
+        if ( fds[ 2 ].revents )
+        {
+            const ssize_t r = ::write( inputFd, pendingInput.data(), pendingInput.size() );
+            if ( r > 0 )
+            {
+                pendingInput.erase( 0, std::size_t( r ) );
+            }
+            else if ( r < 0 && errno != EAGAIN && errno != EINTR )
+            {
+                // The command does not read its input any more
+                pendingInput.clear();
+                closeInput = true;
+            }
+        }
+        if ( fds[ 0 ].revents && !readSome( CONTROL, control ) )
+        {
+            connected = false;
+        }
+        {
+            // There may be frames left over from reading the Run frame, too
+            Frame type;
+            std::string data;
+            while ( takeFrame( control, type, data ) )
+            {
+                switch ( type )
+                {
+                case Frame::Input:
+                    pendingInput.append( data );
+                    break;
+                case Frame::CloseInput:
+                    closeInput = true;
+                    break;
+                case Frame::Kill:
+                    if ( !killed )
+                    {
+                        ::kill( -pid, SIGTERM );
+                        killed = true;
+                        killDeadline = Clock::now() + KILL_GRACE;
+                    }
+                    break;
+                default:
+                    // Run while running, or not a request
+                    break;
+                }
+            }
+        }
+        if ( closeInput && pendingInput.empty() && inputFd >= 0 )
+        {
+            ::close( inputFd );
+            inputFd = -1;
+        }
+        if ( !connected && !killed )
+        {
+            // Calamares is gone, so nobody wants the result
+            ::kill( -pid, SIGKILL );
+            killed = true;
+            killDeadline = Clock::now();
+        }
+    }
+
+    // Pick up the output that is still there, without waiting for
+    // processes started by the command that keep the output open.
+    if ( outputFd >= 0 )
+    {
+        ::fcntl( outputFd, F_SETFL, ::fcntl( outputFd, F_GETFL ) | O_NONBLOCK );
+        std::string data;
+        while ( readSome( outputFd, data ) )
+        {
+        }
+        if ( !data.empty() && connected )
+        {
+            connected = reply( Frame::Output, data );
+        }
+        ::close( outputFd );
+    }
+    if ( inputFd >= 0 )
+    {
+        ::close( inputFd );
+    }
+
+    auto ms = []( const timeval& t ) { return int64_t( t.tv_sec ) * 1000 + t.tv_usec / 1000; };
+    Usage usage;
+    usage.userTime = ms( rusage.ru_utime );
+    usage.systemTime = ms( rusage.ru_stime );
+    usage.maxRss = rusage.ru_maxrss;
+    usage.blocksRead = rusage.ru_inblock;
+    usage.blocksWritten = rusage.ru_oublock;
+
+    std::string r;
+    appendInt( r, status );
+    appendUsage( r, usage );
+    return connected && reply( Frame::Exited, r );
+}
+
+int
+main()
+{
+    // Write errors are handled, instead of dying on SIGPIPE
+    ::signal( SIGPIPE, SIG_IGN );
+
+    // Notice right away when a command exits, instead of polling for it
+    sigset_t childSignals;
+    sigemptyset( &childSignals );
+    sigaddset( &childSignals, SIGCHLD );
+    if ( ::sigprocmask( SIG_BLOCK, &childSignals, nullptr ) == 0 )
+    {
+        s_childExited = ::signalfd( -1, &childSignals, SFD_NONBLOCK | SFD_CLOEXEC );
+    }
+
+    std::string control;
+    for ( ;; )
+    {
+        Frame type;
+        std::string payload;
+        while ( !takeFrame( control, type, payload ) )
+        {
+            if ( !readSome( CONTROL, control ) )
+            {
+                return 0;
+            }
+        }
+        if ( type == Frame::Run && !runCommand( payload, control ) )
+        {
+            return 0;
+        }
+        // Other frames belong to a command that has finished already
+    }
+}
@@ -0,0 +1,213 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2026 agent <agent@local>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+/** @file Messages between Calamares and calamares-target-helper
+ *
+ * This is shared between TargetHelper (in Calamares) and the helper
+ * executable, which does not use Qt; it uses only standard C++.
+ *
+ * All messages are frames: a type byte, a 32-bit length and then
+ * length bytes of payload. Numbers are in host byte order, since both
+ * sides run on the same machine. Calamares sends Run, and while the
+ * command runs, Input, CloseInput and Kill. The helper answers Run with
+ * Started, then sends Output while the command produces output, and
+ * Exited when it is done. The helper runs one command at a time.
+ */
+
+#ifndef UTILS_TARGETHELPERPROTOCOL_H
+#define UTILS_TARGETHELPERPROTOCOL_H
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace CalamaresUtils
+{
+namespace TargetHelperProtocol
+{
+
+enum class Frame : char
+{
+    // Calamares to helper
+    Run = 'R',  ///< root, working directory, argv list, environment list
+    Input = 'I',  ///< Data for standard input of the command
+    CloseInput = 'C',  ///< No payload
+    Kill = 'K',  ///< No payload; kills the command's process group
+    // Helper to Calamares
+    Started = 'P',  ///< The process ID of the command, or -errno if it could not be started
+    Output = 'O',  ///< Output (stdout and stderr) of the command
+    Exited = 'X'  ///< Exit status of the command, as from waitpid(), and its Usage
+};
+
+static constexpr std::size_t HEADER_SIZE = 1 + sizeof( uint32_t );
+
+inline void
+appendInt( std::string& out, int32_t i )
+{
+    out.append( reinterpret_cast< const char* >( &i ), sizeof( i ) );
+}
+
+inline void
+appendInt64( std::string& out, int64_t i )
+{
+    out.append( reinterpret_cast< const char* >( &i ), sizeof( i ) );
+}
+
+inline void
+appendString( std::string& out, const std::string& s )
+{
+    appendInt( out, static_cast< int32_t >( s.size() ) );
+    out.append( s );
+}
+
+inline void
+appendList( std::string& out, const std::vector< std::string >& l )
+{
+    appendInt( out, static_cast< int32_t >( l.size() ) );
+    for ( const auto& s : l )
+    {
+        appendString( out, s );
+    }
+}
+
+/// @brief Resources used by the command, sent after the exit status
+struct Usage
+{
+    int64_t userTime = 0;  ///< ms
+    int64_t systemTime = 0;  ///< ms
+    int64_t maxRss = 0;  ///< KiB
+    int64_t blocksRead = 0;
+    int64_t blocksWritten = 0;
+};
+
+inline void
+appendUsage( std::string& out, const Usage& u )
+{
+    appendInt64( out, u.userTime );
+    appendInt64( out, u.systemTime );
+    appendInt64( out, u.maxRss );
+    appendInt64( out, u.blocksRead );
+    appendInt64( out, u.blocksWritten );
+}
+
+/// @brief Makes a frame of the given @p type containing @p payload
+inline std::string
+frame( Frame type, const std::string& payload = std::string() )
+{
+    std::string out;
+    out.reserve( HEADER_SIZE + payload.size() );
+    out.push_back( static_cast< char >( type ) );
+    const uint32_t length = static_cast< uint32_t >( payload.size() );
+    out.append( reinterpret_cast< const char* >( &length ), sizeof( length ) );
+    out.append( payload );
+    return out;
+}
+
+/** @brief Takes the first complete frame from @p buffer
+ *
+ * Returns false if the buffer does not contain a complete frame yet.
+ */
+inline bool
+takeFrame( std::string& buffer, Frame& type, std::string& payload )
+{
+    if ( buffer.size() < HEADER_SIZE )
+    {
+        return false;
+    }
+    uint32_t length = 0;
+    std::memcpy( &length, buffer.data() + 1, sizeof( length ) );
+    if ( buffer.size() < HEADER_SIZE + length )
+    {
+        return false;
+    }
+    type = static_cast< Frame >( buffer[ 0 ] );
+    payload = buffer.substr( HEADER_SIZE, length );
+    buffer.erase( 0, HEADER_SIZE + length );
+    return true;
+}
+
+/// @brief Reads the values from a payload made with the append*() functions
+class Reader
+{
+public:
+    explicit Reader( const std::string& payload )
+        : m_payload( payload )
+    {
+    }
+
+    bool readInt( int32_t& i )
+    {
+        if ( m_payload.size() - m_position < sizeof( i ) )
+        {
+            return false;
+        }
+        std::memcpy( &i, m_payload.data() + m_position, sizeof( i ) );
+        m_position += sizeof( i );
+        return true;
+    }
+
+    bool readInt64( int64_t& i )
+    {
+        if ( m_payload.size() - m_position < sizeof( i ) )
+        {
+            return false;
+        }
+        std::memcpy( &i, m_payload.data() + m_position, sizeof( i ) );
+        m_position += sizeof( i );
+        return true;
+    }
+
+    bool readUsage( Usage& u )
+    {
+        return readInt64( u.userTime ) && readInt64( u.systemTime ) && readInt64( u.maxRss )
+            && readInt64( u.blocksRead ) && readInt64( u.blocksWritten );
+    }
+
+    bool readString( std::string& s )
+    {
+        int32_t length = 0;
+        if ( !readInt( length ) || length < 0 || m_payload.size() - m_position < std::size_t( length ) )
+        {
+            return false;
+        }
+        s = m_payload.substr( m_position, std::size_t( length ) );
+        m_position += std::size_t( length );
+        return true;
+    }
+
+    bool readList( std::vector< std::string >& l )
+    {
+        int32_t count = 0;
+        if ( !readInt( count ) || count < 0 )
+        {
+            return false;
+        }
+        l.clear();
+        for ( int32_t i = 0; i < count; ++i )
+        {
+            std::string s;
+            if ( !readString( s ) )
+            {
+                return false;
+            }
+            l.push_back( s );
+        }
+        return true;
+    }
+
+private:
+    const std::string& m_payload;
+    std::size_t m_position = 0;
+};
+
+}  // namespace TargetHelperProtocol
+}  // namespace CalamaresUtils
+
+#endif
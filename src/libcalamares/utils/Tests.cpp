@@ -10,17 +10,29 @@
  */
 
 #include "CalamaresUtilsSystem.h"
+#include "CommandList.h"
 #include "Entropy.h"
 #include "Logger.h"
+#include "Probe.h"
 #include "RAII.h"
+#include "Trace.h"
 #include "Traits.h"
 #include "UMask.h"
 #include "Variant.h"
 #include "Yaml.h"
+#include "YamlCache.h"
 
 #include "GlobalStorage.h"
 #include "JobQueue.h"
-
+#include "TargetHelper.h"
+
+#include <QElapsedTimer>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QRegExp>
+#include <QStandardPaths>
+#include <QTemporaryDir>
 #include <QTemporaryFile>
 
 #include <QtTest/QtTest>
@@ -42,8 +54,17 @@ private Q_SLOTS:
 
     void testLoadSaveYaml();  // Just settings.conf
     void testLoadSaveYamlExtended();  // Do a find() in the src dir
+    void testYamlScalars();
+    void testYamlCache();
+    void benchYamlConversion_data();
+    void benchYamlConversion();
 
     void testCommands();
+    void testSimpleCommand();
+    void testRunner();
+    void testResourceUsage();
+    void testTargetHelper();
+    void testProbe();
 
     /** @brief Test that all the UMask objects work correctly. */
     void testUmask();
@@ -63,6 +84,10 @@ private Q_SLOTS:
     void testVariantStringListYAMLDashed();
     void testVariantStringListYAMLBracketed();
 
+    /** @brief Tests the trace-event recording. */
+    void testTrace();
+    void testStartupPhases();
+
 
 private:
     void recursiveCompareMap( const QVariantMap& a, const QVariantMap& b, int depth );
@@ -75,6 +100,9 @@ LibCalamaresTests::~LibCalamaresTests() {}
 void
 LibCalamaresTests::initTestCase()
 {
+    // Keep files written by the code under test (e.g. the trace)
+    // out of the user's cache directory.
+    QStandardPaths::setTestModeEnabled( true );
 }
 
 void
@@ -95,6 +123,18 @@ LibCalamaresTests::testDebugLevels()
             QCOMPARE( Logger::logLevelEnabled( xlevel ), xlevel <= level );
         }
     }
+
+    // Arguments are only evaluated if the line is logged
+    int evaluated = 0;
+    auto count = [ &evaluated ]() { return ++evaluated; };
+    Logger::setupLogLevel( Logger::LOGWARNING );
+    cDebug() << "Not logged" << count();
+    QCOMPARE( evaluated, 0 );
+    cWarning() << "Logged" << count();
+    QCOMPARE( evaluated, 1 );
+    Logger::setupLogLevel( Logger::LOGVERBOSE );
+    cDebug() << "Logged" << count();
+    QCOMPARE( evaluated, 2 );
 }
 
 void
@@ -190,6 +230,213 @@ LibCalamaresTests::testLoadSaveYamlExtended()
     QFile::remove( "out.yaml" );
 }
 
+/// @brief The QRegExp-based conversion that yamlScalarToVariant() used to do
+static QVariant
+regexpScalarToVariant( const YAML::Node& scalarNode )
+{
+    static const QRegExp trueValues( "true|True|TRUE|on|On|ON" );
+    static const QRegExp falseValues( "false|False|FALSE|off|Off|OFF" );
+
+    QString scalarString = QString::fromStdString( scalarNode.as< std::string >() );
+    if ( trueValues.exactMatch( scalarString ) )
+    {
+        return QVariant( true );
+    }
+    if ( falseValues.exactMatch( scalarString ) )
+    {
+        return QVariant( false );
+    }
+    if ( QRegExp( "[-+]?\\d+" ).exactMatch( scalarString ) )
+    {
+        return QVariant( scalarString.toLongLong() );
+    }
+    if ( QRegExp( "[-+]?\\d*\\.?\\d+" ).exactMatch( scalarString ) )
+    {
+        return QVariant( scalarString.toDouble() );
+    }
+    return QVariant( scalarString );
+}
+
+/// @brief Like yamlToVariant(), with regexpScalarToVariant()
+static QVariant
+regexpYamlToVariant( const YAML::Node& node )
+{
+    switch ( node.Type() )
+    {
+    case YAML::NodeType::Scalar:
+        return regexpScalarToVariant( node );
+    case YAML::NodeType::Sequence:
+    {
+        QVariantList l;
+        for ( YAML::const_iterator it = node.begin(); it != node.end(); ++it )
+        {
+            l << regexpYamlToVariant( *it );
+        }
+        return l;
+    }
+    case YAML::NodeType::Map:
+    {
+        QVariantMap m;
+        for ( YAML::const_iterator it = node.begin(); it != node.end(); ++it )
+        {
+            m.insert( QString::fromStdString( it->first.as< std::string >() ), regexpYamlToVariant( it->second ) );
+        }
+        return m;
+    }
+    default:
+        return QVariant();
+    }
+}
+
+void
+LibCalamaresTests::testYamlScalars()
+{
+    const QStringList scalars {
+        // Booleans, and almost-booleans
+        "true", "True", "TRUE", "tRUE", "on", "On", "ON", "oN", "off", "Off", "OFF", "of", "oFF",
+        "false", "False", "FALSE", "fAlse", "yes", "t",
+        // Integers, and almost-integers
+        "0", "-1", "+12", "0012", "12345678901234", "99999999999999999999", "+", "-", "--1", "12abc", " 12", "12 ",
+        "0x10", "\u0661\u0662",
+        // Floating-point, and almost-floats
+        "1.5", "-.5", ".5", "+0.25", "1.", "1.2.3", "", ".", "-.", "1e5",
+        // Plain strings
+        "abc", "/dev/sda1"
+    };
+    for ( const auto& s : scalars )
+    {
+        const YAML::Node node( s.toStdString() );
+        const QVariant expected = regexpScalarToVariant( node );
+        const QVariant actual = CalamaresUtils::yamlScalarToVariant( node );
+        QCOMPARE( actual.type(), expected.type() );
+        QCOMPARE( actual, expected );
+    }
+}
+
+/// @brief Writes @p contents to @p path, with modification time @p seconds
+static bool
+writeWithTime( const QString& path, const QByteArray& contents, time_t seconds )
+{
+    QFile f( path );
+    if ( !f.open( QIODevice::WriteOnly | QIODevice::Truncate ) || f.write( contents ) != contents.length() )
+    {
+        return false;
+    }
+    f.close();
+    const struct timespec times[ 2 ] = { { seconds, 0 }, { seconds, 0 } };
+    return ::utimensat( AT_FDCWD, QFile::encodeName( path ).constData(), times, 0 ) == 0;
+}
+
+void
+LibCalamaresTests::testYamlCache()
+{
+    namespace YamlCache = CalamaresUtils::YamlCache;
+
+    QTemporaryDir dir;
+    QVERIFY( dir.isValid() );
+    const QString yaml = dir.filePath( "module.conf" );
+    const QString cache = dir.filePath( "config.cache" );
+
+    QVERIFY( writeWithTime( yaml, "key: 1\nname: one\n", 1000000 ) );
+    YamlCache::setCacheFile( cache );
+    bool exists = false;
+    QVariantMap expected { { "key", 1 }, { "name", "one" } };
+    QCOMPARE( YamlCache::load( yaml, &exists ).toMap(), expected );
+    QVERIFY( exists );
+    YamlCache::save();
+    QVERIFY( QFile::exists( cache ) );
+
+    // Same size and time: the cached document is used, also from the cache file
+    QVERIFY( writeWithTime( yaml, "key: 2\nname: two\n", 1000000 ) );
+    YamlCache::setCacheFile( cache );
+    QCOMPARE( YamlCache::load( yaml, &exists ).toMap(), expected );
+    QCOMPARE( CalamaresUtils::loadYaml( yaml ), expected );
+
+    // A changed file is parsed again
+    QVERIFY( writeWithTime( yaml, "key: 2\nname: two\n", 1000001 ) );
+    expected = QVariantMap { { "key", 2 }, { "name", "two" } };
+    QCOMPARE( YamlCache::load( yaml, &exists ).toMap(), expected );
+
+    // Empty documents, and missing files
+    QVERIFY( writeWithTime( yaml, "", 1000002 ) );
+    QVERIFY( !YamlCache::load( yaml, &exists ).isValid() );
+    QVERIFY( exists );
+    QVERIFY( !YamlCache::load( dir.filePath( "missing.conf" ), &exists ).isValid() );
+    QVERIFY( !exists );
+
+    // A seed is used, but never written; the cache file is written instead
+    const QString seed = dir.filePath( "seed.cache" );
+    const QString userCache = dir.filePath( "user.cache" );
+    QVERIFY( writeWithTime( yaml, "key: 3\nname: tri\n", 1000003 ) );
+    YamlCache::setCacheFile( seed );
+    expected = QVariantMap { { "key", 3 }, { "name", "tri" } };
+    QCOMPARE( YamlCache::load( yaml, &exists ).toMap(), expected );
+    YamlCache::save();
+    auto contents = []( const QString& path ) {
+        QFile f( path );
+        return f.open( QIODevice::ReadOnly ) ? f.readAll() : QByteArray();
+    };
+    const QByteArray seedContents = contents( seed );
+    QVERIFY( !seedContents.isEmpty() );
+
+    QVERIFY( writeWithTime( yaml, "key: 4\nname: for\n", 1000003 ) );
+    YamlCache::setCacheFile( userCache, seed );
+    QCOMPARE( YamlCache::load( yaml, &exists ).toMap(), expected );
+    QVERIFY( writeWithTime( yaml, "key: 4\nname: for\n", 1000004 ) );
+    expected = QVariantMap { { "key", 4 }, { "name", "for" } };
+    QCOMPARE( YamlCache::load( yaml, &exists ).toMap(), expected );
+    YamlCache::save();
+    QVERIFY( QFile::exists( userCache ) );
+    QCOMPARE( contents( seed ), seedContents );
+
+    // The cache file takes precedence over the seed
+    YamlCache::setCacheFile( userCache, seed );
+    QCOMPARE( YamlCache::load( yaml, &exists ).toMap(), expected );
+
+    YamlCache::setCacheFile( QString() );
+}
+
+void
+LibCalamaresTests::benchYamlConversion_data()
+{
+    QTest::addColumn< bool >( "regexp" );
+
+    QTest::newRow( "classifier" ) << false;
+    QTest::newRow( "regexp" ) << true;
+}
+
+void
+LibCalamaresTests::benchYamlConversion()
+{
+    QFETCH( bool, regexp );
+
+    QFile f( "src/modules/netinstall/netinstall.yaml" );
+    // Find the source tree, from the build directory
+    for ( unsigned int up = 0; !f.exists() && ( up < 4 ); ++up )
+    {
+        f.setFileName( QString( "../" ) + f.fileName() );
+    }
+    QVERIFY( f.exists() );
+
+    const YAML::Node doc = YAML::LoadFile( f.fileName().toStdString() );
+    QVariant v;
+    if ( regexp )
+    {
+        QBENCHMARK
+        {
+            v = regexpYamlToVariant( doc );
+        }
+    }
+    else
+    {
+        QBENCHMARK
+        {
+            v = CalamaresUtils::yamlToVariant( doc );
+        }
+    }
+    QCOMPARE( v, regexpYamlToVariant( doc ) );
+}
+
 void
 LibCalamaresTests::testCommands()
 {
@@ -217,6 +464,199 @@ LibCalamaresTests::testCommands()
     QVERIFY( r.getOutput().contains( tfn.fileName() ) );
 }
 
+void
+LibCalamaresTests::testSimpleCommand()
+{
+    using CalamaresUtils::splitSimpleCommand;
+
+    QCOMPARE( splitSimpleCommand( "ls" ), QStringList { "ls" } );
+    QCOMPARE( splitSimpleCommand( " mkinitcpio  -p linux " ), QStringList( { "mkinitcpio", "-p", "linux" } ) );
+    QCOMPARE( splitSimpleCommand( "systemctl enable sddm.service" ),
+              QStringList( { "systemctl", "enable", "sddm.service" } ) );
+    QCOMPARE( splitSimpleCommand( "chown user:users /home/user" ),
+              QStringList( { "chown", "user:users", "/home/user" } ) );
+    QCOMPARE( splitSimpleCommand( "dd if=/dev/zero of=/swap" ), QStringList( { "dd", "if=/dev/zero", "of=/swap" } ) );
+
+    // Anything the shell would interpret
+    QVERIFY( splitSimpleCommand( QString() ).isEmpty() );
+    QVERIFY( splitSimpleCommand( "   " ).isEmpty() );
+    QVERIFY( splitSimpleCommand( "echo hi > /tmp/x" ).isEmpty() );
+    QVERIFY( splitSimpleCommand( "ls; ls" ).isEmpty() );
+    QVERIFY( splitSimpleCommand( "ls | cat" ).isEmpty() );
+    QVERIFY( splitSimpleCommand( "echo $HOME" ).isEmpty() );
+    QVERIFY( splitSimpleCommand( "echo 'a b'" ).isEmpty() );
+    QVERIFY( splitSimpleCommand( "rm /tmp/*" ).isEmpty() );
+    QVERIFY( splitSimpleCommand( "ls ~" ).isEmpty() );
+    QVERIFY( splitSimpleCommand( "ls\tfoo" ).isEmpty() );
+    QVERIFY( splitSimpleCommand( "LANG=C ls" ).isEmpty() );
+    QVERIFY( splitSimpleCommand( "cd /tmp" ).isEmpty() );
+    QVERIFY( splitSimpleCommand( "exit 1" ).isEmpty() );
+}
+
+void
+LibCalamaresTests::testRunner()
+{
+    using CalamaresUtils::Runner;
+
+    // Lines go to the callback as they come; the result keeps only the last ones
+    {
+        QStringList lines;
+        Runner runner( { "/bin/sh", "-c", "for i in 1 2 3 4 5; do echo line $i; done" } );
+        runner.setOutputLimit( 2 ).setLineCallback( [ &lines ]( const QString& l ) { lines.append( l ); } );
+        auto r = runner.run();
+        QCOMPARE( r.getExitCode(), 0 );
+        QCOMPARE( lines.count(), 5 );
+        QCOMPARE( lines.first(), QStringLiteral( "line 1" ) );
+        QCOMPARE( r.getOutput(), QStringLiteral( "line 4\nline 5" ) );
+    }
+
+    // Queued lines, with input streamed while the command runs
+    {
+        Runner runner( { "/bin/cat" } );
+        runner.setInput( "one\n", true ).setQueueSize( 1 );
+        QVERIFY( runner.start() );
+        QVERIFY( !runner.start() );
+        QString line;
+        QVERIFY( runner.nextLine( line ) );
+        QCOMPARE( line, QStringLiteral( "one" ) );
+        QVERIFY( runner.write( "two\nthree" ) );
+        runner.closeInput();
+        QVERIFY( runner.nextLine( line ) );
+        QCOMPARE( line, QStringLiteral( "two" ) );
+        QVERIFY( runner.nextLine( line ) );
+        QCOMPARE( line, QStringLiteral( "three" ) );  // Without a newline at the end
+        QVERIFY( !runner.nextLine( line ) );
+        QVERIFY( runner.isFinished() );
+        QCOMPARE( runner.wait().getExitCode(), 0 );
+        QVERIFY( !runner.write( "four" ) );
+    }
+
+    // Destroying a runner kills the command, even if the queue is full
+    {
+        QElapsedTimer timer;
+        timer.start();
+        {
+            Runner runner( { "/bin/sh", "-c", "while true; do echo y; done" } );
+            runner.setQueueSize( 4 ).setOutputLimit( 0 );
+            QVERIFY( runner.start() );
+            QString line;
+            QVERIFY( runner.nextLine( line ) );
+            QCOMPARE( line, QStringLiteral( "y" ) );
+        }
+        QVERIFY( timer.elapsed() < 10000 );
+    }
+}
+
+void
+LibCalamaresTests::testResourceUsage()
+{
+    using CalamaresUtils::System;
+
+    // Keeps a CPU busy for a while
+    const QStringList busy { "/bin/sh", "-c", "i=0; while [ $i -lt 100000 ]; do i=$((i+1)); done" };
+    auto r = System::runCommand( System::RunLocation::RunInHost, busy );
+    QCOMPARE( r.getExitCode(), 0 );
+    const auto& usage = r.usage();
+    QVERIFY( usage.isValid() );
+    QVERIFY( usage.isExact() );  // Nothing else is running
+    QVERIFY( usage.userTime + usage.systemTime > 0 );
+    QVERIFY( usage.wallTime >= usage.userTime + usage.systemTime - 50 );
+    QVERIFY( usage.blocksRead >= 0 );
+
+    // Same exit code as env(1) for a missing command
+    r = System::runCommand( System::RunLocation::RunInHost, { "/nonexistent/command" } );
+    QCOMPARE( r.getExitCode(), 127 );
+    QVERIFY( !r.usage().isValid() );
+    r = System::runCommand( System::RunLocation::RunInHost, { "nonexistent-calamares-command" } );
+    QCOMPARE( r.getExitCode(), 127 );
+}
+
+void
+LibCalamaresTests::testTargetHelper()
+{
+    using CalamaresUtils::System;
+    using CalamaresUtils::TargetHelper;
+
+    // Changing root into / is skipped, so this does not need root
+    Calamares::JobQueue jobQueue( nullptr );
+    jobQueue.globalStorage()->insert( "rootMountPoint", "/" );
+    TargetHelper::setPath( QStringLiteral( TARGET_HELPER ) );
+
+    auto r = System::runCommand( System::RunLocation::RunInTarget, { "/bin/sh", "-c", "pwd; echo hi; exit 3" } );
+    QCOMPARE( r.getExitCode(), 3 );
+    QCOMPARE( r.getOutput(), QStringLiteral( "/\nhi" ) );
+    QVERIFY( r.usage().isValid() );
+    QVERIFY( r.usage().isExact() );
+    QVERIFY( r.usage().maxRss > 0 );
+
+    // The helper is re-used; input is passed on
+    r = System::runCommand( System::RunLocation::RunInTarget, { "/bin/cat" }, QString(), QStringLiteral( "meow" ) );
+    QCOMPARE( r.getExitCode(), 0 );
+    QCOMPARE( r.getOutput(), QStringLiteral( "meow" ) );
+
+    // Commands that print and exit right away may be done before they are
+    // known to be started; their output is kept all the same.
+    for ( int i = 0; i < 200; ++i )
+    {
+        r = System::runCommand( System::RunLocation::RunInTarget, { "/bin/echo", "quick" } );
+        QCOMPARE( r.getExitCode(), 0 );
+        QCOMPARE( r.getOutput(), QStringLiteral( "quick" ) );
+    }
+
+    // Same exit code as chroot(1) for a missing command
+    r = System::runCommand( System::RunLocation::RunInTarget, { "/nonexistent/command" } );
+    QCOMPARE( r.getExitCode(), 127 );
+
+    r = System::runCommand(
+        System::RunLocation::RunInTarget, { "/bin/sleep", "30" }, QString(), QString(), std::chrono::seconds( 1 ) );
+    QCOMPARE( r.getExitCode(), static_cast< int >( CalamaresUtils::ProcessResult::Code::TimedOut ) );
+
+    // Commands in the host run in the helper too, in their working directory,
+    // and are measured exactly, also while another command runs.
+    {
+        QTemporaryDir dir;
+        CalamaresUtils::Runner sleeper( { "/bin/sleep", "1" } );
+        QVERIFY( sleeper.start() );
+        r = System::runCommand( System::RunLocation::RunInHost, { "/bin/pwd" }, dir.path() );
+        QCOMPARE( r.getExitCode(), 0 );
+        QCOMPARE( r.getOutput(), QDir( dir.path() ).canonicalPath() );
+        QVERIFY( r.usage().isExact() );
+        QCOMPARE( sleeper.wait().getExitCode(), 0 );
+    }
+
+    TargetHelper::setPath( QString() );
+}
+
+void
+LibCalamaresTests::testProbe()
+{
+    namespace Probe = CalamaresUtils::Probe;
+
+    // A different answer each time it really runs
+    const QStringList command { "/bin/date", "+%s%N" };
+    const auto first = Probe::run( command );
+    QCOMPARE( first.getExitCode(), 0 );
+    QCOMPARE( Probe::run( command ).getOutput(), first.getOutput() );
+    Probe::invalidate( "/dev/sda" );
+    QCOMPARE( Probe::run( command ).getOutput(), first.getOutput() );
+    Probe::invalidate( "+%s" );
+    const auto second = Probe::run( command );
+    QVERIFY( second.getOutput() != first.getOutput() );
+    Probe::invalidate();
+    QVERIFY( Probe::run( command ).getOutput() != second.getOutput() );
+
+    // Files are read again when they change
+    QTemporaryFile f;
+    QVERIFY( f.open() );
+    f.write( "one" );
+    f.flush();
+    QCOMPARE( Probe::readFile( f.fileName() ), QByteArray( "one" ) );
+    f.write( "two" );
+    f.flush();
+    QCOMPARE( Probe::readFile( f.fileName() ), QByteArray( "onetwo" ) );
+    QVERIFY( Probe::readFile( "/nonexistent/file" ).isEmpty() );
+}
+
 void
 LibCalamaresTests::testUmask()
 {
@@ -480,6 +920,75 @@ strings: [ aap, noot, mies ]
     QVERIFY( !getStringList( m, key ).contains( "lam" ) );
 }
 
+void
+LibCalamaresTests::testTrace()
+{
+    using namespace CalamaresUtils;
+
+    const qint64 start = Trace::now();
+    {
+        Trace::Span span( "test", QStringLiteral( "span" ) );
+        span.setArgument( QStringLiteral( "derp" ), 17 );
+        QThread::msleep( 2 );
+    }
+    QVERIFY( Trace::now() > start );
+    Trace::counter( "test", QStringLiteral( "counter" ), 0.5 );
+
+    QTemporaryFile f;
+    QVERIFY( f.open() );
+    QVERIFY( Trace::save( f.fileName() ) );
+
+    QJsonParseError error;
+    auto doc = QJsonDocument::fromJson( f.readAll(), &error );
+    QCOMPARE( error.error, QJsonParseError::NoError );
+    const auto events = doc.object().value( "traceEvents" ).toArray();
+    QVERIFY( events.count() >= 3 );  // span, counter, process name
+
+    bool foundSpan = false;
+    for ( const auto& v : events )
+    {
+        const auto e = v.toObject();
+        if ( e.value( "name" ).toString() == QStringLiteral( "span" ) )
+        {
+            foundSpan = true;
+            QCOMPARE( e.value( "ph" ).toString(), QStringLiteral( "X" ) );
+            QCOMPARE( e.value( "cat" ).toString(), QStringLiteral( "test" ) );
+            QVERIFY( e.value( "dur" ).toDouble() >= 2000 );  // microseconds
+            QCOMPARE( e.value( "args" ).toObject().value( "derp" ).toInt(), 17 );
+        }
+    }
+    QVERIFY( foundSpan );
+}
+
+void
+LibCalamaresTests::testStartupPhases()
+{
+    using namespace CalamaresUtils;
+
+    const qint64 start = Trace::now();
+    QThread::msleep( 2 );
+    Trace::startupPhase( QStringLiteral( "testing" ), start );
+
+    const auto phases = Trace::startupPhases();
+    QVERIFY( !phases.isEmpty() );
+    QCOMPARE( phases.last().name, QStringLiteral( "testing" ) );
+    QCOMPARE( phases.last().start, start );
+    QVERIFY( phases.last().duration >= 2000 );
+
+    QTemporaryFile f;
+    QVERIFY( f.open() );
+    QVERIFY( Trace::saveStartup( f.fileName() ) );
+
+    QJsonParseError error;
+    auto doc = QJsonDocument::fromJson( f.readAll(), &error );
+    QCOMPARE( error.error, QJsonParseError::NoError );
+    QVERIFY( doc.object().value( "total" ).toDouble() >= phases.last().start + phases.last().duration );
+    const auto saved = doc.object().value( "phases" ).toArray();
+    QCOMPARE( saved.count(), phases.count() );
+    QCOMPARE( saved.last().toObject().value( "name" ).toString(), QStringLiteral( "testing" ) );
+    QCOMPARE( saved.last().toObject().value( "start" ).toDouble(), double( start ) );
+}
+
 QTEST_GUILESS_MAIN( LibCalamaresTests )
 
 #include "utils/moc-warnings.h"
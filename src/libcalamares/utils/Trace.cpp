@@ -0,0 +1,222 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2026 agent <agent@local>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ *
+ */
+
+#include "Trace.h"
+
+#include "utils/Dirs.h"
+#include "utils/Logger.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QVector>
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace
+{
+struct Event
+{
+    char phase;  ///< Chrome trace-event "ph", X (complete), i (instant), C (counter)
+    const char* category;
+    QString name;
+    qint64 timestamp;  ///< microseconds
+    qint64 duration;  ///< microseconds, only for X
+    qint64 threadId;
+    QVariantMap args;
+};
+
+/** @brief Upper bound on the number of recorded events
+ *
+ * A long install with chatty jobs (e.g. progress counters) can produce
+ * events without end; past this many, new events are counted but dropped.
+ */
+static constexpr int maxEvents = 200000;
+
+struct Recorder
+{
+    QMutex mutex;
+    QElapsedTimer clock;
+    QVector< Event > events;
+    QVector< CalamaresUtils::Trace::StartupPhase > startupPhases;
+    qint64 dropped = 0;
+
+    Recorder() { clock.start(); }
+
+    void add( Event&& e )
+    {
+        QMutexLocker lock( &mutex );
+        if ( events.count() >= maxEvents )
+        {
+            ++dropped;
+            return;
+        }
+        events.append( std::move( e ) );
+    }
+};
+
+Recorder&
+recorder()
+{
+    static Recorder r;
+    return r;
+}
+
+qint64
+threadId()
+{
+    static thread_local qint64 tid = static_cast< qint64 >( syscall( SYS_gettid ) );
+    return tid;
+}
+}  // namespace
+
+namespace CalamaresUtils
+{
+namespace Trace
+{
+
+qint64
+now()
+{
+    return recorder().clock.nsecsElapsed() / 1000;
+}
+
+void
+complete( const char* category, const QString& name, qint64 start, const QVariantMap& args )
+{
+    const qint64 end = now();
+    recorder().add( Event { 'X', category, name, start, end - start, threadId(), args } );
+}
+
+void
+instant( const char* category, const QString& name, const QVariantMap& args )
+{
+    recorder().add( Event { 'i', category, name, now(), 0, threadId(), args } );
+}
+
+void
+counter( const char* category, const QString& name, qreal value )
+{
+    recorder().add( Event { 'C', category, name, now(), 0, threadId(), QVariantMap { { name, value } } } );
+}
+
+void
+startupPhase( const QString& name, qint64 start )
+{
+    const qint64 end = now();
+    recorder().add( Event { 'X', "startup", name, start, end - start, threadId(), QVariantMap() } );
+    {
+        QMutexLocker lock( &recorder().mutex );
+        recorder().startupPhases.append( StartupPhase { name, start, end - start } );
+    }
+    cDebug() << "STARTUP:" << name << "took" << ( end - start ) / 1000 << "ms";
+}
+
+QVector< StartupPhase >
+startupPhases()
+{
+    QMutexLocker lock( &recorder().mutex );
+    return recorder().startupPhases;
+}
+
+QString
+startupFile()
+{
+    return CalamaresUtils::appLogDir().filePath( "session-startup.json" );
+}
+
+bool
+saveStartup( const QString& path )
+{
+    QJsonArray phases;
+    for ( const auto& p : startupPhases() )
+    {
+        phases.append( QJsonObject { { "name", p.name }, { "start", p.start }, { "duration", p.duration } } );
+    }
+
+    QFile f( path );
+    if ( !f.open( QIODevice::WriteOnly | QIODevice::Truncate ) )
+    {
+        cWarning() << "Could not write startup timing" << path;
+        return false;
+    }
+    f.write( QJsonDocument( QJsonObject { { "total", now() }, { "phases", phases } } ).toJson( QJsonDocument::Compact ) );
+    return true;
+}
+
+QString
+traceFile()
+{
+    return CalamaresUtils::appLogDir().filePath( "session-trace.json" );
+}
+
+bool
+save( const QString& path )
+{
+    const qint64 pid = QCoreApplication::applicationPid();
+
+    QJsonArray traceEvents;
+    qint64 dropped = 0;
+    {
+        QMutexLocker lock( &recorder().mutex );
+        dropped = recorder().dropped;
+        for ( const auto& e : recorder().events )
+        {
+            QJsonObject o { { "ph", QString( QChar( e.phase ) ) },
+                            { "cat", QString::fromLatin1( e.category ) },
+                            { "name", e.name },
+                            { "ts", e.timestamp },
+                            { "pid", pid },
+                            { "tid", e.threadId } };
+            if ( e.phase == 'X' )
+            {
+                o.insert( "dur", e.duration );
+            }
+            else if ( e.phase == 'i' )
+            {
+                o.insert( "s", QStringLiteral( "t" ) );  // Scoped to the thread
+            }
+            if ( !e.args.isEmpty() )
+            {
+                o.insert( "args", QJsonObject::fromVariantMap( e.args ) );
+            }
+            traceEvents.append( o );
+        }
+    }
+    traceEvents.append( QJsonObject { { "ph", "M" },
+                                      { "name", "process_name" },
+                                      { "pid", pid },
+                                      { "args", QJsonObject { { "name", QCoreApplication::applicationName() } } } } );
+
+    QFile f( path );
+    if ( !f.open( QIODevice::WriteOnly | QIODevice::Truncate ) )
+    {
+        cWarning() << "Could not write trace file" << path;
+        return false;
+    }
+    QJsonObject trace { { "traceEvents", traceEvents }, { "displayTimeUnit", "ms" } };
+    if ( dropped )
+    {
+        trace.insert( "otherData", QJsonObject { { "droppedEvents", dropped } } );
+        cWarning() << "Trace was full," << dropped << "events were dropped.";
+    }
+    f.write( QJsonDocument( trace ).toJson( QJsonDocument::Compact ) );
+    cDebug() << "Wrote" << traceEvents.count() << "trace events to" << path;
+    return true;
+}
+
+}  // namespace Trace
+}  // namespace CalamaresUtils
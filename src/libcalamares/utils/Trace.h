@@ -0,0 +1,126 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2026 agent <agent@local>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ *
+ */
+
+#ifndef UTILS_TRACE_H
+#define UTILS_TRACE_H
+
+#include "DllMacro.h"
+
+#include <QString>
+#include <QVariantMap>
+#include <QVector>
+
+namespace CalamaresUtils
+{
+/** @brief Timing trace of jobs and commands
+ *
+ * Events are recorded in memory while Calamares runs, with monotonic
+ * timestamps and the (kernel) thread id. save() writes them out as
+ * Chrome trace-event JSON, which can be loaded in Perfetto or
+ * chrome://tracing to see which jobs and commands took how long.
+ * The number of events kept in memory is bounded; once it is reached,
+ * further events are dropped and save() reports how many.
+ */
+namespace Trace
+{
+/// @brief Monotonic time, in microseconds since tracing started
+DLLEXPORT qint64 now();
+
+/** @brief Records a complete event that started at @p start and ends now
+ *
+ * The @p start time should come from now(). The @p category
+ * should be a string literal, e.g. "job" or "command".
+ */
+DLLEXPORT void complete( const char* category, const QString& name, qint64 start, const QVariantMap& args = {} );
+/// @brief Records an event without duration
+DLLEXPORT void instant( const char* category, const QString& name, const QVariantMap& args = {} );
+/// @brief Records a change in a value, e.g. the progress of a job
+DLLEXPORT void counter( const char* category, const QString& name, qreal value );
+
+/** @brief The trace file, next to the log file
+ *
+ * This is usually ~/.cache/calamares/session-trace.json
+ */
+DLLEXPORT QString traceFile();
+
+/** @brief Writes all the events recorded so far to @p path
+ *
+ * Returns true on success. The events are kept, so a later
+ * save() writes a superset of the events.
+ */
+DLLEXPORT bool save( const QString& path = traceFile() );
+
+/** @brief A phase of Calamares startup, e.g. "branding"
+ *
+ * Times are in microseconds, like now().
+ */
+struct StartupPhase
+{
+    QString name;
+    qint64 start;
+    qint64 duration;
+};
+
+/** @brief Records startup phase @p name, which started at @p start and ends now
+ *
+ * This records a complete() event in category "startup", logs how
+ * long the phase took, and keeps the phase for startupPhases().
+ * Phases may overlap, e.g. the loading of each module.
+ */
+DLLEXPORT void startupPhase( const QString& name, qint64 start );
+/// @brief The startup phases recorded so far, in the order they ended
+DLLEXPORT QVector< StartupPhase > startupPhases();
+
+/** @brief The startup-timing file, next to the log file
+ *
+ * This is usually ~/.cache/calamares/session-startup.json
+ */
+DLLEXPORT QString startupFile();
+
+/** @brief Writes the startup phases to @p path, as JSON
+ *
+ * The file has the total startup time (until now) and each phase,
+ * with start and duration, in microseconds:
+ *
+ * ```
+ * { "total": 812345, "phases": [ { "name": "settings", "start": 12, "duration": 2345 }, .. ] }
+ * ```
+ */
+DLLEXPORT bool saveStartup( const QString& path = startupFile() );
+
+/** @brief RAII for recording a complete event
+ *
+ * The event starts when the Span is created and ends when it is
+ * destroyed; arguments may be added while the Span lives.
+ */
+class DLLEXPORT Span
+{
+public:
+    Span( const char* category, const QString& name )
+        : m_category( category )
+        , m_name( name )
+        , m_start( now() )
+    {
+    }
+    ~Span() { complete( m_category, m_name, m_start, m_args ); }
+
+    void setArgument( const QString& key, const QVariant& value ) { m_args.insert( key, value ); }
+
+private:
+    const char* m_category;
+    QString m_name;
+    qint64 m_start;
+    QVariantMap m_args;
+};
+
+}  // namespace Trace
+}  // namespace CalamaresUtils
+
+#endif
@@ -13,11 +13,11 @@
 #include "Yaml.h"
 
 #include "utils/Logger.h"
+#include "utils/YamlCache.h"
 
 #include <QByteArray>
 #include <QFile>
 #include <QFileInfo>
-#include <QRegExp>
 
 void
 operator>>( const YAML::Node& node, QStringList& v )
@@ -31,8 +31,77 @@ operator>>( const YAML::Node& node, QStringList& v )
 namespace CalamaresUtils
 {
 
-const QRegExp _yamlScalarTrueValues = QRegExp( "true|True|TRUE|on|On|ON" );
-const QRegExp _yamlScalarFalseValues = QRegExp( "false|False|FALSE|off|Off|OFF" );
+/** @brief Is @p s one of the YAML spellings of a boolean?
+ *
+ * Those are true, on, false and off, in lowercase, Capitalized or
+ * UPPERCASE. If it is, sets @p value and returns true.
+ */
+static bool
+isBoolean( const QString& s, bool& value )
+{
+    if ( s.length() < 2 || s.length() > 5 )
+    {
+        return false;
+    }
+    switch ( s.at( 0 ).unicode() )
+    {
+    case 't':
+    case 'T':
+        value = true;
+        return s == QLatin1String( "true" ) || s == QLatin1String( "True" ) || s == QLatin1String( "TRUE" );
+    case 'f':
+    case 'F':
+        value = false;
+        return s == QLatin1String( "false" ) || s == QLatin1String( "False" ) || s == QLatin1String( "FALSE" );
+    case 'o':
+    case 'O':
+        value = true;
+        if ( s == QLatin1String( "on" ) || s == QLatin1String( "On" ) || s == QLatin1String( "ON" ) )
+        {
+            return true;
+        }
+        value = false;
+        return s == QLatin1String( "off" ) || s == QLatin1String( "Off" ) || s == QLatin1String( "OFF" );
+    default:
+        return false;
+    }
+}
+
+/** @brief Converts @p s to a number, if it looks like one
+ *
+ * Integers are `[-+]?\d+` and floating-point numbers `[-+]?\d*\.\d+`
+ * (as regular expressions); this checks both in one pass over @p s.
+ * Returns an invalid QVariant for anything else.
+ */
+static QVariant
+toNumber( const QString& s )
+{
+    const int length = s.length();
+    int i = 0;
+    if ( i < length && ( s.at( i ) == '-' || s.at( i ) == '+' ) )
+    {
+        ++i;
+    }
+    const int integerStart = i;
+    while ( i < length && s.at( i ).isDigit() )
+    {
+        ++i;
+    }
+    if ( i == length )
+    {
+        return i > integerStart ? QVariant( s.toLongLong() ) : QVariant();
+    }
+    if ( s.at( i ) != '.' )
+    {
+        return QVariant();
+    }
+    const int fractionStart = ++i;
+    while ( i < length && s.at( i ).isDigit() )
+    {
+        ++i;
+    }
+    return ( i == length && i > fractionStart ) ? QVariant( s.toDouble() ) : QVariant();
+}
 
 QVariant
 yamlToVariant( const YAML::Node& node )
@@ -61,23 +130,16 @@ yamlToVariant( const YAML::Node& node )
 QVariant
 yamlScalarToVariant( const YAML::Node& scalarNode )
 {
-    std::string stdScalar = scalarNode.as< std::string >();
-    QString scalarString = QString::fromStdString( stdScalar );
-    if ( _yamlScalarTrueValues.exactMatch( scalarString ) )
-    {
-        return QVariant( true );
-    }
-    if ( _yamlScalarFalseValues.exactMatch( scalarString ) )
-    {
-        return QVariant( false );
-    }
-    if ( QRegExp( "[-+]?\\d+" ).exactMatch( scalarString ) )
+    const QString scalarString = QString::fromStdString( scalarNode.as< std::string >() );
+    bool b = false;
+    if ( isBoolean( scalarString, b ) )
     {
-        return QVariant( scalarString.toLongLong() );
+        return QVariant( b );
     }
-    if ( QRegExp( "[-+]?\\d*\\.?\\d+" ).exactMatch( scalarString ) )
+    QVariant number = toNumber( scalarString );
+    if ( number.isValid() )
     {
-        return QVariant( scalarString.toDouble() );
+        return number;
     }
     return QVariant( scalarString );
 }
@@ -188,23 +250,16 @@ loadYaml( const QString& filename, bool* ok )
         *ok = false;
     }
 
-    QFile yamlFile( filename );
     QVariant yamlContents;
-    if ( yamlFile.exists() && yamlFile.open( QFile::ReadOnly | QFile::Text ) )
+    try
     {
-        QByteArray ba = yamlFile.readAll();
-        try
-        {
-            YAML::Node doc = YAML::Load( ba.constData() );
-            yamlContents = CalamaresUtils::yamlToVariant( doc );
-        }
-        catch ( YAML::Exception& e )
-        {
-            explainYamlException( e, ba, filename );
-            return QVariantMap();
-        }
+        yamlContents = YamlCache::load( filename );
+    }
+    catch ( YAML::Exception& )
+    {
+        // Already explained
+        return QVariantMap();
     }
-
 
     if ( yamlContents.isValid() && !yamlContents.isNull() && yamlContents.type() == QVariant::Map )
     {
@@ -0,0 +1,225 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2026 agent <agent@local>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#include "YamlCache.h"
+
+#include "CalamaresVersionX.h"
+#include "utils/Logger.h"
+#include "utils/Yaml.h"
+
+#include <QDataStream>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QSaveFile>
+
+#include <sys/stat.h>
+
+/// @brief Identifies the cache file, and the format of it
+static constexpr quint32 CACHE_MAGIC = 0x43594331;  // "CYC1"
+
+namespace
+{
+struct CachedDocument
+{
+    qint64 size = -1;
+    qint64 modified = 0;  ///< Nanoseconds since the epoch
+    QVariant document;
+    bool used = false;  ///< Loaded since setCacheFile()
+};
+
+QDataStream&
+operator<<( QDataStream& s, const CachedDocument& d )
+{
+    return s << d.size << d.modified << d.document;
+}
+
+QDataStream&
+operator>>( QDataStream& s, CachedDocument& d )
+{
+    return s >> d.size >> d.modified >> d.document;
+}
+}  // namespace
+
+static QMutex s_mutex;
+static QString s_cacheFile;
+static bool s_enabled = false;  ///< There is a cache file, or a seed
+static QHash< QString, CachedDocument > s_documents;
+static bool s_changed = false;
+
+/** @brief Reads the cache file @p path into @p documents
+ *
+ * Documents already in @p documents are replaced by those from
+ * the file. Returns false if the file can't be used; then
+ * @p documents is left alone.
+ */
+static bool
+readCacheFile( const QString& path, QHash< QString, CachedDocument >& documents )
+{
+    QFile f( path );
+    if ( path.isEmpty() || !f.open( QIODevice::ReadOnly ) )
+    {
+        return false;
+    }
+    QDataStream s( &f );
+    s.setVersion( QDataStream::Qt_5_9 );
+    quint32 magic = 0;
+    QString version;
+    s >> magic >> version;
+    if ( magic != CACHE_MAGIC || version != QStringLiteral( CALAMARES_VERSION ) )
+    {
+        cDebug() << "Ignoring YAML cache" << path << "from another version.";
+        return false;
+    }
+    QHash< QString, CachedDocument > read;
+    s >> read;
+    if ( s.status() != QDataStream::Ok )
+    {
+        cWarning() << "Ignoring bad YAML cache" << path;
+        return false;
+    }
+    for ( auto it = read.cbegin(); it != read.cend(); ++it )
+    {
+        documents.insert( it.key(), it.value() );
+    }
+    cDebug() << "Using YAML cache" << path << "with" << read.count() << "documents.";
+    return true;
+}
+
+namespace CalamaresUtils
+{
+namespace YamlCache
+{
+
+void
+setCacheFile( const QString& path, const QString& seedPath )
+{
+    QMutexLocker l( &s_mutex );
+    s_cacheFile = path;
+    s_enabled = !path.isEmpty() || !seedPath.isEmpty();
+    s_documents.clear();
+    s_changed = false;
+
+    readCacheFile( seedPath, s_documents );
+    readCacheFile( path, s_documents );
+}
+
+QVariant
+load( const QString& path, bool* exists )
+{
+    if ( exists )
+    {
+        *exists = false;
+    }
+
+    struct stat st;
+    if ( ::stat( QFile::encodeName( path ).constData(), &st ) != 0 || !S_ISREG( st.st_mode ) )
+    {
+        return QVariant();
+    }
+    const qint64 size = st.st_size;
+    const qint64 modified = qint64( st.st_mtim.tv_sec ) * 1000000000 + st.st_mtim.tv_nsec;
+
+    bool useCache = false;
+    {
+        QMutexLocker l( &s_mutex );
+        useCache = s_enabled;
+        auto it = s_documents.find( path );
+        if ( useCache && it != s_documents.end() && it->size == size && it->modified == modified )
+        {
+            it->used = true;
+            if ( exists )
+            {
+                *exists = true;
+            }
+            return it->document;
+        }
+    }
+
+    QFile f( path );
+    if ( !f.open( QIODevice::ReadOnly | QIODevice::Text ) )
+    {
+        return QVariant();
+    }
+    if ( exists )
+    {
+        *exists = true;
+    }
+    const QByteArray ba = f.readAll();
+    QVariant document;
+    try
+    {
+        document = yamlToVariant( YAML::Load( ba.constData() ) );
+    }
+    catch ( YAML::Exception& e )
+    {
+        explainYamlException( e, ba, path );
+        throw;
+    }
+
+    if ( useCache )
+    {
+        CachedDocument d;
+        d.size = size;
+        d.modified = modified;
+        d.document = document;
+        d.used = true;
+
+        QMutexLocker l( &s_mutex );
+        s_documents.insert( path, d );
+        s_changed = true;
+    }
+    return document;
+}
+
+void
+save()
+{
+    QMutexLocker l( &s_mutex );
+    bool dropped = false;
+    for ( auto it = s_documents.begin(); it != s_documents.end(); )
+    {
+        if ( it->used )
+        {
+            ++it;
+        }
+        else
+        {
+            it = s_documents.erase( it );
+            dropped = true;
+        }
+    }
+    if ( s_cacheFile.isEmpty() || !( s_changed || dropped ) )
+    {
+        return;
+    }
+
+    QSaveFile f( s_cacheFile );
+    if ( !f.open( QIODevice::WriteOnly ) )
+    {
+        cWarning() << "Could not write YAML cache" << s_cacheFile << f.errorString();
+        return;
+    }
+    QDataStream s( &f );
+    s.setVersion( QDataStream::Qt_5_9 );
+    s << CACHE_MAGIC << QStringLiteral( CALAMARES_VERSION ) << s_documents;
+    if ( f.commit() )
+    {
+        s_changed = false;
+        cDebug() << "Wrote YAML cache" << s_cacheFile << "with" << s_documents.count() << "documents.";
+    }
+    else
+    {
+        cWarning() << "Could not write YAML cache" << s_cacheFile << f.errorString();
+    }
+}
+
+}  // namespace YamlCache
+}  // namespace CalamaresUtils
@@ -0,0 +1,73 @@
+/* === This file is part of Calamares - <https://calamares.io> ===
+ *
+ *   SPDX-FileCopyrightText: 2026 agent <agent@local>
+ *   SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ *   Calamares is Free Software: see the License-Identifier above.
+ *
+ */
+
+#ifndef UTILS_YAMLCACHE_H
+#define UTILS_YAMLCACHE_H
+
+#include "DllMacro.h"
+
+#include <QString>
+#include <QVariant>
+
+namespace CalamaresUtils
+{
+/** @brief Binary cache of converted YAML files
+ *
+ * At startup, Calamares reads the module.desc of every module and the
+ * configuration of each module instance. Parsing YAML and converting
+ * it to QVariants is relatively slow, so the converted documents are
+ * kept in a cache file, in QDataStream format.
+ *
+ * A cached document is used if its file has the same size and
+ * modification time as when it was cached, which takes only a
+ * stat() of the file. Otherwise the file is parsed again.
+ *
+ * The cache is only used once a cache file is set, with setCacheFile().
+ * On live media, the user's cache directory is usually empty at boot,
+ * so a read-only cache can be shipped on the image as well: a seed.
+ */
+namespace YamlCache
+{
+/** @brief Use the cache in file @p path, seeded from @p seedPath
+ *
+ * The cache is read from @p seedPath and then from @p path, if they
+ * exist and are from this version of Calamares; documents in @p path
+ * take precedence. Only @p path is ever written. If both are empty,
+ * the cache is disabled.
+ *
+ * A seed is a cache file written by an earlier run with the same
+ * files (e.g. while building the image), so its documents are used
+ * as long as the files keep their size and modification time.
+ */
+DLLEXPORT void setCacheFile( const QString& path, const QString& seedPath = QString() );
+
+/** @brief Loads the YAML document in file @p path
+ *
+ * Returns the document converted with yamlToVariant(); for an empty
+ * document, that is an invalid QVariant. If the file does not exist
+ * or can't be read, sets @p exists to false (if not nullptr) and
+ * returns an invalid QVariant.
+ *
+ * YAML errors are explained in the log, and the YAML::Exception
+ * is thrown on.
+ */
+DLLEXPORT QVariant load( const QString& path, bool* exists = nullptr );
+
+/** @brief Writes the cache file
+ *
+ * This only writes the file if any documents were (re)parsed.
+ * Documents that were not loaded since setCacheFile() are dropped
+ * from the cache.
+ */
+DLLEXPORT void save();
+
+}  // namespace YamlCache
+}  // namespace CalamaresUtils
+
+#endif
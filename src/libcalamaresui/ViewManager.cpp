@@ -28,6 +28,7 @@
 #include <QFile>
 #include <QMessageBox>
 #include <QMetaObject>
+#include <QTimer>
 
 #define UPDATE_BUTTON_PROPERTY( name, value ) \
     { \
@@ -35,6 +36,9 @@
         emit name##Changed( m_##name ); \
     }
 
+/// @brief Delay (ms) before preparing the next page, after showing one
+static constexpr int PREPARE_NEXT_DELAY = 100;
+
 namespace Calamares
 {
 
@@ -116,24 +120,64 @@ ViewManager::insertViewStep( int before, ViewStep* step )
     connect( step, &ViewStep::ensureSize, this, &ViewManager::ensureSize );
     connect( step, &ViewStep::nextStatusChanged, this, &ViewManager::updateNextStatus );
 
-    if ( !step->widget() )
+    // The widget itself is created when it is about to be shown,
+    // except for the first one, which is shown right away.
+    QWidget* placeholder = new QWidget;
+    m_placeholders.insert( step, placeholder );
+    m_stack->insertWidget( before, placeholder );
+    m_stack->setCurrentIndex( 0 );
+    if ( before == 0 )
+    {
+        ensureWidget( 0 );
+    }
+    emit endInsertRows();
+}
+
+
+void
+ViewManager::ensureWidget( int index )
+{
+    ViewStep* step = m_steps.value( index );
+    auto it = m_placeholders.find( step );
+    if ( !step || it == m_placeholders.end() )
+    {
+        return;
+    }
+    QWidget* placeholder = it.value();
+    m_placeholders.erase( it );
+
+    QWidget* widget = step->widget();
+    if ( !widget )
     {
+        // The placeholder stays, as an empty page
         cError() << "ViewStep" << step->moduleInstanceKey() << "has no widget.";
+        return;
     }
-    else
+
+    QLayout* layout = widget->layout();
+    if ( layout )
     {
-        QLayout* layout = step->widget()->layout();
-        if ( layout )
-        {
-            const auto margins = step->widgetMargins( m_panelSides );
-            layout->setContentsMargins( margins.width(), margins.height(), margins.width(), margins.height() );
-        }
+        const auto margins = step->widgetMargins( m_panelSides );
+        layout->setContentsMargins( margins.width(), margins.height(), margins.width(), margins.height() );
+    }
 
-        m_stack->insertWidget( before, step->widget() );
-        m_stack->setCurrentIndex( 0 );
-        step->widget()->setFocus();
+    const int stackIndex = m_stack->indexOf( placeholder );
+    const bool isCurrent = m_stack->currentWidget() == placeholder;
+    m_stack->insertWidget( stackIndex, widget );
+    m_stack->removeWidget( placeholder );
+    delete placeholder;
+    if ( isCurrent )
+    {
+        m_stack->setCurrentIndex( stackIndex );
+        widget->setFocus();
     }
-    emit endInsertRows();
+}
+
+
+void
+ViewManager::prepareNextWidget()
+{
+    QTimer::singleShot( PREPARE_NEXT_DELAY, this, [this]() { ensureWidget( m_currentStep + 1 ); } );
 }
 
 
@@ -236,7 +280,9 @@ ViewManager::onInitComplete()
     // Tell the first view that it's been shown.
     if ( m_steps.count() > 0 )
     {
+        ensureWidget( 0 );
         m_steps.first()->onActivate();
+        prepareNextWidget();
     }
 }
 
@@ -352,12 +398,14 @@ ViewManager::next()
 
         m_currentStep++;
 
+        ensureWidget( m_currentStep );
         m_stack->setCurrentIndex( m_currentStep );  // Does nothing if out of range
         step->onLeave();
 
         if ( m_currentStep < m_steps.count() )
         {
             m_steps.at( m_currentStep )->onActivate();
+            prepareNextWidget();
             executing = qobject_cast< ExecutionViewStep* >( m_steps.at( m_currentStep ) ) != nullptr;
             emit currentStepChanged();
         }
@@ -453,6 +501,7 @@ ViewManager::back()
     if ( step->isAtBeginning() && m_currentStep > 0 )
     {
         m_currentStep--;
+        ensureWidget( m_currentStep );
         m_stack->setCurrentIndex( m_currentStep );
         step->onLeave();
         m_steps.at( m_currentStep )->onActivate();
@@ -15,6 +15,7 @@
 #include "viewpages/ViewStep.h"
 
 #include <QAbstractListModel>
+#include <QHash>
 #include <QList>
 #include <QPushButton>
 #include <QStackedWidget>
@@ -215,6 +216,14 @@ private:
     ~ViewManager() override;
 
     void insertViewStep( int before, ViewStep* step );
+    /** @brief Puts the widget of the step at @p index in the stack
+     *
+     * Steps are added with a placeholder page, and asked for their
+     * widget when they are about to be shown.
+     */
+    void ensureWidget( int index );
+    /// @brief Prepares the widget of the step after the current one, soon
+    void prepareNextWidget();
     void updateButtonLabels();
     void updateCancelEnabled( bool enabled );
 
@@ -224,6 +233,7 @@ private:
 
     ViewStepList m_steps;
     int m_currentStep;
+    QHash< ViewStep*, QWidget* > m_placeholders;  ///< Steps whose widget is not in the stack yet
 
     QWidget* m_widget;
     QStackedWidget* m_stack;
@@ -14,8 +14,10 @@
 #include "utils/Logger.h"
 #include "utils/PluginFactory.h"
 
+#include <QCoreApplication>
 #include <QDir>
 #include <QPluginLoader>
+#include <QThread>
 
 namespace Calamares
 {
@@ -36,21 +38,38 @@ CppJobModule::interface() const
 
 
 void
-CppJobModule::loadSelf()
+CppJobModule::preloadSelf()
 {
     if ( m_loader )
     {
-        CalamaresPluginFactory* pf = qobject_cast< CalamaresPluginFactory* >( m_loader->instance() );
+        // The plugin instance is created by loadSelf(), on the GUI thread;
+        // errors are reported there, too.
+        m_loader->load();
+        if ( QCoreApplication::instance() )
+        {
+            m_loader->moveToThread( QCoreApplication::instance()->thread() );
+        }
+    }
+}
+
+
+void
+CppJobModule::loadSelf()
+{
+    if ( m_staticInstance || m_loader )
+    {
+        CalamaresPluginFactory* pf = qobject_cast< CalamaresPluginFactory* >(
+            m_staticInstance ? m_staticInstance() : m_loader->instance() );
         if ( !pf )
         {
-            cDebug() << "Could not load module:" << m_loader->errorString();
+            cDebug() << "Could not load module:" << ( m_loader ? m_loader->errorString() : QString() );
             return;
         }
 
         CppJob* cppJob = pf->create< Calamares::CppJob >();
         if ( !cppJob )
         {
-            cDebug() << "Could not load module:" << m_loader->errorString();
+            cDebug() << "Could not load module:" << ( m_loader ? m_loader->errorString() : QString() );
             return;
         }
         //        cDebug() << "CppJobModule loading self for instance" << instanceKey()
@@ -77,6 +96,13 @@ CppJobModule::jobs() const
 void
 CppJobModule::initFrom( const ModuleSystem::Descriptor& moduleDescriptor )
 {
+    // A module that is linked into Calamares has no plugin file
+    m_staticInstance = CalamaresPluginFactory::staticModule( moduleDescriptor.name() );
+    if ( m_staticInstance )
+    {
+        return;
+    }
+
     QDir directory( location() );
     QString load = moduleDescriptor.load();
     if ( !load.isEmpty() )
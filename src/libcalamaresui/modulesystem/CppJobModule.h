@@ -15,6 +15,8 @@
 #include "DllMacro.h"
 #include "modulesystem/Module.h"
 
+#include <QtPlugin>
+
 class QPluginLoader;
 
 namespace Calamares
@@ -27,6 +29,7 @@ public:
     Interface interface() const override;
 
     void loadSelf() override;
+    void preloadSelf() override;
     JobList jobs() const override;
 
 protected:
@@ -37,6 +40,7 @@ private:
     ~CppJobModule() override;
 
     QPluginLoader* m_loader;
+    QtPluginInstanceFunction m_staticInstance = nullptr;  ///< For a module linked into Calamares
     job_ptr m_job;
 
     friend Module* Calamares::moduleFromDescriptor( const ModuleSystem::Descriptor& moduleDescriptor,
@@ -12,18 +12,59 @@
 
 #include "ViewManager.h"
 
+#include "JobQueue.h"
 #include "Settings.h"
 #include "modulesystem/Module.h"
 #include "modulesystem/RequirementsChecker.h"
 #include "modulesystem/RequirementsModel.h"
 #include "utils/Logger.h"
+#include "utils/Trace.h"
 #include "utils/Yaml.h"
 #include "viewpages/ExecutionViewStep.h"
 
 #include <QApplication>
 #include <QDir>
+#include <QRunnable>
+#include <QThreadPool>
 #include <QTimer>
 
+#include <functional>
+
+namespace
+{
+/// @brief Calls a function with an index, on a thread pool
+class IndexRunner : public QRunnable
+{
+public:
+    IndexRunner( const std::function< void( int ) >& f, int index )
+        : m_f( f )
+        , m_index( index )
+    {
+    }
+
+    void run() override { m_f( m_index ); }
+
+private:
+    const std::function< void( int ) >& m_f;
+    int m_index;
+};
+
+/** @brief Calls @p f( i ) for each 0 <= i < @p count, concurrently
+ *
+ * Returns when all the calls are done.
+ */
+void
+forEachConcurrently( int count, const std::function< void( int ) >& f )
+{
+    QThreadPool pool;
+    for ( int i = 0; i < count; ++i )
+    {
+        pool.start( new IndexRunner( f, i ) );
+    }
+    pool.waitForDone();
+}
+}  // namespace
+
 namespace Calamares
 {
 ModuleManager* ModuleManager::s_instance = nullptr;
@@ -72,6 +113,17 @@ ModuleManager::doInit()
     // the module name, and must contain a settings file named module.desc.
     // If at any time the module loading procedure finds something unexpected, it
     // silently skips to the next module or search path. --Teo 6/2014
+    //
+    // The descriptors are read concurrently, and then added in the order
+    // of the search paths, so that the first module with a given name wins.
+    struct Candidate
+    {
+        QString path;
+        QString subdir;
+        QString directory;  ///< Set if the descriptor is good
+        QVariantMap descriptor;
+    };
+    QVector< Candidate > candidates;
     for ( const QString& path : m_paths )
     {
         QDir currentDir( path );
@@ -80,40 +132,7 @@ ModuleManager::doInit()
             const QStringList subdirs = currentDir.entryList( QDir::AllDirs | QDir::NoDotAndDotDot );
             for ( const QString& subdir : subdirs )
             {
-                currentDir.setPath( path );
-                bool success = currentDir.cd( subdir );
-                if ( success )
-                {
-                    static const char bad_descriptor[] = "ModuleManager potential module descriptor is bad";
-                    QFileInfo descriptorFileInfo( currentDir.absoluteFilePath( QLatin1String( "module.desc" ) ) );
-                    if ( !descriptorFileInfo.exists() )
-                    {
-                        cDebug() << bad_descriptor << descriptorFileInfo.absoluteFilePath() << "(missing)";
-                        continue;
-                    }
-                    if ( !descriptorFileInfo.isReadable() )
-                    {
-                        cDebug() << bad_descriptor << descriptorFileInfo.absoluteFilePath() << "(unreadable)";
-                        continue;
-                    }
-
-                    bool ok = false;
-                    QVariantMap moduleDescriptorMap = CalamaresUtils::loadYaml( descriptorFileInfo, &ok );
-                    QString moduleName = ok ? moduleDescriptorMap.value( "name" ).toString() : QString();
-
-                    if ( ok && !moduleName.isEmpty() && ( moduleName == currentDir.dirName() )
-                         && !m_availableDescriptorsByModuleName.contains( moduleName ) )
-                    {
-                        auto descriptor
-                            = Calamares::ModuleSystem::Descriptor::fromDescriptorData( moduleDescriptorMap );
-                        descriptor.setDirectory( descriptorFileInfo.absoluteDir().absolutePath() );
-                        m_availableDescriptorsByModuleName.insert( moduleName, descriptor );
-                    }
-                }
-                else
-                {
-                    cWarning() << "ModuleManager module directory is not accessible:" << path << "/" << subdir;
-                }
+                candidates.append( Candidate { path, subdir, QString(), QVariantMap() } );
             }
         }
         else
@@ -121,6 +140,49 @@ ModuleManager::doInit()
             cDebug() << "ModuleManager module search path does not exist:" << path;
         }
     }
+
+    forEachConcurrently( candidates.count(), [&candidates]( int index ) {
+        Candidate& c = candidates[ index ];
+        QDir currentDir( c.path );
+        if ( !currentDir.cd( c.subdir ) )
+        {
+            cWarning() << "ModuleManager module directory is not accessible:" << c.path << "/" << c.subdir;
+            return;
+        }
+
+        static const char bad_descriptor[] = "ModuleManager potential module descriptor is bad";
+        QFileInfo descriptorFileInfo( currentDir.absoluteFilePath( QLatin1String( "module.desc" ) ) );
+        if ( !descriptorFileInfo.exists() )
+        {
+            cDebug() << bad_descriptor << descriptorFileInfo.absoluteFilePath() << "(missing)";
+            return;
+        }
+        if ( !descriptorFileInfo.isReadable() )
+        {
+            cDebug() << bad_descriptor << descriptorFileInfo.absoluteFilePath() << "(unreadable)";
+            return;
+        }
+
+        bool ok = false;
+        QVariantMap moduleDescriptorMap = CalamaresUtils::loadYaml( descriptorFileInfo, &ok );
+        QString moduleName = ok ? moduleDescriptorMap.value( "name" ).toString() : QString();
+        if ( ok && !moduleName.isEmpty() && ( moduleName == currentDir.dirName() ) )
+        {
+            c.directory = descriptorFileInfo.absoluteDir().absolutePath();
+            c.descriptor = moduleDescriptorMap;
+        }
+    } );
+
+    for ( const auto& c : qAsConst( candidates ) )
+    {
+        const QString moduleName = c.descriptor.value( "name" ).toString();
+        if ( !c.directory.isEmpty() && !m_availableDescriptorsByModuleName.contains( moduleName ) )
+        {
+            auto descriptor = Calamares::ModuleSystem::Descriptor::fromDescriptorData( c.descriptor );
+            descriptor.setDirectory( c.directory );
+            m_availableDescriptorsByModuleName.insert( moduleName, descriptor );
+        }
+    }
     // At this point m_availableDescriptorsByModuleName is filled with
     // the modules that were found in the search paths.
     cDebug() << "Found" << m_availableDescriptorsByModuleName.count() << "modules";
@@ -189,9 +251,56 @@ ModuleManager::loadModules()
         cWarning() << "Some installed modules have unmet dependencies.";
     }
     Settings::InstanceDescriptionList customInstances = Settings::instance()->moduleInstances();
+    const auto modulesSequence = Settings::instance()->modulesSequence();
+
+    // Create the modules, read their configuration and load their plugins
+    // concurrently; each instance is created once, however often it is
+    // listed. The rest (creating widgets, checking dependencies) happens
+    // below, in sequence order.
+    struct Creation
+    {
+        ModuleSystem::InstanceKey instanceKey;
+        ModuleSystem::Descriptor descriptor;
+        QString configFileName;
+        Module* module = nullptr;
+    };
+    QVector< Creation > creations;
+    QMap< ModuleSystem::InstanceKey, Module* > createdModules;
+    for ( const auto& modulePhase : modulesSequence )
+    {
+        for ( const auto& instanceKey : modulePhase.second )
+        {
+            ModuleSystem::Descriptor descriptor
+                = m_availableDescriptorsByModuleName.value( instanceKey.module(), ModuleSystem::Descriptor() );
+            if ( instanceKey.isValid() && descriptor.isValid() && !createdModules.contains( instanceKey )
+                 && !m_loadedModulesByInstanceKey.contains( instanceKey ) )
+            {
+                createdModules.insert( instanceKey, nullptr );
+                creations.append(
+                    Creation { instanceKey,
+                               descriptor,
+                               getConfigFileName( customInstances, instanceKey, descriptor ),
+                               nullptr } );
+            }
+        }
+    }
+    forEachConcurrently( creations.count(), [&creations]( int index ) {
+        Creation& c = creations[ index ];
+        const qint64 start = CalamaresUtils::Trace::now();
+        c.module = Calamares::moduleFromDescriptor(
+            c.descriptor, c.instanceKey.id(), c.configFileName, c.descriptor.directory() );
+        if ( c.module )
+        {
+            c.module->preloadSelf();
+        }
+        CalamaresUtils::Trace::startupPhase( QStringLiteral( "create " ) + c.instanceKey.toString(), start );
+    } );
+    for ( const auto& c : qAsConst( creations ) )
+    {
+        createdModules.insert( c.instanceKey, c.module );
+    }
 
     QStringList failedModules;
-    const auto modulesSequence = Settings::instance()->modulesSequence();
     for ( const auto& modulePhase : modulesSequence )
     {
         ModuleSystem::Action currentAction = modulePhase.first;
@@ -244,8 +353,9 @@ ModuleManager::loadModules()
             }
             else
             {
-                thisModule = Calamares::moduleFromDescriptor(
-                    descriptor, instanceKey.id(), configFileName, descriptor.directory() );
+                // Created above; take it, so that a failed module is not
+                // used for a second listing of the same instance.
+                thisModule = createdModules.take( instanceKey );
                 if ( !thisModule )
                 {
                     cError() << "Module" << instanceKey.toString() << "cannot be created from descriptor"
@@ -308,7 +418,9 @@ ModuleManager::addModule( Module* module )
 
     if ( !module->isLoaded() )
     {
+        const qint64 start = CalamaresUtils::Trace::now();
         module->loadSelf();
+        CalamaresUtils::Trace::startupPhase( QStringLiteral( "load " ) + module->instanceKey().toString(), start );
     }
 
     // Even if the load failed, we keep the module, so that if it tried to
@@ -342,6 +454,17 @@ ModuleManager::checkRequirements()
     } );
 
     QTimer::singleShot( 0, rq, &RequirementsChecker::run );
+
+    // The user is busy with the UI for a while, use that time
+    JobList prepareJobs;
+    for ( const auto& module : modules )
+    {
+        prepareJobs << module->prepareJobs();
+    }
+    if ( !prepareJobs.isEmpty() && JobQueue::instance() )
+    {
+        JobQueue::instance()->prepare( prepareJobs );
+    }
 }
 
 static QStringList
@@ -97,6 +97,9 @@ public:
     /**
      * @brief Starts asynchronous requirements checking for each module.
      * When this is done, the signal requirementsComplete is emitted.
+     *
+     * This also starts the background preparations of the modules,
+     * see Module::prepareJobs().
      */
     void checkRequirements();
 
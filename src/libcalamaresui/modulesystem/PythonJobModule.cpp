@@ -40,7 +40,15 @@ PythonJobModule::loadSelf()
         return;
     }
 
-    m_job = Calamares::job_ptr( new PythonJob( m_scriptFileName, m_workingPath, m_configurationMap ) );
+    auto* job = new PythonJob( m_scriptFileName, m_workingPath, m_configurationMap );
+    m_job = Calamares::job_ptr( job );
+    if ( m_hasPrepare )
+    {
+        auto* prepareJob = new PythonJob( m_scriptFileName, m_workingPath, m_configurationMap );
+        prepareJob->setEntryPoint( QStringLiteral( "prepare" ) );
+        prepareJob->shareWorkSize( *job );
+        m_prepareJob = Calamares::job_ptr( prepareJob );
+    }
     m_loaded = true;
 }
 
@@ -52,12 +60,20 @@ PythonJobModule::jobs() const
 }
 
 
+JobList
+PythonJobModule::prepareJobs() const
+{
+    return m_prepareJob ? JobList() << m_prepareJob : JobList();
+}
+
+
 void
 PythonJobModule::initFrom( const ModuleSystem::Descriptor& moduleDescriptor )
 {
     QDir directory( location() );
     m_workingPath = directory.absolutePath();
     m_scriptFileName = moduleDescriptor.script();
+    m_hasPrepare = moduleDescriptor.hasPrepare();
 }
 
 
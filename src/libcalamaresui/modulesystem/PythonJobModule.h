@@ -24,6 +24,7 @@ public:
 
     void loadSelf() override;
     JobList jobs() const override;
+    JobList prepareJobs() const override;
 
 protected:
     void initFrom( const ModuleSystem::Descriptor& moduleDescriptor ) override;
@@ -35,6 +36,8 @@ private:
     QString m_scriptFileName;
     QString m_workingPath;
     job_ptr m_job;
+    job_ptr m_prepareJob;  ///< Only if the module has a prepare() function
+    bool m_hasPrepare = false;
 
     friend Module* Calamares::moduleFromDescriptor( const ModuleSystem::Descriptor& moduleDescriptor,
                                                     const QString& instanceId,
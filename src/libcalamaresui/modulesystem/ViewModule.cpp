@@ -15,8 +15,10 @@
 #include "utils/PluginFactory.h"
 #include "viewpages/ViewStep.h"
 
+#include <QCoreApplication>
 #include <QDir>
 #include <QPluginLoader>
+#include <QThread>
 
 namespace Calamares
 {
@@ -37,21 +39,38 @@ ViewModule::interface() const
 
 
 void
-ViewModule::loadSelf()
+ViewModule::preloadSelf()
 {
     if ( m_loader )
     {
-        CalamaresPluginFactory* pf = qobject_cast< CalamaresPluginFactory* >( m_loader->instance() );
+        // The plugin instance is created by loadSelf(), on the GUI thread;
+        // errors are reported there, too.
+        m_loader->load();
+        if ( QCoreApplication::instance() )
+        {
+            m_loader->moveToThread( QCoreApplication::instance()->thread() );
+        }
+    }
+}
+
+
+void
+ViewModule::loadSelf()
+{
+    if ( m_staticInstance || m_loader )
+    {
+        CalamaresPluginFactory* pf = qobject_cast< CalamaresPluginFactory* >(
+            m_staticInstance ? m_staticInstance() : m_loader->instance() );
         if ( !pf )
         {
-            cWarning() << "No factory:" << m_loader->errorString();
+            cWarning() << "No factory:" << ( m_loader ? m_loader->errorString() : QString() );
             return;
         }
 
         m_viewStep = pf->create< Calamares::ViewStep >();
         if ( !m_viewStep )
         {
-            cWarning() << "create() failed" << m_loader->errorString();
+            cWarning() << "create() failed" << ( m_loader ? m_loader->errorString() : QString() );
             return;
         }
     }
@@ -79,9 +98,23 @@ ViewModule::jobs() const
 }
 
 
+JobList
+ViewModule::prepareJobs() const
+{
+    return m_viewStep->prepareJobs();
+}
+
+
 void
 ViewModule::initFrom( const ModuleSystem::Descriptor& moduleDescriptor )
 {
+    // A module that is linked into Calamares has no plugin file
+    m_staticInstance = CalamaresPluginFactory::staticModule( moduleDescriptor.name() );
+    if ( m_staticInstance )
+    {
+        return;
+    }
+
     QDir directory( location() );
     QString load = moduleDescriptor.load();
     if ( !load.isEmpty() )
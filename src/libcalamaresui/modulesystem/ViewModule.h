@@ -14,6 +14,8 @@
 #include "DllMacro.h"
 #include "modulesystem/Module.h"
 
+#include <QtPlugin>
+
 class QPluginLoader;
 
 namespace Calamares
@@ -28,7 +30,9 @@ public:
     Interface interface() const override;
 
     void loadSelf() override;
+    void preloadSelf() override;
     JobList jobs() const override;
+    JobList prepareJobs() const override;
 
     RequirementsList checkRequirements() override;
 
@@ -40,6 +44,7 @@ private:
     ~ViewModule() override;
 
     QPluginLoader* m_loader;
+    QtPluginInstanceFunction m_staticInstance = nullptr;  ///< For a module linked into Calamares
     ViewStep* m_viewStep = nullptr;
 
     friend Module* Calamares::moduleFromDescriptor( const ModuleSystem::Descriptor& moduleDescriptor,
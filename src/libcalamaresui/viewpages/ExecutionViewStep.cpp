@@ -165,10 +165,20 @@ ExecutionViewStep::onActivate()
                     j->setEmergency( true );
                 }
             }
-            queue->enqueue( weight, jl );
+            JobConstraints constraints;
+            constraints.instanceKey = instanceKey.toString();
+            if ( moduleDescriptor.hasSchedulingInformation() )
+            {
+                constraints.moduleName = moduleDescriptor.name();
+                constraints.after = moduleDescriptor.after();
+                constraints.inputs = moduleDescriptor.inputs();
+                constraints.outputs = moduleDescriptor.outputs();
+            }
+            queue->enqueue( weight, jl, constraints );
         }
     }
 
+    m_elapsed.start();
     queue->start();
 }
 
@@ -191,6 +201,18 @@ void
 ExecutionViewStep::updateFromJobQueue( qreal percent, const QString& message )
 {
     m_progressBar->setValue( int( percent * m_progressBar->maximum() ) );
+    // Progress is proportional to time only when measured durations are used
+    if ( JobQueue::instance()->hasMeasuredWeights() && m_elapsed.isValid() && percent > 0.05 && percent < 1.0 )
+    {
+        const qint64 remaining = qint64( m_elapsed.elapsed() * ( 1.0 - percent ) / percent );
+        const int minutes = int( remaining / 60000 );
+        m_progressBar->setFormat( minutes < 1 ? tr( "%p% (less than a minute remaining)" )
+                                              : tr( "%p% (about %n minute(s) remaining)", "", minutes ) );
+    }
+    else
+    {
+        m_progressBar->setFormat( QStringLiteral( "%p%" ) );
+    }
     if ( !message.isEmpty() )
     {
         m_label->setText( message );
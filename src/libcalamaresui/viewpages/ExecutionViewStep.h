@@ -14,6 +14,7 @@
 #include "ViewStep.h"
 #include "modulesystem/InstanceKey.h"
 
+#include <QElapsedTimer>
 #include <QStringList>
 
 class QLabel;
@@ -54,6 +55,7 @@ public:
 private:
     QWidget* m_widget;
     QProgressBar* m_progressBar;
+    QElapsedTimer m_elapsed;  ///< Since the jobs were started, for estimating time remaining
     QLabel* m_label;
     Slideshow* m_slideshow;
 
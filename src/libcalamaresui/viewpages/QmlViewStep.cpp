@@ -76,7 +76,7 @@ QmlViewStep::QmlViewStep( QObject* parent )
     m_qmlWidget->setResizeMode( QQuickWidget::SizeRootObjectToView );
     m_qmlWidget->engine()->addImportPath( CalamaresUtils::qmlModulesDir().absolutePath() );
 
-    // QML Loading starts when the configuration for the module is set.
+    // QML loading starts when the widget is first asked for.
 }
 
 QmlViewStep::~QmlViewStep() {}
@@ -139,6 +139,10 @@ QmlViewStep::onLeave()
 QWidget*
 QmlViewStep::widget()
 {
+    if ( !m_qmlComponent && !m_qmlFileName.isEmpty() )
+    {
+        loadQml();
+    }
     return m_widget;
 }
 
@@ -241,15 +245,7 @@ QmlViewStep::setConfigurationMap( const QVariantMap& configurationMap )
         {
             setContextProperty( "config", config );
         }
-
-        cDebug() << "QmlViewStep" << moduleInstanceKey() << "loading" << m_qmlFileName;
-        m_qmlComponent = new QQmlComponent(
-            m_qmlWidget->engine(), QUrl( m_qmlFileName ), QQmlComponent::CompilationMode::Asynchronous );
-        connect( m_qmlComponent, &QQmlComponent::statusChanged, this, &QmlViewStep::loadComplete );
-        if ( m_qmlComponent->status() == QQmlComponent::Error )
-        {
-            showFailedQml();
-        }
+        // The QML itself is loaded when the widget is needed
     }
     else
     {
@@ -257,6 +253,24 @@ QmlViewStep::setConfigurationMap( const QVariantMap& configurationMap )
     }
 }
 
+void
+QmlViewStep::loadQml()
+{
+    cDebug() << "QmlViewStep" << moduleInstanceKey() << "loading" << m_qmlFileName;
+    m_qmlComponent = new QQmlComponent(
+        m_qmlWidget->engine(), QUrl( m_qmlFileName ), QQmlComponent::CompilationMode::Asynchronous );
+    connect( m_qmlComponent, &QQmlComponent::statusChanged, this, &QmlViewStep::loadComplete );
+    if ( m_qmlComponent->status() == QQmlComponent::Error )
+    {
+        showFailedQml();
+    }
+    else if ( m_qmlComponent->isReady() )
+    {
+        // Already compiled (cached) by the engine, so no status change
+        loadComplete();
+    }
+}
+
 void
 QmlViewStep::showFailedQml()
 {
@@ -96,6 +96,8 @@ private Q_SLOTS:
     void loadComplete();
 
 private:
+    /// @brief Starts loading the QML, when the widget is first needed
+    void loadQml();
     /// @brief Swap out the spinner for the QQuickWidget
     void showQml();
     /// @brief Show error message in spinner.
@@ -48,6 +48,12 @@ ViewStep::onLeave()
 {
 }
 
+JobList
+ViewStep::prepareJobs() const
+{
+    return JobList();
+}
+
 void
 ViewStep::next()
 {
@@ -155,6 +155,15 @@ public:
      */
     virtual JobList jobs() const = 0;
 
+    /**
+     * @brief Jobs to run in the background while the UI is shown
+     *
+     * These are started when the modules are loaded; they must not
+     * touch the disks being installed to. See JobQueue::prepare().
+     * The default implementation returns an empty list.
+     */
+    virtual JobList prepareJobs() const;
+
     void setModuleInstanceKey( const Calamares::ModuleSystem::InstanceKey& instanceKey );
     Calamares::ModuleSystem::InstanceKey moduleInstanceKey() const { return m_instanceKey; }
 
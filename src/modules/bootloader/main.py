@@ -57,7 +57,7 @@ def get_uuid():
 
     :return:
     """
-    partitions = libcalamares.globalstorage.value("partitions")
+    partitions = libcalamares.globalstorage.view("partitions")
 
     for partition in partitions:
         if partition["mountPoint"] == "/":
@@ -114,7 +114,7 @@ def create_systemd_boot_conf(install_path, efi_dir, uuid, entry, entry_name, ker
     kernel = libcalamares.job.configuration["kernel"]
     kernel_params = ["quiet"]
 
-    partitions = libcalamares.globalstorage.value("partitions")
+    partitions = libcalamares.globalstorage.view("partitions")
     swap_uuid = ""
     swap_outer_mappername = None
 
@@ -474,7 +474,7 @@ def run():
         libcalamares.utils.warning( "Non-EFI system, and no bootloader is set." )
         return None
 
-    partitions = libcalamares.globalstorage.value("partitions")
+    partitions = libcalamares.globalstorage.view("partitions")
     if fw_type == "efi":
         efi_system_partition = libcalamares.globalstorage.value("efiSystemPartition")
         esp_found = [ p for p in partitions if p["mountPoint"] == efi_system_partition ]
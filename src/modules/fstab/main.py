@@ -124,6 +124,7 @@ class FstabGenerator(object):
         self.crypttab_options = crypttab_options
         self.ssd_disks = set()
         self.root_is_ssd = False
+        self.subvolume_mount_points = []
 
     def run(self):
         """ Calls needed sub routines.
@@ -203,15 +204,16 @@ class FstabGenerator(object):
                     output_lines = output.splitlines()
                     for line in output_lines:
                         if line.endswith(b'path @'):
-                            root_entry = partition
+                            root_entry = partition.copy()
                             root_entry["subvol"] = "@"
                             dct = self.generate_fstab_line_info(root_entry)
                             if dct:
                                 self.print_fstab_line(dct, file=fstab_file)
                         elif line.endswith(b'path @home'):
-                            home_entry = partition
+                            home_entry = partition.copy()
                             home_entry["mountPoint"] = "/home"
                             home_entry["subvol"] = "@home"
+                            self.subvolume_mount_points.append("/home")
                             dct = self.generate_fstab_line_info(home_entry)
                             if dct:
                                 self.print_fstab_line(dct, file=fstab_file)
@@ -304,6 +306,8 @@ class FstabGenerator(object):
         for partition in self.partitions:
             if partition["mountPoint"]:
                 mkdir_p(self.root_mount_point + partition["mountPoint"])
+        for mount_point in self.subvolume_mount_points:
+            mkdir_p(self.root_mount_point + mount_point)
 
     def get_mount_options(self, filesystem, mount_point):
         efiMountPoint = libcalamares.globalstorage.value("efiSystemPartition")
@@ -323,7 +327,7 @@ def run():
     """
     global_storage = libcalamares.globalstorage
     conf = libcalamares.job.configuration
-    partitions = global_storage.value("partitions")
+    partitions = global_storage.view("partitions")
     root_mount_point = global_storage.value("rootMountPoint")
 
     if not partitions:
@@ -22,10 +22,10 @@
 #include "JobQueue.h"
 #include "utils/CalamaresUtilsSystem.h"
 #include "utils/Logger.h"
+#include "utils/Probe.h"
 #include "utils/Units.h"
 
 #include <QDir>
-#include <QFile>
 
 #ifdef WITH_KOSRelease
 #include <KOSRelease>
@@ -127,24 +127,21 @@ hostCPU_FreeBSD()
 QString
 hostCPU_Linux()
 {
-    QFile cpuinfo( "/proc/cpuinfo" );
-    if ( cpuinfo.open( QIODevice::ReadOnly ) )
+    QByteArray cpuinfo = CalamaresUtils::Probe::readFile( "/proc/cpuinfo" );
+    QTextStream in( &cpuinfo, QIODevice::ReadOnly );
+    QString line;
+    while ( in.readLineInto( &line ) )
     {
-        QTextStream in( &cpuinfo );
-        QString line;
-        while ( in.readLineInto( &line ) )
+        if ( line.startsWith( "vendor_id" ) )
         {
-            if ( line.startsWith( "vendor_id" ) )
-            {
-                return hostCPUmatch( line );
-            }
-            if ( line.startsWith( "CPU implementer" ) )
-            {
-                return hostCPUmatchARM( line );
-            }
+            return hostCPUmatch( line );
+        }
+        if ( line.startsWith( "CPU implementer" ) )
+        {
+            return hostCPUmatchARM( line );
         }
     }
-    return QString();  // Not open, or not found
+    return QString();  // Not read, or not found
 }
 #endif
 
@@ -20,6 +20,7 @@
 
 #include "utils/CalamaresUtilsSystem.h"
 #include "utils/Logger.h"
+#include "utils/Probe.h"
 #include "utils/UMask.h"
 #include "utils/Variant.h"
 
@@ -88,8 +89,7 @@ InitcpioJob::setConfigurationMap( const QVariantMap& configurationMap )
     }
     else if ( m_kernel == "$uname" )
     {
-        auto r = CalamaresUtils::System::runCommand(
-            CalamaresUtils::System::RunLocation::RunInHost, { "/bin/uname", "-r" }, QString(), QString(), std::chrono::seconds( 3 ) );
+        auto r = CalamaresUtils::Probe::run( { "/bin/uname", "-r" }, std::chrono::seconds( 3 ) );
         if ( r.getExitCode() == 0 )
         {
             m_kernel = r.getOutput();
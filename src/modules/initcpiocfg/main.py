@@ -197,7 +197,7 @@ def run():
 
     :return:
     """
-    partitions = libcalamares.globalstorage.value("partitions")
+    partitions = libcalamares.globalstorage.view("partitions")
     root_mount_point = libcalamares.globalstorage.value("rootMountPoint")
 
     if not partitions:
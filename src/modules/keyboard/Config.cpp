@@ -189,6 +189,9 @@ KeyboardVariantsModel::setVariants( QMap< QString, QString > variants )
 /* Returns stringlist with suitable setxkbmap command-line arguments
  * to set the given @p layout and @p variant.
  */
+namespace KeyboardModule
+{
+
 static inline QStringList
 xkbmap_args( const QString& layout, const QString& variant )
 {
@@ -538,3 +541,5 @@ Config::updateVariants( const QPersistentModelIndex& currentItem, QString curren
         }
     }
 }
+
+}  // namespace KeyboardModule
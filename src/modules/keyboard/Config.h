@@ -86,6 +86,9 @@ signals:
     void currentIndexChanged( int index );
 };
 
+namespace KeyboardModule
+{
+
 class Config : public QObject
 {
     Q_OBJECT
@@ -129,5 +132,6 @@ signals:
     void prettyStatusChanged();
 };
 
+}  // namespace KeyboardModule
 
 #endif
@@ -29,11 +29,11 @@ CALAMARES_PLUGIN_FACTORY_DEFINITION( KeyboardViewStepFactory, registerPlugin< Ke
 
 KeyboardViewStep::KeyboardViewStep( QObject* parent )
     : Calamares::ViewStep( parent )
-    , m_widget( new KeyboardPage() )
+    , m_widget( nullptr )
     , m_nextEnabled( false )
     , m_writeEtcDefaultKeyboard( true )
 {
-    m_widget->init();
+    // The page is created when it is first shown, see widget()
     m_nextEnabled = true;
     emit nextStatusChanged( m_nextEnabled );
 }
@@ -65,6 +65,11 @@ KeyboardViewStep::prettyStatus() const
 QWidget*
 KeyboardViewStep::widget()
 {
+    if ( !m_widget )
+    {
+        m_widget = new KeyboardPage();
+        m_widget->init();
+    }
     return m_widget;
 }
 
@@ -107,6 +112,7 @@ KeyboardViewStep::jobs() const
 void
 KeyboardViewStep::onActivate()
 {
+    widget();
     m_widget->onActivate();
 }
 
@@ -114,6 +120,7 @@ KeyboardViewStep::onActivate()
 void
 KeyboardViewStep::onLeave()
 {
+    widget();
     m_widget->finalize();
     m_jobs = m_widget->createJobs( m_xOrgConfFileName, m_convertedKeymapPath, m_writeEtcDefaultKeyboard );
     m_prettyStatus = m_widget->prettyStatus();
@@ -29,12 +29,16 @@
 #include "modulesystem/ModuleManager.h"
 #include "network/Manager.h"
 #include "utils/Logger.h"
+#include "utils/Probe.h"
 #include "utils/Variant.h"
 
 #include <QFile>
 #include <QProcess>
 #include <QTimeZone>
 
+namespace LocaleModule
+{
+
 /** @brief Load supported locale keys
  *
  * If i18n/SUPPORTED exists, read the lines from that and return those
@@ -84,10 +88,7 @@ loadLocales( const QString& localeGenPath )
             cWarning() << "Cannot open file" << localeGenPath
                        << ". Assuming the supported languages are already built into "
                           "the locale archive.";
-            QProcess localeA;
-            localeA.start( "locale", QStringList() << "-a" );
-            localeA.waitForFinished();
-            ba = localeA.readAllStandardOutput();
+            ba = CalamaresUtils::Probe::run( { "locale", "-a" } ).getOutput().toLocal8Bit();
         }
         const auto lines = ba.split( '\n' );
         for ( const QByteArray& line : lines )
@@ -559,3 +560,5 @@ Config::completeGeoIP()
     m_geoipWatcher.reset();
     m_geoip.reset();
 }
+
+}  // namespace LocaleModule
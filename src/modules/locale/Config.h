@@ -33,6 +33,9 @@
 
 #include <memory>
 
+namespace LocaleModule
+{
+
 class Config : public QObject
 {
     Q_OBJECT
@@ -195,5 +198,6 @@ private:
     std::unique_ptr< QFutureWatcher< CalamaresUtils::GeoIP::RegionZonePair > > m_geoipWatcher;
 };
 
+}  // namespace LocaleModule
 
 #endif
@@ -35,6 +35,8 @@
 #include <QPointer>
 #include <QPushButton>
 
+using LocaleModule::Config;
+
 LocalePage::LocalePage( Config* config, QWidget* parent )
     : QWidget( parent )
     , m_config( config )
@@ -33,21 +33,25 @@ class QComboBox;
 class QLabel;
 class QPushButton;
 
+namespace LocaleModule
+{
 class Config;
+}  // namespace LocaleModule
+
 class TimeZoneWidget;
 
 class LocalePage : public QWidget
 {
     Q_OBJECT
 public:
-    explicit LocalePage( class Config* config, QWidget* parent = nullptr );
+    explicit LocalePage( LocaleModule::Config* config, QWidget* parent = nullptr );
     virtual ~LocalePage();
 
     void onActivate();
 
 private:
     /// @brief Non-owning pointer to the ViewStep's config
-    Config* m_config;
+    LocaleModule::Config* m_config;
 
     void updateLocaleLabels();
 
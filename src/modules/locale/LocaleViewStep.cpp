@@ -43,7 +43,7 @@ LocaleViewStep::LocaleViewStep( QObject* parent )
     , m_widget( new QWidget() )
     , m_actualWidget( nullptr )
     , m_nextEnabled( false )
-    , m_config( std::make_unique< Config >() )
+    , m_config( std::make_unique< LocaleModule::Config >() )
 {
     QBoxLayout* mainLayout = new QHBoxLayout;
     m_widget->setLayout( mainLayout );
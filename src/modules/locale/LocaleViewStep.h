@@ -65,7 +65,7 @@ private:
     LocalePage* m_actualWidget;
     bool m_nextEnabled;
 
-    std::unique_ptr< Config > m_config;
+    std::unique_ptr< LocaleModule::Config > m_config;
 };
 
 CALAMARES_PLUGIN_FACTORY_DECLARATION( LocaleViewStepFactory )
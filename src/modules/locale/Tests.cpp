@@ -257,7 +257,7 @@ LocaleTests::testSpecificLocations()
 void
 LocaleTests::testConfigInitialization()
 {
-    Config c;
+    LocaleModule::Config c;
 
     QVERIFY( !c.currentLocation() );
     QVERIFY( !c.currentLocationStatus().isEmpty() );
@@ -143,7 +143,7 @@ def run():
     Mount all the partitions from GlobalStorage and from the job configuration.
     Partitions are mounted in-lexical-order of their mountPoint.
     """
-    partitions = libcalamares.globalstorage.value("partitions")
+    partitions = libcalamares.globalstorage.view("partitions")
 
     if not partitions:
         libcalamares.utils.warning("partitions is empty, {!s}".format(partitions))
@@ -28,6 +28,9 @@
 
 #include <QNetworkReply>
 
+namespace NetInstallModule
+{
+
 Config::Config( QObject* parent )
     : QObject( parent )
     , m_model( new PackageModel( this ) )
@@ -152,3 +155,5 @@ Config::receivedGroupData()
         setStatus( Status::FailedBadData );
     }
 }
+
+}  // namespace NetInstallModule
@@ -28,6 +28,9 @@
 
 class QNetworkReply;
 
+namespace NetInstallModule
+{
+
 class Config : public QObject
 {
     Q_OBJECT
@@ -84,4 +87,6 @@ private:
     bool m_required = false;
 };
 
+}  // namespace NetInstallModule
+
 #endif
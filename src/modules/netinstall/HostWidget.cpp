@@ -10,7 +10,7 @@
 #include <QHBoxLayout>
 #include <QPaintEvent>
 
-HostWidget::HostWidget( Config* config, QWidget* parent )
+HostWidget::HostWidget( NetInstallModule::Config* config, QWidget* parent )
     : QWidget( parent )
     , m_netInstallPage( new NetInstallPage( config ) )
     , m_noNetInstallPage( new NoNetInstallPage() )
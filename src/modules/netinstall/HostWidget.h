@@ -24,7 +24,11 @@
 
 #include <QWidget>
 
+namespace NetInstallModule
+{
 class Config;
+}  // namespace NetInstallModule
+
 class NetInstallPage;
 class NoNetInstallPage;
 
@@ -36,7 +40,7 @@ class HostWidget : public QWidget
     Q_OBJECT
 
 public:
-    HostWidget( Config* config, QWidget* parent = nullptr );
+    HostWidget( NetInstallModule::Config* config, QWidget* parent = nullptr );
 
     void onActivate();
     void setPageTitle( CalamaresUtils::Locale::TranslatedString* title );
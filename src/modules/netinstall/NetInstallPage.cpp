@@ -34,7 +34,7 @@
 #include <QHeaderView>
 #include <QNetworkReply>
 
-NetInstallPage::NetInstallPage( Config* c, QWidget* parent )
+NetInstallPage::NetInstallPage( NetInstallModule::Config* c, QWidget* parent )
     : QWidget( parent )
     , m_config( c )
     , ui( new Ui::Page_NetInst )
@@ -42,8 +42,8 @@ NetInstallPage::NetInstallPage( Config* c, QWidget* parent )
     ui->setupUi( this );
     ui->groupswidget->header()->setSectionResizeMode( QHeaderView::ResizeToContents );
     ui->groupswidget->setModel( c->model() );
-    connect( c, &Config::statusChanged, this, &NetInstallPage::setStatus );
-    connect( c, &Config::statusReady, this, &NetInstallPage::expandGroups );
+    connect( c, &NetInstallModule::Config::statusChanged, this, &NetInstallPage::setStatus );
+    connect( c, &NetInstallModule::Config::statusReady, this, &NetInstallPage::expandGroups );
 
     setPageTitle( nullptr );
     CALAMARES_RETRANSLATE_SLOT( &NetInstallPage::retranslate );
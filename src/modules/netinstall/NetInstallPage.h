@@ -43,7 +43,7 @@ class NetInstallPage : public QWidget
 {
     Q_OBJECT
 public:
-    NetInstallPage( Config* config, QWidget* parent = nullptr );
+    NetInstallPage( NetInstallModule::Config* config, QWidget* parent = nullptr );
     virtual ~NetInstallPage();
 
     /** @brief Sets the page title
@@ -71,7 +71,7 @@ public slots:
     void expandGroups();
 
 private:
-    Config* m_config;
+    NetInstallModule::Config* m_config;
     Ui::Page_NetInst* ui;
 
     std::unique_ptr< CalamaresUtils::Locale::TranslatedString > m_title;  // Above the treeview
@@ -36,7 +36,7 @@ NetInstallViewStep::NetInstallViewStep( QObject* parent )
     , m_sidebarLabel( nullptr )
     , m_nextEnabled( false )
 {
-    connect( &m_config, &Config::statusReady, this, &NetInstallViewStep::nextIsReady );
+    connect( &m_config, &NetInstallModule::Config::statusReady, this, &NetInstallViewStep::nextIsReady );
 }
 
 
@@ -64,7 +64,7 @@ public slots:
     void nextIsReady();
 
 private:
-    Config m_config;
+    NetInstallModule::Config m_config;
 
     HostWidget* m_widget;
     CalamaresUtils::Locale::TranslatedString* m_sidebarLabel;  // As it appears in the sidebar
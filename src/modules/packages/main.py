@@ -578,6 +578,7 @@ def run():
         # Avoids potential divide-by-zero in progress reporting
         libcalamares.utils.debug("No package to process")
         return None
+    libcalamares.job.set_work_size(total_packages)
 
     libcalamares.job.setprogress(0.0)
     libcalamares.utils.debug(
@@ -588,6 +589,8 @@ def run():
     )
 
     for entry in operations:
+        if libcalamares.job.is_cancelled():
+            return (_("Package installation was cancelled."), "")
         libcalamares.utils.debug(pretty_name())
         run_operations(pkgman, entry)
 
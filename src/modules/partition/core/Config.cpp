@@ -14,6 +14,9 @@
 #include "utils/Logger.h"
 #include "utils/Variant.h"
 
+namespace PartitionModule
+{
+
 Config::Config( QObject* parent )
     : QObject( parent )
 {
@@ -181,7 +184,7 @@ Config::setInstallChoice( InstallChoice c )
     {
         m_installChoice = c;
         emit installChoiceChanged( c );
-        ::updateGlobalStorage( c, m_swapChoice );
+        PartitionModule::updateGlobalStorage( c, m_swapChoice );
     }
 }
 
@@ -203,7 +206,7 @@ Config::setSwapChoice( Config::SwapChoice c )
     {
         m_swapChoice = c;
         emit swapChoiceChanged( c );
-        ::updateGlobalStorage( m_installChoice, c );
+        PartitionModule::updateGlobalStorage( m_installChoice, c );
     }
 }
 
@@ -266,3 +269,5 @@ Config::updateGlobalStorage() const
         gs->insert( "requiredStorageGiB", m_requiredStorageGiB );
     }
 }
+
+}  // namespace PartitionModule
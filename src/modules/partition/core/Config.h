@@ -15,6 +15,9 @@
 #include <QObject>
 #include <QSet>
 
+namespace PartitionModule
+{
+
 class Config : public QObject
 {
     Q_OBJECT
@@ -125,5 +128,6 @@ private:
  */
 Config::SwapChoice pickOne( const Config::SwapChoiceSet& s );
 
+}  // namespace PartitionModule
 
 #endif
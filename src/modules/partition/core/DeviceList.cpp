@@ -18,13 +18,13 @@
 #include "JobQueue.h"
 #include "partition/PartitionIterator.h"
 #include "utils/Logger.h"
+#include "utils/Probe.h"
 
 #include <kpmcore/backend/corebackend.h>
 #include <kpmcore/backend/corebackendmanager.h>
 #include <kpmcore/core/device.h>
 #include <kpmcore/core/partition.h>
 
-#include <QProcess>
 #include <QTemporaryDir>
 
 using CalamaresUtils::Partition::PartitionIterator;
@@ -50,11 +50,7 @@ hasRootPartition( Device* device )
 static bool
 blkIdCheckIso9660( const QString& path )
 {
-    QProcess blkid;
-    blkid.start( "blkid", { path } );
-    blkid.waitForFinished();
-    QString output = QString::fromLocal8Bit( blkid.readAllStandardOutput() );
-    return output.contains( "iso9660" );
+    return CalamaresUtils::Probe::run( { "blkid", path } ).getOutput().contains( "iso9660" );
 }
 
 static bool
@@ -33,6 +33,7 @@ namespace PartitionActions
 {
 using CalamaresUtils::operator""_GiB;
 using CalamaresUtils::operator""_MiB;
+using PartitionModule::Config;
 
 qint64
 swapSuggestion( const qint64 availableSpaceB, Config::SwapChoice swap )
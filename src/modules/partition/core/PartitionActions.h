@@ -45,14 +45,14 @@ struct AutoPartitionOptions : ReplacePartitionOptions
 {
     QString efiPartitionMountPoint;  // optional, e.g. "/boot"
     quint64 requiredSpaceB;  // estimated required space for root partition
-    Config::SwapChoice swap;
+    PartitionModule::Config::SwapChoice swap;
 
     AutoPartitionOptions( const QString& pt,
                           const QString& fs,
                           const QString& luks,
                           const QString& efi,
                           qint64 requiredBytes,
-                          Config::SwapChoice s )
+                          PartitionModule::Config::SwapChoice s )
         : ReplacePartitionOptions( pt, fs, luks )
         , efiPartitionMountPoint( efi )
         , requiredSpaceB( requiredBytes > 0 ? static_cast< quint64 >( requiredBytes ) : 0 )
@@ -41,6 +41,7 @@
 #include "partition/PartitionIterator.h"
 #include "partition/PartitionQuery.h"
 #include "utils/Logger.h"
+#include "utils/Probe.h"
 #include "utils/Traits.h"
 #include "utils/Variant.h"
 
@@ -561,7 +562,7 @@ PartitionCoreModule::setPartitionFlags( Device* device, Partition* partition, Pa
 }
 
 Calamares::JobList
-PartitionCoreModule::jobs( const Config* config ) const
+PartitionCoreModule::jobs( const PartitionModule::Config* config ) const
 {
     Calamares::JobList lst;
     QList< Device* > devices;
@@ -994,6 +995,7 @@ PartitionCoreModule::revert()
     QMutexLocker locker( &m_revertMutex );
     qDeleteAll( m_deviceInfos );
     m_deviceInfos.clear();
+    CalamaresUtils::Probe::invalidate();
     doInit();
     updateIsDirty();
     emit reverted();
@@ -1048,6 +1050,7 @@ PartitionCoreModule::revertDevice( Device* dev, bool individualRevert )
         return;
     }
     devInfo->forgetChanges();
+    CalamaresUtils::Probe::invalidate( devInfo->device->deviceNode() );
     CoreBackend* backend = CoreBackendManager::self()->backend();
     Device* newDev = backend->scanDevice( devInfo->device->deviceNode() );
     devInfo->device.reset( newDev );
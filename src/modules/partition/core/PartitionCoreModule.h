@@ -32,7 +32,12 @@
 #include <functional>
 
 class BootLoaderModel;
+
+namespace PartitionModule
+{
 class Config;
+}  // namespace PartitionModule
+
 class CreatePartitionJob;
 class Device;
 class DeviceModel;
@@ -172,7 +177,7 @@ public:
      * requested by the user.
      * @return a list of jobs.
      */
-    Calamares::JobList jobs( const Config* ) const;
+    Calamares::JobList jobs( const PartitionModule::Config* ) const;
 
     bool hasRootMountPoint() const;
 
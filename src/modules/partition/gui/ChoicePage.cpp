@@ -59,6 +59,7 @@ using Calamares::PrettyRadioButton;
 using CalamaresUtils::Partition::findPartitionByPath;
 using CalamaresUtils::Partition::isPartitionFreeSpace;
 using CalamaresUtils::Partition::PartitionIterator;
+using PartitionModule::Config;
 using InstallChoice = Config::InstallChoice;
 using SwapChoice = Config::SwapChoice;
 
@@ -33,7 +33,11 @@ namespace Calamares
 class PrettyRadioButton;
 }
 
+namespace PartitionModule
+{
 class Config;
+}  // namespace PartitionModule
+
 class DeviceInfoWidget;
 class PartitionBarsView;
 class PartitionSplitterWidget;
@@ -42,7 +46,7 @@ class PartitionCoreModule;
 
 class Device;
 
-using SwapChoiceSet = Config::SwapChoiceSet;
+using SwapChoiceSet = PartitionModule::Config::SwapChoiceSet;
 
 /**
  * @brief The ChoicePage class is the first page of the partitioning interface.
@@ -53,7 +57,7 @@ class ChoicePage : public QWidget, private Ui::ChoicePage
 {
     Q_OBJECT
 public:
-    explicit ChoicePage( Config* config, QWidget* parent = nullptr );
+    explicit ChoicePage( PartitionModule::Config* config, QWidget* parent = nullptr );
     virtual ~ChoicePage();
 
     /**
@@ -79,7 +83,7 @@ public:
      * @brief applyActionChoice reacts to a choice of partitioning mode.
      * @param choice the partitioning action choice.
      */
-    void applyActionChoice( Config::InstallChoice choice );
+    void applyActionChoice( PartitionModule::Config::InstallChoice choice );
 
     int lastSelectedDeviceIndex();
     void setLastSelectedDeviceIndex( int index );
@@ -105,7 +109,7 @@ private:
     bool calculateNextEnabled() const;
     void updateNextEnabled();
     void setupChoices();
-    void checkInstallChoiceRadioButton( Config::InstallChoice choice );  ///< Sets the chosen button to "on"
+    void checkInstallChoiceRadioButton( PartitionModule::Config::InstallChoice choice );  ///< Sets the chosen button to "on"
     QComboBox* createBootloaderComboBox( QWidget* parentButton );
     Device* selectedDevice();
 
@@ -115,7 +119,7 @@ private:
     void continueApplyDeviceChoice();  // .. called after scan
 
     void updateDeviceStatePreview();
-    void updateActionChoicePreview( Config::InstallChoice choice );
+    void updateActionChoicePreview( PartitionModule::Config::InstallChoice choice );
     void setupActions();
     OsproberEntryList getOsproberEntriesForDevice( Device* device ) const;
     void doAlongsideApply();
@@ -124,7 +128,7 @@ private:
     // Translations support
     void updateSwapChoicesTr( QComboBox* box );
 
-    Config* m_config;
+    PartitionModule::Config* m_config;
     bool m_nextEnabled;
     PartitionCoreModule* m_core;
 
@@ -54,6 +54,8 @@
 #include <QTimer>
 #include <QtConcurrent/QtConcurrent>
 
+using PartitionModule::Config;
+
 PartitionViewStep::PartitionViewStep( QObject* parent )
     : Calamares::ViewStep( parent )
     , m_config( new Config( this ) )
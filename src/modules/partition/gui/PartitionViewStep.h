@@ -21,7 +21,12 @@
 #include <QSet>
 
 class ChoicePage;
+
+namespace PartitionModule
+{
 class Config;
+}  // namespace PartitionModule
+
 class PartitionPage;
 class PartitionCoreModule;
 class QStackedWidget;
@@ -72,7 +77,7 @@ private:
     /// "slot" for changes to next-status from the KPMCore and ChoicePage
     void nextPossiblyChanged( bool );
 
-    Config* m_config;
+    PartitionModule::Config* m_config;
 
     PartitionCoreModule* m_core;
     QStackedWidget* m_widget;
@@ -126,7 +126,7 @@ mapForPartition( Partition* partition, const QString& uuid )
     return map;
 }
 
-FillGlobalStorageJob::FillGlobalStorageJob( const Config*, QList< Device* > devices, const QString& bootLoaderPath )
+FillGlobalStorageJob::FillGlobalStorageJob( const PartitionModule::Config*, QList< Device* > devices, const QString& bootLoaderPath )
     : m_devices( devices )
     , m_bootLoaderPath( bootLoaderPath )
 {
@@ -218,7 +218,7 @@ FillGlobalStorageJob::prettyStatusMessage() const
  * Stores a GS key called "filesystems_use" with this mapping.
  */
 static void
-storeFSUse( Calamares::GlobalStorage* storage, const QVariantList& partitions )
+storeFSUse( Calamares::GlobalStorage::Batch& storage, const QVariantList& partitions )
 {
     QMap< QString, int > fsUses;
     for ( const auto& p : partitions )
@@ -243,16 +243,17 @@ storeFSUse( Calamares::GlobalStorage* storage, const QVariantList& partitions )
         fsUsesVariant.insert( it.key(), it.value() );
     }
 
-    storage->insert( "filesystems_use", fsUsesVariant );
+    storage.insert( "filesystems_use", fsUsesVariant );
 }
 
 Calamares::JobResult
 FillGlobalStorageJob::exec()
 {
-    Calamares::GlobalStorage* storage = Calamares::JobQueue::instance()->globalStorage();
+    // All the keys are changed at once, so that listeners see a consistent partitioning
+    Calamares::GlobalStorage::Batch storage( Calamares::JobQueue::instance()->globalStorage() );
     const auto partitions = createPartitionList();
     cDebug() << "Saving partition information map to GlobalStorage[\"partitions\"]";
-    storage->insert( "partitions", partitions );
+    storage.insert( "partitions", partitions );
     storeFSUse( storage, partitions );
 
     if ( !m_bootLoaderPath.isEmpty() )
@@ -263,12 +264,12 @@ FillGlobalStorageJob::exec()
             cDebug() << "Failed to find path for boot loader";
         }
         cDebug() << "FillGlobalStorageJob writing bootLoader path:" << var;
-        storage->insert( "bootLoader", var );
+        storage.insert( "bootLoader", var );
     }
     else
     {
         cDebug() << "FillGlobalStorageJob writing empty bootLoader value";
-        storage->insert( "bootLoader", QVariant() );
+        storage.insert( "bootLoader", QVariant() );
     }
     return Calamares::JobResult::ok();
 }
@@ -16,7 +16,11 @@
 #include <QList>
 #include <QVariantList>
 
+namespace PartitionModule
+{
 class Config;
+}  // namespace PartitionModule
+
 class Device;
 class Partition;
 
@@ -31,7 +35,7 @@ class FillGlobalStorageJob : public Calamares::Job
 {
     Q_OBJECT
 public:
-    FillGlobalStorageJob( const Config* config, QList< Device* > devices, const QString& bootLoaderPath );
+    FillGlobalStorageJob( const PartitionModule::Config* config, QList< Device* > devices, const QString& bootLoaderPath );
 
     QString prettyName() const override;
     QString prettyDescription() const override;
@@ -61,6 +61,13 @@ ShellProcessJob::exec()
 }
 
 
+qint64
+ShellProcessJob::workSize() const
+{
+    return m_commands ? m_commands->count() : 0;
+}
+
+
 void
 ShellProcessJob::setConfigurationMap( const QVariantMap& configurationMap )
 {
@@ -41,6 +41,7 @@ public:
     QString prettyName() const override;
 
     Calamares::JobResult exec() override;
+    qint64 workSize() const override;
 
     void setConfigurationMap( const QVariantMap& configurationMap ) override;
 
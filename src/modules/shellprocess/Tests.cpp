@@ -28,8 +28,13 @@
 
 #include <QtTest/QtTest>
 
+#include <QElapsedTimer>
+#include <QFile>
 #include <QFileInfo>
 #include <QStringList>
+#include <QThread>
+
+#include <thread>
 
 QTEST_GUILESS_MAIN( ShellProcessTests )
 
@@ -208,3 +213,74 @@ script:
     gs->insert( "username", "`id -u`" );
     QVERIFY( bool( CommandList( userScript, false, 10s ).run() ) );
 }
+
+void
+ShellProcessTests::testParallelGroups()
+{
+    YAML::Node doc = YAML::Load( R"(---
+script:
+    - "ls /tmp"
+    - parallel:
+        - "sleep 1"
+        - command: "sleep 1"
+          timeout: 5
+        - "-/bin/false"
+      jobs: 3
+    - parallel: "ls /tmp"
+    - parallel:
+        - parallel: [ "ls" ]
+)" );
+    CommandList cl( CalamaresUtils::yamlMapToVariant( doc ).value( "script" ), false );
+    QCOMPARE( cl.count(), 5 );  // The nested group is ignored
+    QCOMPARE( cl.at( 0 ).group(), 0 );
+    QCOMPARE( cl.at( 1 ).group(), 1 );
+    QCOMPARE( cl.at( 2 ).group(), 1 );
+    QCOMPARE( cl.at( 2 ).timeout(), 5s );
+    QCOMPARE( cl.at( 3 ).group(), 1 );
+    QCOMPARE( cl.at( 4 ).group(), 2 );
+    QCOMPARE( cl.groupJobs( 1 ), 3 );
+    QCOMPARE( cl.groupJobs( 2 ), QThread::idealThreadCount() );
+
+    if ( !Calamares::JobQueue::instance() )
+        (void)new Calamares::JobQueue( nullptr );
+
+    // The sleeps run at the same time; the suppressed failure is ignored
+    QElapsedTimer timer;
+    timer.start();
+    QVERIFY( bool( cl.run() ) );
+    QVERIFY( timer.elapsed() < 1900 );
+
+    // A failure in a group fails the list, after the group
+    doc = YAML::Load( R"(---
+script:
+    - parallel:
+        - "/bin/true"
+        - "/bin/false"
+    - "touch /tmp/calamares-never-created"
+)" );
+    QFile::remove( "/tmp/calamares-never-created" );
+    QVERIFY( !bool( CommandList( CalamaresUtils::yamlMapToVariant( doc ).value( "script" ), false ).run() ) );
+    QVERIFY( !QFile::exists( "/tmp/calamares-never-created" ) );
+
+    // Cancelling the job that runs the list kills the commands of a group
+    doc = YAML::Load( R"(---
+script:
+    - parallel:
+        - "sleep 10"
+        - "sleep 10"
+)" );
+    CommandList sleepers( CalamaresUtils::yamlMapToVariant( doc ).value( "script" ), false );
+    Calamares::CancellationToken token;
+    bool ok = true;
+    timer.restart();
+    std::thread runner( [ & ]() {
+        Calamares::CancellationToken::setCurrent( &token );
+        ok = bool( sleepers.run() );
+        Calamares::CancellationToken::setCurrent( nullptr );
+    } );
+    QThread::msleep( 200 );
+    token.cancel();
+    runner.join();
+    QVERIFY( !ok );
+    QVERIFY( timer.elapsed() < 9000 );
+}
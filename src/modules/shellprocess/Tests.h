@@ -42,6 +42,8 @@ private Q_SLOTS:
     void testProcessListFromObject();
     // Check @@ROOT@@ substitution
     void testRootSubstitution();
+    // Create and run parallel groups
+    void testParallelGroups();
 };
 
 #endif
@@ -207,6 +207,11 @@ def file_copy(source, entry, progress_cb):
         file_count_chunk = 100
 
     for line in iter(process.stdout.readline, b''):
+        if job.is_cancelled():
+            process.terminate()
+            process.wait()
+            return _("The installation was cancelled.")
+
         # rsync outputs progress in parentheses. Each line will have an
         # xfer and a chk item (either ir-chk or to-chk) as follows:
         #
@@ -311,13 +316,19 @@ class UnpackOperation:
         global status
         source_mount_path = tempfile.mkdtemp()
 
+        # Filled in by prepare(), if it got to it
+        prepared_counts = globalstorage.value("unpackfsFileCounts") or dict()
+
         try:
             complete = 0
             for entry in self.entries:
                 status = _("Starting to unpack {}").format(entry.source)
                 job.setprogress( ( 1.0 * complete ) / len(self.entries) )
                 entry.do_mount(source_mount_path)
-                entry.do_count()  # Fill in the entry.total
+                if entry.source in prepared_counts:
+                    entry.total = prepared_counts[entry.source]
+                else:
+                    entry.do_count()  # Fill in the entry.total
 
                 self.report_progress()
                 error_msg = self.unpack_image(entry, entry.mountPoint)
@@ -404,6 +415,39 @@ def repair_root_permissions(root_mount_point):
             # But ignore it
 
 
+def prepare():
+    """
+    Count the files in the images while the user is busy with the
+    rest of Calamares, so that run() does not have to. This does
+    not need the target system, so only images that do not need to
+    be mounted are counted.
+    """
+    counts = dict()
+    all_counted = True
+    for entry in job.configuration["unpack"]:
+        if job.is_cancelled():
+            return None
+
+        source = os.path.abspath(entry["source"])
+        sourcefs = entry["sourcefs"]
+        if not os.path.exists(source):
+            all_counted = False
+            continue
+        if sourcefs == "squashfs" and shutil.which("unsquashfs") is None:
+            all_counted = False
+            continue
+        if sourcefs in ("squashfs", "file"):
+            counts[source] = UnpackEntry(source, sourcefs, "").do_count()
+        else:
+            all_counted = False
+
+    globalstorage.insert("unpackfsFileCounts", counts)
+    # A partial count would not be comparable between runs
+    if all_counted:
+        job.set_work_size(sum(counts.values()))
+    return None
+
+
 def run():
     """
     Unsquash filesystem.
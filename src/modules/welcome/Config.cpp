@@ -29,6 +29,9 @@
 
 #include <QFutureWatcher>
 
+namespace WelcomeModule
+{
+
 Config::Config( QObject* parent )
     : QObject( parent )
     , m_languages( CalamaresUtils::Locale::availableTranslations() )
@@ -366,7 +369,7 @@ setGeoIP( Config* config, const QVariantMap& configurationMap )
             QObject::connect( future, &FWString::finished, [config, future, handler]() {
                 QString countryResult = future->future().result();
                 cDebug() << "GeoIP result for welcome=" << countryResult;
-                ::setCountry( config, countryResult, handler );
+                WelcomeModule::setCountry( config, countryResult, handler );
                 future->deleteLater();
                 delete handler;
             } );
@@ -390,6 +393,8 @@ Config::setConfigurationMap( const QVariantMap& configurationMap )
     setReleaseNotesUrl( jobOrBrandingSetting( Branding::ReleaseNotesUrl, configurationMap, "showReleaseNotesUrl" ) );
     setDonateUrl( jobOrBrandingSetting( Branding::DonateUrl, configurationMap, "showDonateUrl" ) );
 
-    ::setLanguageIcon( this, configurationMap );
-    ::setGeoIP( this, configurationMap );
+    WelcomeModule::setLanguageIcon( this, configurationMap );
+    WelcomeModule::setGeoIP( this, configurationMap );
 }
+
+}  // namespace WelcomeModule
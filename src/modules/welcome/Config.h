@@ -28,6 +28,9 @@
 
 #include <memory>
 
+namespace WelcomeModule
+{
+
 class Config : public QObject
 {
     Q_OBJECT
@@ -142,4 +145,6 @@ private:
     QString m_donateUrl;
 };
 
+}  // namespace WelcomeModule
+
 #endif
@@ -45,7 +45,7 @@
 #include <QLabel>
 #include <QMessageBox>
 
-WelcomePage::WelcomePage( Config* conf, QWidget* parent )
+WelcomePage::WelcomePage( WelcomeModule::Config* conf, QWidget* parent )
     : QWidget( parent )
     , ui( new Ui::WelcomePage )
     , m_checkingWidget( new CheckerContainer( *(conf->requirementsModel()), this ) )
@@ -129,7 +129,7 @@ WelcomePage::initLanguages()
     connect( ui->languageWidget,
              static_cast< void ( QComboBox::* )( int ) >( &QComboBox::currentIndexChanged ),
              m_conf,
-             &Config::setLocaleIndex );
+             &WelcomeModule::Config::setLocaleIndex );
 }
 
 void
@@ -31,12 +31,17 @@ class WelcomePage;
 }
 
 class CheckerContainer;
+
+namespace WelcomeModule
+{
 class Config;
+}  // namespace WelcomeModule
+
 class WelcomePage : public QWidget
 {
     Q_OBJECT
 public:
-    explicit WelcomePage( Config* conf, QWidget* parent = nullptr );
+    explicit WelcomePage( WelcomeModule::Config* conf, QWidget* parent = nullptr );
 
     enum class Button
     {
@@ -75,7 +80,7 @@ private:
     CheckerContainer* m_checkingWidget;
     CalamaresUtils::Locale::LabelModel* m_languages;
 
-    Config* m_conf;
+    WelcomeModule::Config* m_conf;
 };
 
 /** @brief Delegate to display language information in two columns.
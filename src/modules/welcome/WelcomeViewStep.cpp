@@ -32,7 +32,7 @@ CALAMARES_PLUGIN_FACTORY_DEFINITION( WelcomeViewStepFactory, registerPlugin< Wel
 
 WelcomeViewStep::WelcomeViewStep( QObject* parent )
     : Calamares::ViewStep( parent )
-    , m_conf( new Config( this ) )
+    , m_conf( new WelcomeModule::Config( this ) )
     , m_widget( new WelcomePage( m_conf ) )
     , m_requirementsChecker( new GeneralRequirements( this ) )
 {
@@ -40,7 +40,7 @@ WelcomeViewStep::WelcomeViewStep( QObject* parent )
              &Calamares::ModuleManager::requirementsComplete,
              this,
              &WelcomeViewStep::nextStatusChanged );
-    connect( m_conf, &Config::localeIndexChanged, m_widget, &WelcomePage::externallySelectedLanguage );
+    connect( m_conf, &WelcomeModule::Config::localeIndexChanged, m_widget, &WelcomePage::externallySelectedLanguage );
 }
 
 WelcomeViewStep::~WelcomeViewStep()
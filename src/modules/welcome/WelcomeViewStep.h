@@ -30,7 +30,11 @@
 
 class WelcomePage;
 class GeneralRequirements;
+
+namespace WelcomeModule
+{
 class Config;
+}  // namespace WelcomeModule
 
 namespace CalamaresUtils
 {
@@ -73,7 +77,7 @@ public:
     Calamares::RequirementsList checkRequirements() override;
 
 private:
-    Config* m_conf;
+    WelcomeModule::Config* m_conf;
     WelcomePage* m_widget;
     GeneralRequirements* m_requirementsChecker;
 };